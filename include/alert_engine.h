@@ -0,0 +1,124 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+
+struct DisplayInfo;
+
+// An alert currently firing, for the UI
+struct ActiveAlert {
+    std::string rule;
+    std::string instance;       // "gpu0:NVIDIA ...", model name, endpoint, "host", "ollama"
+    double value = 0.0;         // Metric value that fired (first condition)
+    int64_t since = 0;          // Unix time the alert fired
+};
+
+// Alert rules loaded from a file (--alerts), one per line:
+//
+//   name: <condition> [and <condition>...] [for <duration>] => <action>
+//   condition: scope[filter].metric [<op> <value> [clear <value>]]
+//
+// e.g.  vram: gpu.vram_percent > 95 clear 90 for 30s => exec notify-send "$ALERT_INSTANCE"
+//       offload: model.offloaded => log /var/log/ollama-alerts.log
+//       slow: endpoint[/api/chat].p99_ms > 2s for 1m => none
+//
+// Rules are compiled once into per-scope lists: scopes no rule uses are
+// not sampled, and the one costly metric (expires_in_s, a timestamp parse)
+// is computed only when a rule reads it. Each sample updates per-instance state: a rule
+// fires after its conditions held for the whole `for` window and resolves
+// only once a condition fails its `clear` threshold (default: the firing
+// threshold), so values hovering at the edge don't flap. Every episode
+// notifies once when it fires and once when it resolves. Actions run on a
+// worker thread; a full queue drops jobs rather than stall collection.
+class AlertEngine {
+public:
+    AlertEngine();
+    ~AlertEngine();
+
+    AlertEngine(const AlertEngine&) = delete;
+    AlertEngine& operator=(const AlertEngine&) = delete;
+
+    // Parse and compile; on failure error names the line and problem
+    bool load(const std::string& path, std::string& error);
+    size_t ruleCount() const { return rules_.size(); }
+
+    // Evaluate one collection; returns the alerts firing afterwards
+    std::vector<ActiveAlert> evaluate(const DisplayInfo& info);
+
+    uint64_t droppedActions() const;
+
+private:
+    enum class Scope { Gpu, Model, Endpoint, Host, Ollama, Count };
+    enum class Op { Gt, Ge, Lt, Le, Eq, Ne, Truthy };
+    enum class ActionKind { None, Exec, Log };
+
+    struct Condition {
+        int metric = 0;
+        Op op = Op::Truthy;
+        double threshold = 0.0;
+        double clear = 0.0;     // Resolve once the value fails op against this
+    };
+
+    struct Rule {
+        std::string name;
+        Scope scope = Scope::Gpu;
+        std::string filter;     // Substring of the instance name; empty = all
+        std::vector<Condition> conditions;
+        std::chrono::milliseconds hold{0};
+        ActionKind action = ActionKind::None;
+        std::string target;     // Command or log path
+    };
+
+    struct State {
+        size_t rule = 0;
+        std::string instance;
+        std::chrono::steady_clock::time_point pending_since{};
+        bool pending = false;
+        bool firing = false;
+        int64_t fired_at = 0;
+        double value = 0.0;
+        uint64_t seen = 0;      // Generation of the last sample that had this instance
+    };
+
+    struct Job {
+        ActionKind kind = ActionKind::None;
+        std::string target;
+        std::string rule;
+        std::string instance;
+        std::string state;      // "firing" or "resolved"
+        double value = 0.0;
+        double threshold = 0.0;
+        int64_t time = 0;
+    };
+
+    std::vector<Rule> rules_;
+    // The plan: rule indices and the metrics they read, per scope
+    std::vector<size_t> rules_by_scope_[static_cast<size_t>(Scope::Count)];
+    uint64_t metrics_by_scope_[static_cast<size_t>(Scope::Count)] = {};
+
+    std::unordered_map<std::string, State> states_;  // rule index + instance
+    uint64_t generation_ = 0;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Job> jobs_;
+    uint64_t dropped_ = 0;
+    bool stopping_ = false;
+    std::thread worker_;
+
+    bool parseRule(std::string_view line, Rule& rule, std::string& error);
+    void evaluateInstance(Scope scope, const std::string& instance, const double* values,
+                          std::chrono::steady_clock::time_point now, int64_t unix_now);
+    void notify(const Rule& rule, const State& state, bool firing, int64_t unix_now);
+    void workerLoop();
+    // Hooks still running at deadline are killed
+    static void runJob(const Job& job, std::chrono::steady_clock::time_point deadline);
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <chrono>
+#include <cstdint>
+#include "event_loop.h"
+
+// Decides when the installed-model catalog (/api/tags) needs fetching again.
+// Pulls, creates, copies and deletes all write manifests under
+// <models dir>/manifests/<registry>/<namespace>/<model>/<tag>, so that tree
+// is watched with inotify (every directory, new ones as they appear) and a
+// burst of manifest writes becomes one refresh once it has been quiet for
+// kDebounce. Without a watchable tree (remote server, permissions, no
+// inotify) the catalog is polled slowly instead, and the watch is retried
+// on each poll. Linux only; elsewhere it always polls.
+class CatalogWatcher {
+public:
+    explicit CatalogWatcher(const std::string& models_dir);
+    ~CatalogWatcher();
+
+    CatalogWatcher(const CatalogWatcher&) = delete;
+    CatalogWatcher& operator=(const CatalogWatcher&) = delete;
+
+    // Register with the loop; false if falling back to polling
+    bool start(EventLoop& loop);
+    bool watching() const { return inotify_fd_ >= 0; }
+
+    // Whether to fetch /api/tags on this refresh; true marks the request, so
+    // call it only when the fetch will start. Report the outcome with
+    // refreshed() (a failed fetch is retried on the next refresh); changes
+    // seen while the fetch is out are kept for the next one.
+    bool refreshDue();
+    void refreshed(bool ok);
+
+    // Force a fetch on the next refresh (server came back)
+    void invalidate();
+
+private:
+    std::string root_;              // <models dir>/manifests
+    EventLoop* loop_ = nullptr;
+    int inotify_fd_ = -1;
+    int root_wd_ = -1;
+    std::unordered_map<int, std::string> dirs_;    // Watch descriptor -> directory
+
+    bool fetched_ = false;          // The last fetch succeeded
+    bool changed_ = false;          // A manifest changed since then
+    std::chrono::steady_clock::time_point last_change_{};
+    std::chrono::steady_clock::time_point last_fetch_{};
+    std::chrono::steady_clock::time_point last_attempt_{};     // Watch setup
+    uint64_t generation_ = 0;               // Bumped per change batch and invalidate()
+    uint64_t invalidated_generation_ = 0;
+    uint64_t requested_generation_ = 0;     // As of the fetch in flight
+    std::chrono::steady_clock::time_point requested_at_{};
+
+    bool due(std::chrono::steady_clock::time_point now);
+    bool watch();
+    void unwatch();
+    void addTree(const std::string& dir);
+    void onInotify();
+};
@@ -2,16 +2,60 @@
 
 #include <string>
 #include <vector>
+#include <memory>
+#include <unordered_map>
 #include "ollama_client.h"
 #include "gpu_monitor.h"
+#include "host_monitor.h"
+#include "log_tailer.h"
+#include "model_store.h"
+#include "energy_meter.h"
+#include "fleet_aggregator.h"
+#include "alert_engine.h"
+#include "placement.h"
+#include "model_keeper.h"
+#include "metrics_scraper.h"
+#include "frame_buffer.h"
+#include "gpu_topology.h"
 
 struct DisplayInfo {
     std::vector<GPUInfo> gpu_infos;
+    HostInfo host_info;
     std::unique_ptr<OllamaStatus> ollama_status;
     std::vector<OllamaModel> available_models;
+    // Ollama data is the last known state (server unreachable or not probed yet)
+    bool stale = false;
+    int64_t stale_since = 0;  // Unix time that state was collected
+    // /api/show metadata by digest; models still being fetched are absent
+    std::unordered_map<std::string, std::shared_ptr<const ModelMetadata>> model_metadata;
+    ModelStoreInfo model_store;  // Blob sizes and page-cache residency
+    LogStats log_stats;  // Inactive unless --log was given
+    EnergyInfo energy;   // Integrated GPU power, attributed to models
+    std::vector<ActiveAlert> alerts;  // Firing --alerts rules
+    std::vector<Placement> placements;  // Per available model; empty without GPUs
+    std::string plan_input;             // What-if query being typed ('p')
+    bool plan_editing = false;
+    std::vector<PlannedModel> plan;     // Result of the last query, loaded in order
+    KeeperInfo keeper;                  // Inactive unless --keep was given
+    std::vector<EngineStats> engines;   // Co-located engines (--scrape)
+    std::shared_ptr<const GPUTopology> gpu_topology;  // Null until discovered
+    std::vector<TopologyWarning> topology_warnings;   // Placement problems
     std::string current_time;
 };
 
+// What the GPU heatmap is colored by ('m' cycles)
+enum class HeatMetric { Vram, Util, Temp, Power, Count };
+
+enum class FleetLayout { Auto, Table, Heatmap };
+
+// Fleet view navigation, driven by the key handler ('v', arrows, Enter, Esc)
+struct FleetView {
+    FleetLayout layout = FleetLayout::Auto;  // Auto: heatmap once the table doesn't fit
+    size_t node = 0;                         // Heatmap cursor, in nodes() order
+    size_t gpu = 0;
+    bool detail = false;                     // Detailed view of the cursor's node
+};
+
 class ConsoleUI {
 public:
     ConsoleUI();
@@ -21,22 +65,78 @@ public:
     void clearToEndOfScreen();
     void clearLine();
     void display(const DisplayInfo& info);
+    void displayFleet(const std::vector<FleetNode>& nodes, int port, const FleetView& view);  // --aggregator
+    void printPlan(const std::vector<PlannedModel>& plan);             // --plan
     void refreshRate(int seconds) { refresh_rate_ = seconds; }
     void setNoClear(bool no_clear) { no_clear_ = no_clear; }
+    void cycleHeatMetric();
+    void toggleTopology() { topology_shown_ = !topology_shown_; }
+    bool fleetHeatmapShown() const { return fleet_heatmap_; }
+    
+    // Re-read the terminal size (SIGWINCH); the next frame is drawn in full
+    void updateTerminalSize();
+    
+    // Unbuffered, non-echoing key input on a terminal (restored on exit)
+    bool enableKeyboardInput();
+    int keyboardFd() const;
+    int readKey();  // Next pending key, or -1 if none
+    
+    // readKey() codes for the arrow keys
+    static constexpr int kKeyUp = 0x100;
+    static constexpr int kKeyDown = 0x101;
+    static constexpr int kKeyRight = 0x102;
+    static constexpr int kKeyLeft = 0x103;
 
 private:
     int refresh_rate_;
     bool no_clear_ = false;
+    bool keyboard_enabled_ = false;
+    int rows_ = 0;  // Terminal size, 0 if not a terminal
+    int cols_ = 0;
+    HeatMetric heat_metric_ = HeatMetric::Vram;
+    bool gpu_heatmap_ = false;    // The frame being composed shows the GPU heatmap
+    bool fleet_heatmap_ = false;  // The last fleet frame was the heatmap
+    bool topology_shown_ = false; // GPU peer matrix ('t'); warnings always show
+    FrameBuffer frame_;  // Frame being composed
+    
+    // Previous frame as the terminal shows it; only changed lines are sent
+    FrameBuffer out_;
+    std::string shown_;
+    std::vector<size_t> shown_lines_;  // Line start offsets
+    std::vector<size_t> lines_;
+    bool full_redraw_ = true;
+    bool wrap_disabled_ = false;
+    std::vector<GPUInfo> node_gpus_;  // Fleet detail view, reused
     
-    // Helper methods for formatting
-    std::string formatBytes(int64_t bytes) const;
-    std::string formatTimeUntil(const std::string& expires_at) const;
-    std::string truncateString(const std::string& str, size_t max_length) const;
-    std::string getCurrentTime() const;
-    std::string getProgressBar(double percentage, int width = 20) const;
+    // Helper methods for formatting (append to frame_)
+    void appendTimeUntil(const std::string& expires_at);
+    void appendCurrentTime();
+    void appendLatency(double ms);
+    void appendEnergy(double joules);
+    bool appendThrottleReasons(uint64_t reasons);
+    void appendPlacement(const Placement& placement, bool verbose);
     
-    void displayGPUInfo(const std::vector<GPUInfo>& gpu_infos);
-    void displayOllamaInfo(const std::unique_ptr<OllamaStatus>& status);
-    void displayRunningModels(const std::vector<OllamaRunningModel>& models);
-    void displayAvailableModels(const std::vector<OllamaModel>& models);
+    void appendHeader(const char* title);
+    void appendFooter(const char* keys = "");
+    void appendHeatLegend();
+    void present();
+    void composeFrame(const DisplayInfo& info);
+    void composeFleet(const std::vector<FleetNode>& nodes, int port, const FleetView& view);
+    void composeFleetHeatmap(const std::vector<FleetNode>& nodes, const FleetView& view);
+    void composeFleetNode(const FleetNode& node);
+    void displayGPUInfo(const std::vector<GPUInfo>& gpu_infos, bool compact_allowed = true);
+    void displayHostInfo(const HostInfo& host_info);
+    void displayTopology(const DisplayInfo& info);
+    void displayOllamaInfo(const DisplayInfo& info);
+    void displayRequestStats(const LogStats& stats);
+    void displayEnergy(const EnergyInfo& energy);
+    void displayAlerts(const std::vector<ActiveAlert>& alerts);
+    void displayRunningModels(const std::vector<OllamaRunningModel>& models,
+                              const std::unordered_map<std::string, std::shared_ptr<const ModelMetadata>>& metadata);
+    void displayAvailableModels(const std::vector<OllamaModel>& models, const ModelStoreInfo& store,
+                                const std::vector<Placement>& placements);
+    void displayPlan(const DisplayInfo& info);
+    void displayKeeper(const KeeperInfo& keeper);
+    void displayEngines(const std::vector<EngineStats>& engines);
+    void appendPlanRows(const std::vector<PlannedModel>& plan);
 };
\ No newline at end of file
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include "gpu_monitor.h"
+#include "ollama_client.h"
+
+struct ModelEnergy {
+    std::string name;
+    bool resident = false;
+    double watts = 0.0;          // Share of the current GPU power
+    double joules = 0.0;         // Lifetime, including previous runs
+    uint64_t tokens = 0;         // Lifetime generated tokens attributed to the model
+    double token_joules = 0.0;   // Energy spent while its tokens were being counted
+
+    // Energy per generated token, or -1 without token counts
+    double joulesPerToken() const { return tokens > 0 ? token_joules / static_cast<double>(tokens) : -1.0; }
+};
+
+struct GpuEnergy {
+    std::string name;
+    double joules = 0.0;         // Lifetime
+};
+
+struct EnergyInfo {
+    bool available = false;       // Some GPU reports power
+    double session_joules = 0.0;  // All GPUs since startup
+    double total_joules = 0.0;    // All GPUs, lifetime
+    double idle_joules = 0.0;     // Lifetime, nothing loaded
+    double unattributed_joules = 0.0;  // Lifetime, Ollama state unknown
+    std::vector<GpuEnergy> gpus;        // In GPUMonitor order
+    std::vector<ModelEnergy> models;    // Resident first by power, then by energy
+
+    bool has_tokens = false;
+    uint64_t session_tokens = 0;
+    double session_joules_per_token = -1.0;
+};
+
+// Integrates GPU power into energy with the trapezoidal rule over the
+// samples' own timestamps, splits each interval across the resident models
+// by their VRAM share, and keeps lifetime totals in a small TSV file.
+class EnergyMeter {
+public:
+    // Loads previous totals; empty path disables persistence. refresh is how
+    // often samples arrive, which bounds the gaps worth integrating.
+    EnergyMeter(const std::string& path, std::chrono::seconds refresh);
+    ~EnergyMeter();
+
+    EnergyMeter(const EnergyMeter&) = delete;
+    EnergyMeter& operator=(const EnergyMeter&) = delete;
+
+    // New power samples; status is null when the Ollama state is unknown
+    void addSamples(const std::vector<GPUInfo>& gpus, const OllamaStatus* status);
+
+    // Cumulative generated-token count (from the server log)
+    void addTokens(uint64_t total_generated);
+
+    EnergyInfo getInfo() const;
+
+    // Write totals now (also done periodically and on destruction)
+    void save();
+
+private:
+    struct Gpu {
+        std::string key;   // "<index>:<name>", stable across restarts
+        std::string name;
+        std::chrono::steady_clock::time_point sampled_at;
+        int milliwatts = 0;
+        double joules = 0.0;
+        bool seen = false;  // Present in the latest sample set
+    };
+
+    struct Model {
+        std::string name;
+        double joules = 0.0;
+        double token_joules = 0.0;
+        uint64_t tokens = 0;
+        double watts = 0.0;
+        int64_t vram_bytes = 0;  // Resident VRAM in the latest status, 0 if unloaded
+    };
+
+    std::string path_;
+    std::chrono::steady_clock::duration max_gap_;
+    std::vector<Gpu> gpus_;
+    std::vector<Model> models_;
+    double idle_joules_ = 0.0;
+    double unattributed_joules_ = 0.0;
+    double session_joules_ = 0.0;
+    bool power_seen_ = false;
+
+    // Token accounting starts with the first count we see
+    bool counting_tokens_ = false;
+    uint64_t last_token_total_ = 0;
+    uint64_t session_tokens_ = 0;
+    double session_token_joules_ = 0.0;
+
+    std::chrono::steady_clock::time_point saved_at_;
+
+    Model& model(const std::string& name);
+    void load();
+};
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include <vector>
+
+// Single-threaded reactor that owns timers, signals, fd watches and
+// cross-thread wakeups. On Linux it is one epoll set fed by timerfd,
+// signalfd and eventfd, so an idle loop sleeps until the next deadline.
+// Elsewhere timers and post() run on a condition variable and fd watches
+// are unavailable.
+class EventLoop {
+public:
+    using Callback = std::function<void()>;
+    using FdCallback = std::function<void(bool readable, bool writable)>;
+
+    EventLoop();
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // Periodic timer on absolute monotonic deadlines (start + n * period),
+    // so callback run time never accumulates as drift. Returns a timer id.
+    int addTimer(std::chrono::milliseconds period, Callback callback, bool fire_immediately = false);
+    void removeTimer(int id);
+
+    // Readiness callbacks for sockets, pipes, inotify and similar fds
+    bool watchFd(int fd, bool want_read, bool want_write, FdCallback callback);
+    void updateFd(int fd, bool want_read, bool want_write);
+    void unwatchFd(int fd);
+
+    // Deliver a signal on the loop thread instead of in a handler.
+    // Register before starting any threads so they inherit the blocked mask.
+    void onSignal(int signo, Callback callback);
+
+    // Thread-safe: queue a callback and wake the loop
+    void post(Callback callback);
+
+    // Injectable clock for soak runs: run() stops sleeping and fires timers
+    // back to back in deadline order, advancing now() to each deadline, so
+    // days of refreshes pass in minutes. fds and post() are still polled
+    // between timers. Call before adding any timer.
+    void simulateTime();
+    std::chrono::steady_clock::time_point now() const;
+
+    void run();
+    void stop();
+    bool isRunning() const { return running_; }
+
+private:
+    struct Timer {
+        int fd = -1;
+        std::chrono::milliseconds period{0};
+        std::chrono::steady_clock::time_point next{};
+        Callback callback;
+    };
+
+    bool running_ = false;
+    bool simulated_ = false;
+    std::chrono::steady_clock::time_point simulated_now_{};
+    int next_timer_id_ = 1;
+    std::unordered_map<int, Timer> timers_;
+    std::unordered_map<int, FdCallback> fd_callbacks_;
+    std::unordered_map<int, Callback> signal_callbacks_;
+
+    std::mutex post_mutex_;
+    std::vector<Callback> posted_;
+
+#ifdef __linux__
+    int epoll_fd_ = -1;
+    int event_fd_ = -1;
+    int signal_fd_ = -1;
+    std::unordered_map<int, int> timer_by_fd_;
+
+    void handleSignals();
+#else
+    std::condition_variable post_cv_;
+    bool woken_ = false;
+#endif
+
+    void runPosted();
+    void runNextSimulated();
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+#include "ollama_client.h"
+#include "metrics_scraper.h"
+#include "event_loop.h"
+
+// What one refresh needs from the network
+struct FetchResult {
+    std::unique_ptr<OllamaStatus> status;   // Null while the server is down or on failure
+    bool catalog_requested = false;         // /api/tags was asked for (only with a status)
+    bool catalog_complete = false;          // ... and a whole models array came back
+    std::vector<OllamaModel> catalog;
+    std::vector<EngineStats> engines;       // One per --scrape target
+};
+
+// Runs a refresh's blocking requests (/api/ps, /api/tags, the --scrape
+// targets) on its own thread, so a slow or blackholed host costs the event
+// loop nothing: keys, signals and the servers keep being served, and the
+// result is handed back with EventLoop::post. One fetch is in flight at a
+// time. Without a loop the requests run on the calling thread, for runs
+// that measure the whole refresh (--soak, --profile).
+class FetchWorker {
+public:
+    using Done = std::function<void(FetchResult& result)>;
+
+    FetchWorker(OllamaClient& client, std::vector<std::unique_ptr<MetricsScraper>>& scrapers, EventLoop* loop);
+    ~FetchWorker();
+
+    FetchWorker(const FetchWorker&) = delete;
+    FetchWorker& operator=(const FetchWorker&) = delete;
+
+    // Start a fetch; done runs on the loop thread. False (and done is
+    // dropped) while the previous fetch is still out. Loop thread only.
+    bool request(bool with_catalog, Done done);
+    bool synchronous() const { return loop_ == nullptr; }
+    bool busy() const { return busy_; }
+
+private:
+    OllamaClient& client_;
+    std::vector<std::unique_ptr<MetricsScraper>>& scrapers_;
+    EventLoop* loop_;
+    bool busy_ = false;             // Loop thread only
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool pending_ = false;
+    bool with_catalog_ = false;
+    Done done_;
+    bool stopping_ = false;
+    std::thread worker_;
+
+    void fetch(FetchResult& result, bool with_catalog);
+    void workerLoop();
+};
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <deque>
+#include <chrono>
+#include <cstdint>
+#include "event_loop.h"
+#include "fleet_protocol.h"
+
+// `--agent`: pushes this node's snapshots to an aggregator over one
+// persistent TCP stream. A keyframe goes out after connecting, on request
+// and every kKeyframeInterval frames; everything else is a delta against the
+// newest snapshot the aggregator acknowledged. Reconnects with a fixed
+// backoff and never blocks the refresh. Linux only.
+class FleetAgent {
+public:
+    // address is "host:port"
+    FleetAgent(const std::string& address, const std::string& hostname);
+    ~FleetAgent();
+
+    FleetAgent(const FleetAgent&) = delete;
+    FleetAgent& operator=(const FleetAgent&) = delete;
+
+    // False if the address can't be parsed or sockets aren't supported
+    bool start(EventLoop& loop);
+
+    // Send the latest collection (dropped while disconnected)
+    void publish(const DisplayInfo& info);
+
+    bool isConnected() const { return fd_ >= 0 && !connecting_; }
+    uint64_t bytesSent() const { return bytes_sent_; }
+
+private:
+    static constexpr int kKeyframeInterval = 60;
+    static constexpr size_t kMaxInFlight = 16;
+
+    struct Pending {
+        uint64_t seq = 0;
+        fleet::Fields fields;
+    };
+
+    EventLoop* loop_ = nullptr;
+    std::string host_;
+    int port_ = 0;
+    std::string hostname_;
+
+    int fd_ = -1;
+    bool connecting_ = false;
+    std::chrono::steady_clock::time_point next_attempt_{};
+    std::string out_;   // Encoded but not yet written
+    std::string in_;    // Partial acks
+    uint64_t bytes_sent_ = 0;
+
+    uint64_t next_seq_ = 1;
+    bool have_acked_ = false;
+    fleet::Fields acked_;
+    uint64_t acked_seq_ = 0;
+    std::deque<Pending> in_flight_;
+    int frames_since_keyframe_ = 0;
+    bool force_keyframe_ = true;
+
+    void connect();
+    void disconnect();
+    void onEvent(bool readable, bool writable);
+    void flush();
+    void handleMessage(std::string_view payload);
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <chrono>
+#include <functional>
+#include <cstdint>
+#include "event_loop.h"
+#include "fleet_protocol.h"
+
+// One agent as shown in the fleet view
+struct FleetNode {
+    fleet::NodeSnapshot snapshot;
+    std::string address;        // Peer of the latest connection
+    bool connected = false;
+    int64_t updated_at = 0;     // Unix time of the last applied frame
+    double bytes_per_sec = 0.0; // Inbound protocol bytes, 10 s window
+    uint64_t frames = 0;
+    uint64_t resyncs = 0;       // Deltas whose base was unknown
+};
+
+// `--aggregator`: accepts agent streams on a TCP port, applies keyframes
+// and deltas, acknowledges every applied frame and keeps the latest
+// snapshot per hostname. Nodes that disconnect stay listed as offline.
+// Linux only.
+class FleetAggregator {
+public:
+    explicit FleetAggregator(int port);
+    ~FleetAggregator();
+
+    FleetAggregator(const FleetAggregator&) = delete;
+    FleetAggregator& operator=(const FleetAggregator&) = delete;
+
+    bool start(EventLoop& loop);
+    int port() const { return port_; }
+
+    // Sorted by hostname
+    std::vector<FleetNode> nodes() const;
+
+    // Called for every applied frame and when a node goes offline
+    void setOnUpdate(std::function<void(const FleetNode&)> on_update) { on_update_ = std::move(on_update); }
+
+private:
+    // Snapshots kept per connection for deltas to refer back to
+    static constexpr size_t kHistory = 8;
+
+    struct Connection {
+        std::string address;
+        std::string hostname;   // Known after the first keyframe
+        std::string in;
+        std::string out;
+        std::deque<std::pair<uint64_t, fleet::Fields>> history;
+        uint64_t window_bytes = 0;
+        std::chrono::steady_clock::time_point window_start;
+    };
+
+    int port_;
+    int listen_fd_ = -1;
+    EventLoop* loop_ = nullptr;
+    std::unordered_map<int, Connection> connections_;
+    std::map<std::string, FleetNode> nodes_;
+    std::function<void(const FleetNode&)> on_update_;
+
+    void accept();
+    void onReadable(int fd);
+    void close(int fd);
+    bool handleMessage(Connection& connection, std::string_view payload);
+    void flush(int fd, Connection& connection);
+};
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+struct DisplayInfo;
+
+// Wire protocol between `--agent` nodes and the `--aggregator`.
+//
+// Every message is a varint payload length followed by the payload, whose
+// first byte is the message type. A node snapshot is flattened into a vector
+// of integers plus a string table (hostname, GPU and model names, model
+// digests):
+//
+//   keyframe: seq, version, field count, zigzag fields, strings
+//   delta:    seq, base seq, field count, change count,
+//             (index gap, zigzag difference) per changed field,
+//             0 or 1 + strings when the string table changed
+//   ack:      seq                (aggregator -> agent)
+//   resync:   (empty)            (aggregator -> agent, base unknown)
+//
+// Deltas are taken against a snapshot the aggregator acknowledged, so a
+// lost or rejected frame never corrupts later ones. Strings are a varint
+// count, then length-prefixed bytes.
+namespace fleet {
+
+constexpr uint32_t kVersion = 2;
+constexpr size_t kMaxMessage = 64 * 1024;
+
+enum MessageType : uint8_t {
+    kKeyframe = 1,
+    kDelta = 2,
+    kAck = 3,
+    kResync = 4,
+};
+
+struct GpuSample {
+    std::string name;
+    int64_t utilization_percent = 0;
+    int64_t used_vram_mb = 0;
+    int64_t total_vram_mb = 0;
+    int64_t temperature_c = 0;
+    int64_t power_watts = 0;
+};
+
+struct ModelSample {
+    std::string name;
+    std::string digest;
+    int64_t size_mb = 0;
+    int64_t vram_mb = 0;
+    int64_t expires_at = 0;     // Unix seconds, 0 if unknown
+};
+
+// One node's state as the aggregator sees it
+struct NodeSnapshot {
+    std::string hostname;
+    int64_t collected_at = 0;   // Unix seconds
+    bool ollama_up = false;
+    int64_t cpu_permille = 0;
+    int64_t mem_used_mb = 0;
+    int64_t mem_total_mb = 0;
+    int64_t energy_wh = 0;      // Lifetime GPU energy
+    int64_t requests_per_min_x10 = 0;
+    int64_t p95_ms = 0;         // Worst endpoint p95 from --log
+    std::vector<GpuSample> gpus;
+    std::vector<ModelSample> models;
+};
+
+// Flat form the deltas are computed on
+struct Fields {
+    std::vector<int64_t> values;
+    std::vector<std::string> strings;
+};
+
+NodeSnapshot fromDisplayInfo(const DisplayInfo& info, const std::string& hostname);
+Fields flatten(const NodeSnapshot& snapshot);
+bool unflatten(const Fields& fields, NodeSnapshot& snapshot);
+
+// Append a complete message (length prefix included) to out
+void encodeKeyframe(std::string& out, uint64_t seq, const Fields& fields);
+void encodeDelta(std::string& out, uint64_t seq, uint64_t base_seq, const Fields& base, const Fields& fields);
+void encodeAck(std::string& out, uint64_t seq);
+void encodeResync(std::string& out);
+
+// Split one message off the front of a receive buffer. Returns the payload
+// length consumed via *used, 0 if more bytes are needed, or -1 if the
+// stream is malformed.
+int nextMessage(std::string_view buffer, std::string_view& payload, size_t& used);
+
+struct Message {
+    MessageType type = kKeyframe;
+    uint64_t seq = 0;
+    uint64_t base_seq = 0;
+};
+
+// Read the header of a payload; for keyframes and deltas the body is then
+// applied with applyBody (base is ignored for keyframes)
+bool parseHeader(std::string_view payload, Message& message, size_t& body_offset);
+bool applyBody(const Message& message, std::string_view payload, size_t body_offset,
+               const Fields& base, Fields& out);
+
+} // namespace fleet
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <cstdint>
+#include <type_traits>
+
+// Fixed table column: header title and width in terminal cells
+struct Column {
+    const char* title;
+    int width;
+};
+
+// Terminal cells taken by UTF-8 text: wide (CJK, emoji) code points count
+// as 2, combining marks as 0, and ANSI escape sequences as nothing
+size_t displayWidth(std::string_view text);
+
+// Reusable text buffer a frame is composed into. Everything is formatted in
+// place with std::to_chars; once the buffer has grown to the largest frame
+// seen, composing another frame does no heap allocation.
+class FrameBuffer {
+public:
+    explicit FrameBuffer(size_t capacity = 64 * 1024) { buf_.reserve(capacity); }
+
+    void clear() { buf_.clear(); }   // Keeps the capacity
+    const char* data() const { return buf_.data(); }
+    size_t size() const { return buf_.size(); }
+
+    FrameBuffer& operator<<(std::string_view text) {
+        buf_.append(text.data(), text.size());
+        return *this;
+    }
+    FrameBuffer& operator<<(const char* text) { return *this << std::string_view(text); }
+    FrameBuffer& operator<<(const std::string& text) { return *this << std::string_view(text); }
+    FrameBuffer& operator<<(char c) {
+        buf_.push_back(c);
+        return *this;
+    }
+
+    template <typename T, typename = std::enable_if_t<std::is_integral_v<T> &&
+                                                      !std::is_same_v<T, bool> &&
+                                                      !std::is_same_v<T, char>>>
+    FrameBuffer& operator<<(T value) {
+        char tmp[24];
+        auto result = std::to_chars(tmp, tmp + sizeof(tmp), value);
+        buf_.append(tmp, static_cast<size_t>(result.ptr - tmp));
+        return *this;
+    }
+
+    // Floating point needs an explicit precision: use fixed()
+    FrameBuffer& operator<<(double) = delete;
+
+    FrameBuffer& fixed(double value, int precision);
+    FrameBuffer& repeat(char c, size_t count);
+    FrameBuffer& bytes(int64_t bytes);                 // "1.5 GB"
+    FrameBuffer& progressBar(double percentage, int width);
+
+    // Position to pass to padFrom() after writing a cell's content
+    size_t mark() const { return buf_.size(); }
+    // Pad everything written since mark to width cells
+    FrameBuffer& padFrom(size_t mark, int width);
+
+    // Text cut at a code point boundary to end in "..." if wider than max_width
+    FrameBuffer& truncated(std::string_view text, size_t max_width);
+
+    // Left-aligned cell; text is truncated to width - 1 so columns stay separated
+    FrameBuffer& cell(std::string_view text, int width);
+    FrameBuffer& bytesCell(int64_t bytes, int width);
+    FrameBuffer& intCell(int64_t value, int width);
+    FrameBuffer& fixedCell(double value, int precision, std::string_view suffix, int width);
+
+    template <size_t N>
+    FrameBuffer& header(const Column (&columns)[N], size_t count = N) {
+        for (size_t i = 0; i < count && i < N; i++) {
+            cell(columns[i].title, columns[i].width);
+        }
+        return *this;
+    }
+
+private:
+    std::string buf_;
+};
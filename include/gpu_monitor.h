@@ -2,6 +2,12 @@
 
 #include <string>
 #include <vector>
+#include <cstdint>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 struct GPUInfo {
     bool available = false;
@@ -10,10 +16,37 @@ struct GPUInfo {
     double total_vram_gb = 0.0;
     double used_vram_gb = 0.0;
     double free_vram_gb = 0.0;
+    bool shared_memory = false;         // Integrated GPU without its own VRAM; not a placement target
     double utilization_percent = 0.0;
     int temperature_c = 0;
     int power_watts = 0;
-    
+    int power_milliwatts = 0;           // Unrounded, for energy integration
+    std::chrono::steady_clock::time_point power_sampled_at;  // Unset if no power reading
+
+    // Extended metrics (NVML only)
+    bool has_extended_metrics = false;
+    double memory_util_percent = 0.0;   // Memory-bandwidth utilization
+    int sm_clock_mhz = 0;
+    int mem_clock_mhz = 0;
+    uint64_t throttle_reasons = 0;      // NVML clocks-throttle-reason bitmask
+    double pcie_rx_mb_s = 0.0;
+    double pcie_tx_mb_s = 0.0;
+    bool ecc_enabled = false;
+    uint64_t ecc_corrected = 0;         // Volatile counts, reset on driver reload
+    uint64_t ecc_uncorrected = 0;
+    uint64_t pcie_replays = 0;
+    int xid_errors = 0;                 // Critical XID events seen since startup
+    int last_xid = 0;
+
+    // Topology: PCI address and NUMA node are fixed, the link is re-read
+    // every few seconds (idle GPUs train down to save power)
+    std::string pci_bus_id;             // "0000:3b:00.0", empty if unknown
+    int numa_node = -1;                 // -1 if unknown or not a NUMA machine
+    int pcie_gen = 0;                   // 0 if unknown
+    int pcie_gen_max = 0;
+    int pcie_width = 0;
+    int pcie_width_max = 0;
+
     double getVRAMUsagePercent() const {
         if (total_vram_gb > 0) {
             return (used_vram_gb / total_vram_gb) * 100.0;
@@ -22,20 +55,66 @@ struct GPUInfo {
     }
 };
 
+class SysfsGPUBackend;
+struct GPUTopology;
+
 class GPUMonitor {
 public:
-    GPUMonitor();
+    // sysfs_root lets the Linux DRM backend run against a fake sysfs tree
+    explicit GPUMonitor(const std::string& sysfs_root = "/");
     ~GPUMonitor();
-    
+
     bool isAvailable() const;
     std::vector<GPUInfo> getGPUInfo();
     int getGPUCount() const;
     bool update();
+    
+    // Peer connectivity by GPUInfo::index; null until devices were found
+    std::shared_ptr<const GPUTopology> getTopology() const { return topology_; }
 
 private:
+    // Per-device state resolved once at init; handles and names never change
+    struct DeviceState {
+        void* handle = nullptr;
+        std::string name;
+        bool field_values_supported = true;
+        int xid_errors = 0;
+        int last_xid = 0;
+        double pcie_rx_mb_s = 0.0;      // Written by the PCIe thread (pcie_mutex_)
+        double pcie_tx_mb_s = 0.0;
+    };
+
+    // Topology per GPU index (NVML devices, then sysfs ones)
+    struct DeviceTopology {
+        std::string pci_bus_id;
+        int numa_node = -1;
+        int pcie_gen = 0;
+        int pcie_gen_max = 0;
+        int pcie_width = 0;
+        int pcie_width_max = 0;
+    };
+
     bool initialized_;
     int gpu_count_;
-    
+    std::vector<DeviceState> devices_;
+    void* xid_event_set_ = nullptr;
+    std::unique_ptr<SysfsGPUBackend> sysfs_;
+    std::string sysfs_root_;
+    std::vector<DeviceTopology> device_topology_;
+    std::shared_ptr<const GPUTopology> topology_;
+    std::chrono::steady_clock::time_point links_sampled_at_{};
+
+    // PCIe throughput calls block in the driver, so they run on their own thread
+    std::thread pcie_thread_;
+    std::mutex pcie_mutex_;
+    std::condition_variable pcie_cv_;
+    bool pcie_stop_ = false;
+
     bool initializeNVML();
     void cleanupNVML();
+    void sampleNVMLDevice(DeviceState& device, GPUInfo& info);
+    void drainXidEvents();
+    void discoverTopology();
+    void sampleLinks();
+    void pcieLoop();
 };
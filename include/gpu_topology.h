@@ -0,0 +1,63 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "gpu_monitor.h"
+#include "host_monitor.h"
+
+// How two GPUs reach each other, best first (nvidia-smi topo -m labels)
+enum class GPULink : uint8_t {
+    Unknown,
+    Self,           // X
+    NVLink,         // NV<n>: n active links, direct or through NVSwitch
+    XGMI,           // AMD Infinity Fabric hive
+    Switch,         // PIX: behind a common PCIe switch
+    HostBridge,     // PHB: through the CPU's root complex
+    Node,           // NODE: different root complexes, same NUMA node
+    System,         // SYS: across the inter-socket link
+};
+
+struct GPUPeer {
+    GPULink link = GPULink::Unknown;
+    int nvlinks = 0;
+};
+
+// Peer matrix by GPUInfo::index, discovered once (devices don't move)
+struct GPUTopology {
+    int count = 0;
+    std::vector<GPUPeer> peers;     // count * count, row-major
+
+    GPUPeer peer(int a, int b) const {
+        if (a < 0 || b < 0 || a >= count || b >= count) {
+            return GPUPeer();
+        }
+        return peers[static_cast<size_t>(a) * static_cast<size_t>(count) + static_cast<size_t>(b)];
+    }
+};
+
+// "X", "NV4", "XGMI", "PIX", "PHB", "NODE", "SYS" or "?"
+std::string gpuLinkLabel(const GPUPeer& peer);
+
+// Linux sysfs, under root ("/" normally): the PCI device's NUMA node (-1 if
+// none), its link now and at most (0 if unknown), and how two devices
+// connect judging by their PCI paths (and amdgpu xGMI hive ids)
+int pciNumaNode(const std::string& root, const std::string& bus_id);
+bool readPciLink(const std::string& root, const std::string& bus_id,
+                 int& gen, int& gen_max, int& width, int& width_max);
+GPUPeer pciPeer(const std::string& root, const std::string& bus_a, int node_a,
+                const std::string& bus_b, int node_b);
+
+// "00000000:3B:00.0" (NVML) -> "0000:3b:00.0" (sysfs)
+std::string normalizeBusId(const std::string& bus_id);
+
+struct TopologyWarning {
+    bool severe = false;    // Cross-socket placement vs a merely slower path
+    std::string text;
+};
+
+// Runners pinned away from their GPUs' NUMA node, models split across GPUs
+// without NVLink/xGMI (worst over the inter-socket link), and PCIe links
+// trained below their width, or below their speed while busy
+std::vector<TopologyWarning> checkPlacement(const std::vector<GPUInfo>& gpus, const GPUTopology* topology,
+                                            const HostInfo& host);
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <chrono>
+
+struct RunnerProcess {
+    int pid = 0;
+    double cpu_percent = 0.0;   // top-style: 100% per fully used core
+    uint64_t rss_bytes = 0;
+    int threads = 0;
+    uint64_t cpu_nodes = 0;         // NUMA nodes its CPU affinity covers (bit n = node n)
+    std::vector<std::string> gpus;  // PCI bus ids of the GPU devices it has open
+};
+
+struct HostInfo {
+    bool available = false;
+    int cpu_count = 0;
+    int numa_nodes = 0;         // Nodes with CPUs; more than one on multi-socket hosts
+    double cpu_percent = 0.0;
+    double iowait_percent = 0.0;
+    uint64_t mem_total_bytes = 0;
+    uint64_t mem_available_bytes = 0;
+    uint64_t swap_total_bytes = 0;
+    uint64_t swap_free_bytes = 0;
+
+    // Pressure stall information (avg10), absent on older kernels
+    bool has_pressure = false;
+    double cpu_pressure_some = 0.0;
+    double mem_pressure_some = 0.0;
+    double mem_pressure_full = 0.0;
+    double io_pressure_some = 0.0;
+
+    std::vector<RunnerProcess> runners;
+
+    double getMemUsagePercent() const {
+        if (mem_total_bytes > 0) {
+            return 100.0 * static_cast<double>(mem_total_bytes - mem_available_bytes) / mem_total_bytes;
+        }
+        return 0.0;
+    }
+};
+
+// Host CPU, memory, swap and PSI collector plus per-runner CPU/RSS, CPU
+// affinity and open GPU devices (Linux). /proc files are opened once and
+// re-read with pread(); parsing uses from_chars.
+class HostMonitor {
+public:
+    HostMonitor();
+    ~HostMonitor();
+
+    HostMonitor(const HostMonitor&) = delete;
+    HostMonitor& operator=(const HostMonitor&) = delete;
+
+    bool isAvailable() const { return stat_fd_ >= 0; }
+    HostInfo getHostInfo();
+
+private:
+    struct RunnerState {
+        int pid = 0;
+        int stat_fd = -1;
+        int status_fd = -1;
+        uint64_t last_ticks = 0;
+        std::chrono::steady_clock::time_point last_sample{};
+        std::vector<std::string> gpus;  // Re-resolved on every scan
+    };
+
+    int stat_fd_ = -1;
+    int meminfo_fd_ = -1;
+    int psi_cpu_fd_ = -1;
+    int psi_mem_fd_ = -1;
+    int psi_io_fd_ = -1;
+
+    uint64_t last_cpu_total_ = 0;
+    uint64_t last_cpu_idle_ = 0;
+    uint64_t last_cpu_iowait_ = 0;
+    long clock_ticks_ = 100;
+
+    std::vector<RunnerState> runners_;
+    std::chrono::steady_clock::time_point last_runner_scan_{};
+
+    // NUMA node of each CPU, from /sys/devices/system/node; empty if unknown
+    std::vector<uint8_t> cpu_node_;
+    int numa_nodes_ = 0;
+
+    // Reusable read buffer for every /proc file
+    char buf_[4096];
+
+    void sampleCpu(HostInfo& info);
+    void sampleMemory(HostInfo& info);
+    void samplePressure(HostInfo& info);
+    void sampleRunners(HostInfo& info);
+    void scanRunners();
+    void closeRunner(RunnerState& runner);
+};
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+
+// Minimal blocking HTTP client: WinHTTP on Windows, plain sockets elsewhere.
+// Returns the response body, or an empty string on any transport failure.
+std::string httpRequest(const std::string& base_url,
+                        const std::string& method,
+                        const std::string& endpoint,
+                        const std::string& body = "");
+
+// Split "http://host:port/..." into host and port (default 11434)
+void parseBaseUrl(const std::string& base_url, std::string& host, int& port);
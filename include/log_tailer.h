@@ -0,0 +1,92 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include "event_loop.h"
+
+struct EndpointStats {
+    std::string endpoint;       // "POST /api/generate"
+    double requests_per_min = 0.0;
+    double p50_ms = 0.0;
+    double p95_ms = 0.0;
+    double p99_ms = 0.0;
+    uint64_t total = 0;
+    uint64_t errors = 0;        // 5xx responses
+};
+
+struct LogStats {
+    bool active = false;
+    std::string path;
+    std::vector<EndpointStats> endpoints;
+
+    // Most recent "offloaded N/M layers to GPU" line
+    bool has_offload = false;
+    int offloaded_layers = 0;
+    int total_layers = 0;
+
+    // Tokens generated since the tail started, from runner timing lines;
+    // only present when the server logs them (llama.cpp runner, OLLAMA_DEBUG)
+    bool has_tokens = false;
+    uint64_t generated_tokens = 0;
+};
+
+// Tails the Ollama server log (or a journald export/cat dump) with inotify,
+// follows rotation and truncation, and turns [GIN] request lines into
+// per-endpoint rates and latency percentiles. Linux only.
+class LogTailer {
+public:
+    explicit LogTailer(const std::string& path);
+    ~LogTailer();
+
+    LogTailer(const LogTailer&) = delete;
+    LogTailer& operator=(const LogTailer&) = delete;
+
+    // Start at the end of the file and register with the loop
+    bool start(EventLoop& loop);
+    LogStats getStats() const;
+
+private:
+    // Latency window per endpoint; percentiles cover the last kWindow requests
+    static constexpr size_t kWindow = 1024;
+
+    struct Endpoint {
+        std::string name;
+        std::array<float, kWindow> latencies_ms{};
+        std::array<std::chrono::steady_clock::time_point, kWindow> arrivals{};
+        size_t next = 0;
+        size_t filled = 0;
+        uint64_t total = 0;
+        uint64_t errors = 0;
+    };
+
+    std::string path_;
+    std::string dir_;
+    std::string file_name_;
+    int file_fd_ = -1;
+    int inotify_fd_ = -1;
+    int file_wd_ = -1;
+    int dir_wd_ = -1;
+    int64_t offset_ = 0;
+
+    std::vector<char> read_buf_;   // Reused for every read
+    std::string partial_;          // Trailing line without a newline yet
+    std::vector<Endpoint> endpoints_;
+    mutable std::vector<float> scratch_;
+
+    bool has_offload_ = false;
+    int offloaded_layers_ = 0;
+    int total_layers_ = 0;
+    bool has_tokens_ = false;
+    uint64_t generated_tokens_ = 0;
+
+    bool openFile(bool seek_to_end);
+    void onInotify();
+    void readAppended();
+    void processLine(std::string_view line);
+    bool processTimings(std::string_view line);
+    void recordRequest(int status, double latency_ms, std::string_view method, std::string_view path);
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+// Per-engine series kept from an exposition, by meaning rather than name
+enum class EngineMetric {
+    Running,        // Requests being processed
+    Waiting,        // Requests queued
+    KvCache,        // KV-cache usage, percent
+    GenTokens,      // Generated tokens per second (from a counter)
+    PromptTokens,   // Prompt tokens per second (from a counter)
+    Count
+};
+
+// One model served by an engine
+struct EngineModel {
+    std::string name;           // model_name label, or the engine name
+    double values[static_cast<size_t>(EngineMetric::Count)] = {};
+    bool has[static_cast<size_t>(EngineMetric::Count)] = {};
+};
+
+struct EngineStats {
+    std::string name;           // host:port of the endpoint
+    bool up = false;
+    size_t bytes = 0;           // Size of the last exposition
+    double parse_ms = 0.0;
+    size_t series = 0;          // Whitelisted series in the table
+    std::vector<EngineModel> models;
+};
+
+// `--scrape <url>`: polls a Prometheus text endpoint of a co-located
+// engine (vLLM, llama.cpp server, SGLang, TGI) and keeps only the series
+// that say what it is doing with the GPU: queue depth, token rates and
+// KV-cache usage. The parser walks the exposition in place: lines whose
+// metric isn't whitelisted are skipped with memchr, and kept series live in
+// a fixed open-addressed table keyed by a hash of name and labels, so
+// parsing allocates nothing. A failed scrape is retried after 5 seconds,
+// doubling while the endpoint stays down, up to a minute.
+class MetricsScraper {
+public:
+    explicit MetricsScraper(const std::string& url);
+
+    // Fetch and parse once (skipped while backing off); false if down
+    bool scrape();
+    EngineStats getStats() const;
+
+private:
+    static constexpr size_t kSlots = 512;  // Power of two
+    static constexpr size_t kModelChars = 64;
+
+    struct Slot {
+        uint64_t hash = 0;                  // 0 = empty
+        uint8_t metric = 0;
+        bool counter = false;
+        bool ready = false;                 // Counters need two readings for a rate
+        uint32_t seen = 0;                  // Generation of the last scrape that had it
+        double value = 0.0;                 // Gauge value or counter rate
+        double raw = 0.0;                   // Last counter reading
+        std::chrono::steady_clock::time_point raw_at{};
+        uint8_t model_len = 0;
+        char model[kModelChars] = {};
+    };
+
+    std::string url_;
+    std::string base_;          // scheme://host:port
+    std::string path_;          // /metrics
+    std::string name_;
+    std::array<Slot, kSlots> slots_;
+    size_t used_ = 0;
+    uint32_t generation_ = 0;
+    bool up_ = false;
+    size_t bytes_ = 0;
+    double parse_ms_ = 0.0;
+    std::chrono::steady_clock::time_point retry_at_{};
+    std::chrono::steady_clock::duration backoff_;
+
+    void parse(std::string_view text, std::chrono::steady_clock::time_point now);
+    Slot* find(uint64_t hash);
+};
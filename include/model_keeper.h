@@ -0,0 +1,127 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+#include <chrono>
+#include <cstdint>
+
+class OllamaClient;
+struct DisplayInfo;
+
+enum class KeepState {
+    Idle,           // Outside its time window
+    Resident,
+    Refreshing,     // Keep-alive request in flight
+    Loading,        // Preload in flight or awaiting confirmation in /api/ps
+    NoRoom,         // Loading now would evict or offload
+    Backoff,        // After a failure or an eviction
+    Missing,        // Not in the catalog
+};
+
+// "resident", "no room", ... for the panel and the event stream
+const char* keepStateName(KeepState state);
+
+// One desired model as shown in the keeper panel
+struct KeeperModel {
+    std::string name;
+    KeepState state = KeepState::Idle;
+    int64_t expires_in = 0;     // Resident: seconds until Ollama unloads it
+    int64_t retry_in = 0;       // Backoff: seconds until the next attempt, 0 = queued
+};
+
+struct KeeperAction {
+    int64_t time = 0;           // Unix time
+    std::string model;
+    std::string text;           // "preload", "keep-alive", "failed: ..."
+    bool ok = true;
+};
+
+struct KeeperInfo {
+    bool active = false;
+    std::vector<KeeperModel> models;
+    std::vector<KeeperAction> recent;   // Newest last
+};
+
+// `--keep <file>`: keeps a desired set of models resident. One model per line:
+//
+//   <model> [keep <duration>|forever] [at HH:MM-HH:MM]
+//   [hostname]                   following lines apply only on that host
+//
+// Resident models get a minimal keep-alive request shortly before they
+// expire. Missing ones are preloaded only when the placement simulator says
+// they fit without evicting or offloading anything. At most one request runs
+// at a time, preloads are spaced out, and failures or a preloaded model being
+// evicted again back off exponentially, so the keeper never fights other
+// demand for VRAM. Requests run on a worker thread.
+class ModelKeeper {
+public:
+    explicit ModelKeeper(OllamaClient& client);
+    ~ModelKeeper();
+
+    ModelKeeper(const ModelKeeper&) = delete;
+    ModelKeeper& operator=(const ModelKeeper&) = delete;
+
+    // Parse the entries for this host; on failure error names the line
+    bool load(const std::string& path, const std::string& hostname, std::string& error);
+    size_t targetCount() const { return targets_.size(); }
+
+    // Decide on this collection's state and queue at most one request
+    KeeperInfo update(const DisplayInfo& info);
+
+    // Called for every recorded action: on the worker thread for request
+    // outcomes, from update() for evictions and timeouts it notices
+    void setOnAction(std::function<void(const KeeperAction&)> on_action);
+
+private:
+    struct Target {
+        std::string model;
+        int64_t keep_seconds = 600;     // -1 = forever
+        int window_start = -1;          // Minutes after local midnight, -1 = always
+        int window_end = -1;
+    };
+
+    struct Tracking {
+        int failures = 0;
+        std::chrono::steady_clock::time_point retry_at{};
+        std::chrono::steady_clock::time_point preloaded_at{};
+        std::chrono::steady_clock::time_point refreshed_at{};
+        bool awaiting = false;          // Preload sent, not yet seen in /api/ps
+        bool preloaded = false;         // Watching for an early eviction
+    };
+
+    struct Job {
+        std::string model;
+        int64_t keep_seconds = 0;
+        int64_t num_ctx = 0;
+        bool preload = false;
+    };
+
+    OllamaClient& client_;
+    std::vector<Target> targets_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::unordered_map<std::string, Tracking> tracking_;
+    std::deque<KeeperAction> recent_;
+    std::vector<KeeperAction> unreported_;  // Recorded, not yet passed to on_action_
+    std::string in_flight_;             // Model of the running request
+    bool has_job_ = false;
+    Job job_;
+    std::chrono::steady_clock::time_point last_preload_{};
+    std::function<void(const KeeperAction&)> on_action_;
+    bool stopping_ = false;
+    std::thread worker_;
+
+    bool parseTarget(std::string_view line, Target& target, std::string& error);
+    void backoff(Tracking& tracking, std::chrono::steady_clock::time_point now);
+    void record(const std::string& model, std::string text, bool ok);
+    void report();
+    void workerLoop();
+};
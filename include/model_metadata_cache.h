@@ -0,0 +1,63 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <functional>
+#include "ollama_client.h"
+
+// Digest-keyed cache of /api/show metadata. lookup() never blocks on the
+// network: misses are queued for a background worker that fetches each
+// digest once and persists the result to a small TSV file.
+class ModelMetadataCache {
+public:
+    // Empty cache_file disables persistence
+    ModelMetadataCache(OllamaClient& client, const std::string& cache_file);
+    ~ModelMetadataCache();
+
+    ModelMetadataCache(const ModelMetadataCache&) = delete;
+    ModelMetadataCache& operator=(const ModelMetadataCache&) = delete;
+
+    // Cached metadata for this model, or nullptr while a fetch is pending
+    std::shared_ptr<const ModelMetadata> lookup(const std::string& name, const std::string& digest);
+
+    // The complete installed catalog; the cache file keeps only its digests
+    // (and running models'). Until one is known, nothing is pruned.
+    void setCatalog(const std::vector<OllamaModel>& models);
+
+    // Called on the worker thread after each successful fetch
+    void setOnUpdate(std::function<void()> on_update);
+
+private:
+    struct PendingFetch {
+        std::string name;
+        std::string digest;
+    };
+
+    OllamaClient& client_;
+    std::string cache_file_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::unordered_map<std::string, std::shared_ptr<const ModelMetadata>> by_digest_;
+    std::unordered_map<std::string, std::string> digest_by_name_;
+    std::unordered_set<std::string> catalog_digests_;
+    bool catalog_known_ = false;
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point> failed_at_;
+    std::deque<PendingFetch> queue_;
+    std::unordered_set<std::string> queued_;
+    bool stopping_ = false;
+    std::function<void()> on_update_;
+    std::thread worker_;
+
+    void workerLoop();
+    void load();
+    void save();
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <chrono>
+#include <cstdint>
+#include "ollama_client.h"
+
+struct ModelStoreEntry {
+    bool found = false;             // Manifest and blobs located on disk
+    int64_t disk_bytes = 0;         // All blobs the model references
+    int64_t shared_bytes = 0;       // Of those, blobs other models reference too
+    double cached_percent = -1.0;   // Sampled page-cache residency, -1 if unknown
+    double est_load_seconds = 0.0;  // Read time for the uncached part plus the rest
+};
+
+struct ModelStoreInfo {
+    bool available = false;
+    std::string models_dir;
+    int64_t store_bytes = 0;        // Unique blobs on disk
+    int64_t dedup_saved_bytes = 0;  // Sum of model sizes minus store_bytes
+    int64_t cached_bytes = 0;       // Estimated bytes of the store in page cache
+    std::string disk_kind;          // "NVMe", "SSD", "HDD" or empty
+    double disk_mb_s = 0.0;         // Assumed sequential read speed
+    std::unordered_map<std::string, ModelStoreEntry> models;  // By model name
+};
+
+// Maps /api/tags models to their manifests and blobs under the Ollama models
+// directory, samples page-cache residency of each blob with mincore(), and
+// estimates how long a cold load would take.
+class ModelStore {
+public:
+    explicit ModelStore(const std::string& models_dir);
+    ~ModelStore();
+
+    ModelStore(const ModelStore&) = delete;
+    ModelStore& operator=(const ModelStore&) = delete;
+
+    ModelStoreInfo analyze(const std::vector<OllamaModel>& models);
+
+private:
+    struct Blob {
+        std::string path;
+        int64_t size = 0;
+        void* map = nullptr;         // Kept mapped between residency samples
+        double resident = -1.0;      // Fraction in page cache, -1 if unknown
+        int refs = 0;                // Manifests referencing this blob
+    };
+
+    std::string dir_;
+    uint64_t catalog_hash_ = 0;
+    std::unordered_map<std::string, Blob> blobs_;                      // By hex digest
+    std::unordered_map<std::string, std::vector<std::string>> model_blobs_;  // Name -> digests
+    std::chrono::steady_clock::time_point last_sample_;
+    std::string disk_kind_;
+    double disk_mb_s_ = 0.0;
+
+    void loadManifests(const std::vector<OllamaModel>& models);
+    void releaseBlobs();
+    void sampleResidency(Blob& blob);
+    void detectDisk();
+    std::string manifestPath(const std::string& name) const;
+};
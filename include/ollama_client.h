@@ -4,6 +4,11 @@
 #include <memory>
 #include <chrono>
 #include <cstdint>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
 
 struct OllamaModel {
     std::string name;
@@ -19,6 +24,22 @@ struct OllamaRunningModel {
     int64_t size;
     std::string expires_at;
     std::string digest;
+    int64_t size_vram = 0;
+    bool has_size_vram = false;  // Older servers don't report the split
+    int64_t context_length = 0;
+    
+    // Share of the model resident in VRAM (100 when the split is unknown)
+    double getGPUPercent() const {
+        if (!has_size_vram || size <= 0) {
+            return 100.0;
+        }
+        return 100.0 * static_cast<double>(size_vram) / static_cast<double>(size);
+    }
+    
+    // Any layers on the CPU mean a 5-20x throughput cliff
+    bool isPartiallyOffloaded() const {
+        return has_size_vram && size_vram < size;
+    }
     
     struct {
         std::string parent_model;
@@ -30,6 +51,30 @@ struct OllamaRunningModel {
     } details;
 };
 
+// Static model facts from /api/show; never changes for a given digest
+struct ModelMetadata {
+    std::string digest;
+    std::string architecture;
+    int64_t parameter_count = 0;
+    int64_t block_count = 0;
+    int64_t context_length = 0;     // Native (trained) context
+    int64_t embedding_length = 0;
+    int64_t head_count = 0;
+    int64_t head_count_kv = 0;
+    int64_t key_length = 0;
+    int64_t value_length = 0;
+    std::vector<std::string> capabilities;
+    
+    // f16 K+V cache size for the given context length, 0 if unknown
+    int64_t estimateKVCacheBytes(int64_t context) const {
+        int64_t kv_heads = head_count_kv > 0 ? head_count_kv : head_count;
+        int64_t head_dim = head_count > 0 ? embedding_length / head_count : 0;
+        int64_t k = key_length > 0 ? key_length : head_dim;
+        int64_t v = value_length > 0 ? value_length : head_dim;
+        return context * block_count * kv_heads * (k + v) * 2;
+    }
+};
+
 struct OllamaStatus {
     std::vector<OllamaRunningModel> models;
 };
@@ -39,23 +84,47 @@ public:
     OllamaClient(const std::string& base_url = "http://localhost:11434");
     ~OllamaClient();
 
+    // Liveness comes from /api/version probes; the constructor does no I/O
     bool isConnected() const;
+    bool probe();
+    
+    // Re-probe in the background; on_change runs on the probe thread
+    void startProbing(std::chrono::milliseconds interval, std::function<void(bool)> on_change);
+    void stopProbing();
     
     std::unique_ptr<OllamaStatus> getStatus();
-    std::vector<OllamaModel> getModels();
+    // complete, if given, is set when a whole models array came back, so an
+    // empty catalog can be told apart from a failed request
+    std::vector<OllamaModel> getModels(bool* complete = nullptr);
+    
+    // POST /api/show - slow, call off the render thread
+    std::unique_ptr<ModelMetadata> showModel(const std::string& name);
+    
+    // POST /api/generate without a prompt: loads the model if needed and
+    // resets its expiry. keep_alive_seconds < 0 keeps it loaded indefinitely;
+    // num_ctx > 0 matches the loaded context so a resident model isn't reloaded.
+    // Returns true once the server confirms; error holds a server-reported
+    // failure and stays empty on timeouts (large loads outlast the request).
+    bool keepAlive(const std::string& name, int64_t keep_alive_seconds, int64_t num_ctx, std::string& error);
 
 private:
     std::string base_url_;
-    bool connected_;
+    std::atomic<bool> connected_;
+    
+    std::thread probe_thread_;
+    std::mutex probe_mutex_;
+    std::condition_variable probe_cv_;
+    bool probe_stop_ = false;
     
-    bool testConnection();
     std::string makeRequest(const std::string& endpoint);
+    std::string makePostRequest(const std::string& endpoint, const std::string& body);
     std::vector<std::string> split(const std::string& s, char delimiter);
     std::string trim(const std::string& str);
     
     // Simple JSON parsing (since we want minimal dependencies)
     OllamaRunningModel parseRunningModel(const std::string& json_str);
     OllamaModel parseModel(const std::string& json_str);
+    ModelMetadata parseModelMetadata(const std::string& json_str);
     std::string extractStringValue(const std::string& json, const std::string& key);
     int64_t extractIntValue(const std::string& json, const std::string& key);
     std::vector<std::string> extractArrayValues(const std::string& json, const std::string& key);
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include "gpu_monitor.h"
+#include "ollama_client.h"
+
+enum class PlacementKind {
+    Unknown,    // Not in the catalog
+    Loaded,     // Already resident
+    Fits,       // Whole model on one GPU
+    Split,      // Layers spread over several GPUs
+    Offload,    // Partly in VRAM, rest on the CPU
+    CpuOnly,    // No usable VRAM at all
+};
+
+// Where Ollama would put a model if it were requested now
+struct Placement {
+    PlacementKind kind = PlacementKind::Unknown;
+    int64_t required_bytes = 0;       // Weights + KV cache + one device's overhead
+    int gpu = -1;                     // Fits: device index
+    int gpu_count = 0;                // Split: devices used
+    double gpu_percent = 0.0;         // Offload: share of the model in VRAM
+    std::vector<std::string> evicts;  // Resident models unloaded first, in order
+    bool kv_known = false;            // False: /api/show not fetched, weights only
+};
+
+// One entry of a what-if query
+struct PlannedModel {
+    std::string name;
+    Placement placement;
+};
+
+// Simulates Ollama's scheduler against the current GPUs and /api/ps state:
+// a model goes onto the single GPU with the most free VRAM if it fits, else
+// is split across all GPUs; if neither works and other models are loaded,
+// the one expiring soonest is unloaded and the fit retried; with nothing
+// left to unload, the remainder is offloaded to the CPU. The loaded-model
+// cap (OLLAMA_MAX_LOADED_MODELS, default 3 per GPU) forces evictions too.
+//
+// Per-device usage of resident models isn't reported, so eviction credits
+// each GPU in proportion to its used VRAM. A plan is a few passes over the
+// devices and residents, cheap enough to annotate the whole catalog per frame.
+class PlacementPlanner {
+public:
+    // /api/show facts for a catalog entry, nullptr if not fetched yet
+    using MetadataLookup = std::function<const ModelMetadata*(const OllamaModel&)>;
+
+    PlacementPlanner(const std::vector<GPUInfo>& gpus, const OllamaStatus* status);
+
+    bool hasGpus() const { return !devices_.empty(); }
+
+    // Context Ollama loads with unless asked otherwise ($OLLAMA_CONTEXT_LENGTH or 4096)
+    static int64_t defaultContext();
+    // VRAM for a model of `weights` bytes at `context` tokens, excluding device overhead
+    static int64_t estimateBytes(int64_t weights, const ModelMetadata* metadata, int64_t context);
+
+    // Where the model would go, without changing the simulated state
+    Placement plan(const std::string& name, int64_t bytes) const;
+    // Plan and apply, so the next query sees this model resident
+    Placement place(const std::string& name, int64_t bytes);
+
+    // Every catalog entry against the current state, at the default context
+    std::vector<Placement> planCatalog(const std::vector<OllamaModel>& catalog,
+                                       const MetadataLookup& metadata) const;
+    // Models separated by spaces or commas, each optionally name@context,
+    // placed in order so later entries see the earlier ones loaded
+    std::vector<PlannedModel> planQuery(const std::string& query, const std::vector<OllamaModel>& catalog,
+                                        const MetadataLookup& metadata);
+
+private:
+    struct Device {
+        int index = 0;
+        int64_t free = 0;
+        int64_t used = 0;
+    };
+    struct Resident {
+        std::string name;
+        int64_t vram = 0;
+        int64_t expires = 0;    // Unix time; unloaded soonest-first
+    };
+
+    std::vector<Device> devices_;
+    std::vector<Resident> residents_;  // In eviction order
+    size_t max_loaded_ = 3;
+
+    // evicted: leading residents unloaded; placed: VRAM the model ends up using
+    Placement simulate(const std::string& name, int64_t bytes, std::vector<Device>& devices,
+                       size_t& evicted, int64_t& placed) const;
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+// Per-user directory for small state files, created on demand:
+// %LOCALAPPDATA%\ollama-monitor on Windows, $XDG_CACHE_HOME/ollama-monitor
+// (or ~/.cache/ollama-monitor) elsewhere. Empty if none can be created.
+std::string cacheDirectory();
+
+// Ollama's model store: $OLLAMA_MODELS, else ~/.ollama/models, else the
+// system service's /usr/share/ollama/.ollama/models. Empty if none exists.
+std::string ollamaModelsDirectory();
+
+// Replace path with contents via <path>.tmp and a rename, so readers and
+// crashes see either the old file or the new one, never a partial or
+// missing one. False if the file couldn't be written.
+bool writeFileAtomically(const std::string& path, std::string_view contents);
+
+// This machine's host name, as agents report it to the aggregator
+std::string hostName();
+
+// Non-blocking TCP listener on every interface, dual-stack where IPv6
+// exists; -1 on failure. Linux only (always -1 elsewhere).
+int listenTcp(int port);
+
+// Unix time for an RFC 3339 timestamp as returned by Ollama
+// (2024-01-15T10:30:00.123456-07:00 or ...Z); 0 if it can't be parsed
+int64_t parseTimestamp(const std::string& text);
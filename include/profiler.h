@@ -0,0 +1,78 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+class FrameBuffer;
+
+// Self-profiler for --profile. Scoped timers add their elapsed time to the
+// current frame's per-stage totals; a replaced global operator new counts
+// allocations. Only the thread that called enable() (the event loop) is
+// measured, so background fetches don't show up as frame time. When
+// disabled a PROFILE_SCOPE costs one branch.
+namespace profiler {
+
+enum class Stage {
+    Frame,          // One refresh: collect + compose + write
+    GpuInfo,        // GPUMonitor::getGPUInfo
+    HostInfo,       // HostMonitor::getHostInfo
+    HttpRequest,    // Network round trips (count = requests)
+    ParseStatus,    // /api/ps JSON
+    ParseModels,    // /api/tags JSON
+    ParseMetrics,   // Prometheus expositions from --scrape
+    Compose,        // ConsoleUI building the frame text
+    TerminalWrite,  // Writing the frame to the terminal
+    Count
+};
+
+const char* stageName(Stage stage);
+
+void enable();
+bool enabled();
+
+void record(Stage stage, std::chrono::steady_clock::duration elapsed, uint64_t allocations = 0);
+
+// Heap allocations made so far by the calling thread
+uint64_t allocationCount();
+
+// Frame boundaries; endFrame() stores this frame's totals for the report
+void beginFrame();
+void endFrame();
+
+// One line summarizing the previous frame, for the on-screen overlay
+void appendOverlay(FrameBuffer& out);
+
+// Percentiles, histograms and allocations per frame as JSON
+bool writeReport(const std::string& path);
+
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Stage stage) : stage_(stage), active_(enabled()) {
+        if (active_) {
+            allocations_ = allocationCount();
+            start_ = std::chrono::steady_clock::now();
+        }
+    }
+    ~ScopedTimer() {
+        if (active_) {
+            record(stage_, std::chrono::steady_clock::now() - start_, allocationCount() - allocations_);
+        }
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Stage stage_;
+    bool active_;
+    uint64_t allocations_ = 0;
+    std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace profiler
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(stage) \
+    profiler::ScopedTimer PROFILE_CONCAT(profile_scope_, __LINE__)(profiler::Stage::stage)
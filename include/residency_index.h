@@ -0,0 +1,91 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <cstdint>
+#include "event_loop.h"
+#include "fleet_protocol.h"
+
+// `--residency-socket <path>`: which hosts have a model loaded, for request
+// routers. Fed from every node snapshot (the aggregator's agents, or this
+// host alone) and served over a local Unix socket. Each request and each
+// response is one SOCK_SEQPACKET message:
+//
+//   m <model>     hosts holding the model (name, bare name = :latest, or digest)
+//                 -> "ok <n>", then: host  vram_mb  expires_at  free_mb
+//   f <mb>        online hosts with at least <mb> MiB of free VRAM, most first
+//                 -> "ok <n>", then: host  free_mb  total_mb
+//   h <host>      one host -> "ok <n>", then "host  free_mb  total_mb  up|offline"
+//                 and per model: name  digest  vram_mb  expires_at
+//   s             -> "ok 1", then: hosts  online  models  updates
+//
+// Fields are tab-separated, lines end in '\n', errors are "err <reason>".
+// The inverted index (name and digest -> residences) is patched per snapshot
+// with only the models that appeared, left or changed, so a lookup is a hash
+// probe plus formatting into a reused buffer. Linux only.
+class ResidencyIndex {
+public:
+    struct Residence {
+        uint32_t host = 0;
+        int64_t vram_mb = 0;
+        int64_t expires_at = 0;     // Unix seconds, 0 if unknown
+    };
+
+    struct Host {
+        std::string name;
+        bool online = false;
+        int64_t free_mb = 0;        // Summed over the host's GPUs
+        int64_t total_mb = 0;
+        std::vector<fleet::ModelSample> models;  // As last reported
+    };
+
+    explicit ResidencyIndex(std::string socket_path);
+    ~ResidencyIndex();
+
+    ResidencyIndex(const ResidencyIndex&) = delete;
+    ResidencyIndex& operator=(const ResidencyIndex&) = delete;
+
+    bool start(EventLoop& loop);
+    const std::string& socketPath() const { return socket_path_; }
+
+    // Latest state of one host; offline hosts drop out of lookups
+    void update(const fleet::NodeSnapshot& snapshot, bool online);
+
+    // Residences of a model, or nullptr if it is loaded nowhere
+    const std::vector<Residence>* find(std::string_view model) const;
+    const Host* host(std::string_view name) const;
+    const std::vector<Host>& hosts() const { return hosts_; }
+
+    // Answer one request into response (reused, cleared first)
+    void query(std::string_view request, std::string& response);
+
+private:
+    // Lookups by string_view without building a key
+    struct Hash {
+        using is_transparent = void;
+        size_t operator()(std::string_view text) const { return std::hash<std::string_view>()(text); }
+    };
+    using Index = std::unordered_map<std::string, std::vector<Residence>, Hash, std::equal_to<>>;
+
+    std::string socket_path_;
+    int listen_fd_ = -1;
+    EventLoop* loop_ = nullptr;
+    std::vector<int> clients_;
+    std::string response_;
+
+    std::vector<Host> hosts_;       // Ids are indices and never reused
+    std::unordered_map<std::string, uint32_t, Hash, std::equal_to<>> host_ids_;
+    Index by_name_;
+    Index by_digest_;
+    std::vector<std::pair<int64_t, uint32_t>> ranked_;  // Scratch for 'f'
+    uint64_t updates_ = 0;
+
+    void add(Index& index, const std::string& key, const Residence& residence);
+    void remove(Index& index, const std::string& key, uint32_t host);
+    void accept();
+    void onReadable(int fd);
+    void close(int fd);
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include "console_ui.h"
+#include "shm_snapshot.h"
+
+// Publishes each collected DisplayInfo into the POSIX shared-memory segment
+// described in shm_snapshot.h. The segment is unlinked on destruction.
+class ShmPublisher {
+public:
+    explicit ShmPublisher(const std::string& name = ollama_monitor_shm::kDefaultName);
+    ~ShmPublisher();
+
+    ShmPublisher(const ShmPublisher&) = delete;
+    ShmPublisher& operator=(const ShmPublisher&) = delete;
+
+    bool isOpen() const { return segment_ != nullptr; }
+    void publish(const DisplayInfo& info);
+
+private:
+    std::string name_;
+    ollama_monitor_shm::Segment* segment_ = nullptr;
+    uint64_t catalog_hash_ = 0;
+    uint64_t catalog_version_ = 0;
+
+    void beginWrite();
+    void endWrite();
+};
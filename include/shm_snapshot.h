@@ -0,0 +1,154 @@
+#pragma once
+
+// Shared-memory snapshot published by `ollama-monitor --shm`.
+//
+// Self-contained so local tools can include it without the rest of the
+// monitor. The segment holds one fixed-layout Snapshot guarded by a seqlock:
+// the sequence is odd while the publisher writes and even once it is done,
+// so a reader copies the snapshot and retries if the sequence moved. After
+// open() a read involves no syscalls and no requests to Ollama.
+//
+//     ollama_monitor_shm::SnapshotReader reader;
+//     ollama_monitor_shm::Snapshot snap;
+//     if (reader.open() && reader.read(snap)) { ... snap.gpus[0].used_vram_bytes ... }
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace ollama_monitor_shm {
+
+constexpr const char* kDefaultName = "/ollama-monitor";
+constexpr uint32_t kMagic = 0x4e4f4d4f;  // "OMON"
+constexpr uint32_t kVersion = 1;
+constexpr int kMaxGpus = 16;
+constexpr int kMaxModels = 32;
+
+struct GpuRecord {
+    char name[64];
+    int32_t index;
+    int32_t temperature_c;
+    int32_t power_watts;
+    int32_t sm_clock_mhz;
+    uint64_t total_vram_bytes;
+    uint64_t used_vram_bytes;
+    float utilization_percent;
+    float memory_util_percent;
+    uint64_t throttle_reasons;
+};
+
+struct ModelRecord {
+    char name[128];
+    char digest[72];
+    int64_t size;
+    int64_t size_vram;
+    int64_t context_length;
+    int64_t expires_at;         // Unix seconds, 0 if unknown
+};
+
+struct Snapshot {
+    int64_t collected_at_ms;    // Unix milliseconds of the collection
+    int32_t publisher_pid;
+    uint32_t publisher_alive;   // Cleared when the monitor exits
+    uint32_t ollama_connected;
+    uint32_t gpu_count;
+    uint32_t model_count;
+    uint32_t catalog_model_count;
+    uint64_t catalog_version;   // Bumped whenever the installed catalog changes
+    GpuRecord gpus[kMaxGpus];
+    ModelRecord models[kMaxModels];
+};
+
+struct Segment {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;              // sizeof(Segment) of the publisher
+    uint32_t reserved;
+    std::atomic<uint64_t> sequence;
+    Snapshot snapshot;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "seqlock needs a lock-free 64-bit atomic");
+
+#if defined(__unix__) || defined(__APPLE__)
+
+class SnapshotReader {
+public:
+    SnapshotReader() = default;
+    ~SnapshotReader() { close(); }
+
+    SnapshotReader(const SnapshotReader&) = delete;
+    SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+    bool open(const char* name = kDefaultName) {
+        close();
+        int fd = shm_open(name, O_RDONLY, 0);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Segment)) {
+            ::close(fd);
+            return false;
+        }
+        void* addr = mmap(nullptr, sizeof(Segment), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED) {
+            return false;
+        }
+        segment_ = static_cast<const Segment*>(addr);
+        if (segment_->magic != kMagic || segment_->version != kVersion) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        if (segment_) {
+            munmap(const_cast<Segment*>(segment_), sizeof(Segment));
+            segment_ = nullptr;
+        }
+    }
+
+    bool isOpen() const { return segment_ != nullptr; }
+
+    // Consistent copy of the latest snapshot; false if the publisher kept
+    // writing through every attempt or nothing has been published yet
+    bool read(Snapshot& out, int max_attempts = 1000) const {
+        if (!segment_) {
+            return false;
+        }
+        for (int attempt = 0; attempt < max_attempts; attempt++) {
+            uint64_t before = segment_->sequence.load(std::memory_order_acquire);
+            if (before == 0 || (before & 1)) {
+                continue;
+            }
+            std::memcpy(&out, &segment_->snapshot, sizeof(Snapshot));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (segment_->sequence.load(std::memory_order_relaxed) == before) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Cheap change check: compare against the sequence of the last read
+    uint64_t sequence() const {
+        return segment_ ? segment_->sequence.load(std::memory_order_acquire) : 0;
+    }
+
+private:
+    const Segment* segment_ = nullptr;
+};
+
+#endif
+
+} // namespace ollama_monitor_shm
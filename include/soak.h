@@ -0,0 +1,118 @@
+#pragma once
+
+#include <string>
+#include <ostream>
+#include <streambuf>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+
+// `--soak <hours>`: the normal collect -> parse -> render loop, run for that
+// much simulated time against SoakServer with the event loop on a simulated
+// clock (EventLoop::simulateTime) and the frames discarded. SoakMonitor
+// samples the run once per script cycle (6 simulated hours) and fails it
+// when memory, allocations or CPU time per refresh grow past the limits.
+// Linux only.
+
+// Swallows everything written to the stream while in scope (the composed
+// frames, in place of the terminal)
+class DiscardOutput : private std::streambuf {
+public:
+    explicit DiscardOutput(std::ostream& stream) : stream_(stream), saved_(stream.rdbuf(this)) {}
+    ~DiscardOutput() { stream_.rdbuf(saved_); }
+
+    DiscardOutput(const DiscardOutput&) = delete;
+    DiscardOutput& operator=(const DiscardOutput&) = delete;
+
+private:
+    std::ostream& stream_;
+    std::streambuf* saved_;
+
+    int overflow(int c) override { return traits_type::not_eof(c); }
+    std::streamsize xsputn(const char*, std::streamsize count) override { return count; }
+};
+
+// Growth allowed over the baseline (the first cycle after warm-up)
+struct SoakLimits {
+    double rss_mb = 16;         // Resident set size, absolute
+    double allocs_pct = 25;     // Mean heap allocations per refresh
+    double cpu_pct = 100;       // Median thread CPU time per refresh
+};
+
+// "rss=<mb>,allocs=<pct>,cpu=<pct>", any subset, for --soak-limits
+bool parseSoakLimits(const std::string& text, SoakLimits& limits, std::string& error);
+
+// Scripted Ollama on 127.0.0.1, one thread, one request per connection.
+// The script is a function of the simulated time passed to setTime():
+// the catalog gains a new model and drops the oldest every 20 minutes,
+// the loaded set (1, 2, then 3 models) changes every 10, the server "restarts" (resets every
+// connection) for 10 minutes every 6 hours, and about 3% of responses are
+// malformed: truncated, HTML error pages, empty, mistyped, oversized or
+// binary.
+class SoakServer {
+public:
+    SoakServer() = default;
+    ~SoakServer();
+
+    SoakServer(const SoakServer&) = delete;
+    SoakServer& operator=(const SoakServer&) = delete;
+
+    bool start();
+    std::string url() const;
+
+    void setTime(int64_t simulated_seconds) { now_ = simulated_seconds; }
+
+    uint64_t requests() const { return requests_; }
+    uint64_t malformed() const { return malformed_; }
+    uint64_t refused() const { return refused_; }
+
+private:
+    int listen_fd_ = -1;
+    int port_ = 0;
+    std::thread thread_;
+    std::atomic<bool> stop_{false};
+    std::atomic<int64_t> now_{0};
+    std::atomic<uint64_t> requests_{0};
+    std::atomic<uint64_t> malformed_{0};
+    std::atomic<uint64_t> refused_{0};
+
+    void serve();
+    void handle(int fd);
+    std::string respond(const std::string& method, const std::string& path, const std::string& body, int& status);
+};
+
+class SoakMonitor {
+public:
+    SoakMonitor(const SoakLimits& limits, int64_t duration_seconds);
+
+    // Bracket each refresh on the loop thread. end() returns false once the
+    // run is over: the duration has passed or a limit was exceeded.
+    void begin();
+    bool end(int64_t simulated_seconds, const SoakServer& server);
+
+    bool passed() const { return failure_.empty(); }
+    const std::string& failure() const { return failure_; }
+
+private:
+    struct Window {
+        double rss_mb = 0;
+        double allocs = 0;      // Mean per refresh
+        double cpu_us = 0;      // Median per refresh
+    };
+
+    SoakLimits limits_;
+    int64_t duration_;
+    int64_t next_window_;
+    int windows_ = 0;
+    bool have_baseline_ = false;
+    Window baseline_;
+    std::string failure_;
+
+    uint64_t start_allocs_ = 0;
+    int64_t start_cpu_ns_ = 0;
+    uint64_t window_allocs_ = 0;
+    std::vector<int64_t> window_cpu_ns_;    // Reserved once, reused
+
+    void closeWindow(int64_t simulated_seconds, const SoakServer& server);
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <chrono>
+#include <cstdint>
+#include "event_loop.h"
+#include "gpu_monitor.h"
+
+struct DisplayInfo;
+
+// `--sse <port>`: embedded HTTP endpoint for dashboards.
+//
+//   GET /events    text/event-stream: a "snapshot" event on connect, then a
+//                  "delta" event per tick carrying only changed fields
+//   GET /snapshot  the current state as one JSON document
+//
+// State is kept flat (group, id, field) -> pre-serialized JSON value, so a
+// tick costs one comparison per field. Each event is serialized once into a
+// shared buffer that every subscriber's queue points at. A subscriber more
+// than a few events behind has its backlog replaced by one snapshot, so
+// slow dashboards are coalesced instead of buffered without bound. Linux only.
+class SseServer {
+public:
+    // Connections beyond max_clients are accepted and closed at once
+    SseServer(int port, size_t max_clients);
+    ~SseServer();
+
+    SseServer(const SseServer&) = delete;
+    SseServer& operator=(const SseServer&) = delete;
+
+    bool start(EventLoop& loop);
+    int port() const { return port_; }
+
+    // Full collection: GPUs, running models and Ollama status
+    void publish(const DisplayInfo& info);
+    // Fast tick between collections: GPUs only
+    void publishGpus(const std::vector<GPUInfo>& gpus);
+
+    size_t subscriberCount() const;
+
+private:
+    using Buffer = std::shared_ptr<const std::string>;
+    using Fields = std::map<std::string, std::string>;
+
+    struct Client {
+        std::string request;
+        bool streaming = false;
+        bool close_after = false;   // One-shot response
+        std::deque<Buffer> queue;
+        size_t offset = 0;          // Bytes of queue.front() already sent
+    };
+
+    int port_;
+    size_t max_clients_;
+    int listen_fd_ = -1;
+    EventLoop* loop_ = nullptr;
+    std::unordered_map<int, Client> clients_;
+
+    Fields state_;
+    uint64_t seq_ = 0;
+    Buffer snapshot_;               // Snapshot event for seq_, built on demand
+    std::chrono::steady_clock::time_point last_event_;
+
+    void accept();
+    void onEvent(int fd, bool readable, bool writable);
+    void handleRequest(int fd, Client& client);
+    void enqueue(int fd, Client& client, const Buffer& buffer);
+    void flush(int fd, Client& client);
+    void close(int fd);
+
+    // Replace the groups in `groups` with next; fan out the difference
+    void update(Fields& next, std::initializer_list<std::string_view> groups);
+    Buffer snapshotEvent();
+    std::string snapshotJson() const;
+    void broadcast(const Buffer& buffer);
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "console_ui.h"
+
+// Last successfully collected Ollama state, persisted to a small TSV file so
+// the first frame after startup (or during an outage) has something to show.
+// Restored data is marked stale until fresh data arrives.
+class StateCache {
+public:
+    // Loads the file if present; empty path disables persistence
+    explicit StateCache(const std::string& path);
+
+    bool hasState() const { return has_state_; }
+
+    // Remember a fresh collection; rewrites the file only when it changed
+    void update(const OllamaStatus& status, const std::vector<OllamaModel>& models);
+
+    // Fill the Ollama part of info with the last known state, marked stale
+    void restore(DisplayInfo& info) const;
+
+private:
+    std::string path_;
+    bool has_state_ = false;
+    int64_t saved_at_ = 0;     // Unix time of the last write
+    int64_t updated_at_ = 0;   // Unix time of the last fresh collection
+    OllamaStatus status_;
+    std::vector<OllamaModel> models_;
+    std::string serialized_;   // Body of the last write, to skip unchanged saves
+
+    void load();
+    std::string serialize() const;
+};
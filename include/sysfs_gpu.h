@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <chrono>
+#include "gpu_monitor.h"
+
+// Linux DRM/hwmon backend for amdgpu, i915 and xe devices.
+// Discovers cards under <root>/sys/class/drm once, keeps every metric file
+// open and re-reads it with pread() on each sample.
+class SysfsGPUBackend {
+public:
+    explicit SysfsGPUBackend(const std::string& root = "/");
+    ~SysfsGPUBackend();
+
+    SysfsGPUBackend(const SysfsGPUBackend&) = delete;
+    SysfsGPUBackend& operator=(const SysfsGPUBackend&) = delete;
+
+    bool discover();
+    bool hasDevices() const { return !devices_.empty(); }
+    size_t deviceCount() const { return devices_.size(); }
+    const std::string& pciSlot(size_t i) const { return devices_[i].pci_slot; }
+
+    // Appends one GPUInfo per discovered card, numbered from first_index
+    void sample(std::vector<GPUInfo>& infos, int first_index);
+
+private:
+    struct Device {
+        std::string name;
+        std::string driver;
+        std::string pci_slot;
+        int vram_total_fd = -1;
+        int vram_used_fd = -1;
+        int busy_fd = -1;
+        int mem_busy_fd = -1;
+        int temp_fd = -1;
+        int power_fd = -1;
+        int energy_fd = -1;
+
+        // Power derived from the energy counter when no power file exists
+        uint64_t last_energy_uj = 0;
+        std::chrono::steady_clock::time_point last_energy_at{};
+        int derived_power_mw = 0;
+    };
+
+    std::string root_;
+    std::vector<Device> devices_;
+
+    void closeDevice(Device& device);
+};
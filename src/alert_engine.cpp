@@ -0,0 +1,621 @@
+#include "../include/alert_engine.h"
+#include "../include/console_ui.h"
+#include "../include/platform.h"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+
+#ifdef _WIN32
+#include <stdlib.h>
+#else
+#include <spawn.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+extern char** environ;
+#endif
+
+// Pending actions beyond this are dropped
+static const size_t kMaxQueuedJobs = 256;
+// A hook still running after this is killed
+static const std::chrono::seconds kHookTimeout(10);
+// On exit, queued actions (a last "resolved", say) still run for this long
+static const std::chrono::seconds kDrainTimeout(5);
+
+// Metrics by scope; the scope column follows AlertEngine::Scope
+enum Metric {
+    GpuVramPercent, GpuVramUsedGb, GpuUtilization, GpuTemperature, GpuPower, GpuMemoryUtil,
+    GpuThrottled, GpuEccUncorrected, GpuXidErrors,
+    ModelOffloadPercent, ModelOffloaded, ModelVramGb, ModelSizeGb, ModelContext, ModelExpiresIn,
+    EndpointP50, EndpointP95, EndpointP99, EndpointRequestsPerMin, EndpointErrors,
+    HostCpu, HostIowait, HostMem, HostSwapUsedGb, HostCpuPressure, HostMemPressure, HostIoPressure,
+    OllamaUp, OllamaRunning, OllamaInstalled,
+    MetricCount
+};
+static_assert(MetricCount <= 64, "metric masks are 64 bits");
+
+struct MetricDef {
+    int scope;
+    const char* name;
+};
+
+static const MetricDef kMetrics[MetricCount] = {
+    {0, "vram_percent"}, {0, "vram_used_gb"}, {0, "utilization"}, {0, "temperature"}, {0, "power"},
+    {0, "memory_util"}, {0, "throttled"}, {0, "ecc_uncorrected"}, {0, "xid_errors"},
+    {1, "offload_percent"}, {1, "offloaded"}, {1, "vram_gb"}, {1, "size_gb"}, {1, "context"},
+    {1, "expires_in_s"},
+    {2, "p50_ms"}, {2, "p95_ms"}, {2, "p99_ms"}, {2, "requests_per_min"}, {2, "errors"},
+    {3, "cpu_percent"}, {3, "iowait_percent"}, {3, "mem_percent"}, {3, "swap_used_gb"},
+    {3, "cpu_pressure"}, {3, "mem_pressure"}, {3, "io_pressure"},
+    {4, "up"}, {4, "running_models"}, {4, "installed_models"},
+};
+
+static const char* const kScopeNames[] = {"gpu", "model", "endpoint", "host", "ollama"};
+
+static constexpr uint64_t bit(int metric) {
+    return uint64_t(1) << metric;
+}
+
+static std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+        s.remove_prefix(1);
+    }
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r')) {
+        s.remove_suffix(1);
+    }
+    return s;
+}
+
+// Next whitespace-separated token; operators split from their operands and
+// a [filter] is kept whole even with spaces inside
+static std::string_view nextToken(std::string_view& s) {
+    s = trim(s);
+    if (s.empty()) {
+        return {};
+    }
+    size_t i = 0;
+    if (s[0] == '<' || s[0] == '>' || s[0] == '=' || s[0] == '!') {
+        i = s.size() > 1 && s[1] == '=' ? 2 : 1;
+    } else {
+        bool in_filter = false;
+        while (i < s.size()) {
+            char c = s[i];
+            if (c == '[') {
+                in_filter = true;
+            } else if (c == ']') {
+                in_filter = false;
+            } else if (!in_filter && (c == ' ' || c == '\t' || c == '<' || c == '>' || c == '=' || c == '!')) {
+                break;
+            }
+            i++;
+        }
+    }
+    std::string_view token = s.substr(0, i);
+    s.remove_prefix(i);
+    return token;
+}
+
+// "95", "95%", "2s", "250ms", "1.5" - time suffixes convert to the metric's
+// unit (milliseconds for *_ms metrics, seconds otherwise)
+static bool parseValue(std::string_view text, bool millis, double& value) {
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (result.ec != std::errc() || result.ptr == text.data()) {
+        return false;
+    }
+    std::string_view unit(result.ptr, static_cast<size_t>(text.data() + text.size() - result.ptr));
+    double seconds = 0.0;
+    if (unit.empty() || unit == "%") {
+        return true;
+    } else if (unit == "ms") {
+        seconds = 1e-3;
+    } else if (unit == "s") {
+        seconds = 1;
+    } else if (unit == "m") {
+        seconds = 60;
+    } else if (unit == "h") {
+        seconds = 3600;
+    } else {
+        return false;
+    }
+    value *= millis ? seconds * 1000 : seconds;
+    return true;
+}
+
+static bool test(int op, double value, double threshold) {
+    switch (op) {
+        case 0: return value > threshold;
+        case 1: return value >= threshold;
+        case 2: return value < threshold;
+        case 3: return value <= threshold;
+        case 4: return value == threshold;
+        case 5: return value != threshold;
+        default: return value != 0.0;
+    }
+}
+
+AlertEngine::AlertEngine() {
+    worker_ = std::thread(&AlertEngine::workerLoop, this);
+}
+
+AlertEngine::~AlertEngine() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    worker_.join();
+}
+
+bool AlertEngine::load(const std::string& path, std::string& error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot read " + path;
+        return false;
+    }
+    std::string line;
+    int number = 0;
+    while (std::getline(in, line)) {
+        number++;
+        std::string_view text = trim(line);
+        if (text.empty() || text[0] == '#') {
+            continue;
+        }
+        Rule rule;
+        if (!parseRule(text, rule, error)) {
+            error = path + ":" + std::to_string(number) + ": " + error;
+            return false;
+        }
+        rules_.push_back(std::move(rule));
+    }
+
+    // Compile: which rules each scope's sample has to serve, and which of its
+    // metrics they read (only worth checking for the costly ones)
+    for (size_t i = 0; i < rules_.size(); i++) {
+        size_t scope = static_cast<size_t>(rules_[i].scope);
+        rules_by_scope_[scope].push_back(i);
+        for (const auto& condition : rules_[i].conditions) {
+            metrics_by_scope_[scope] |= bit(condition.metric);
+        }
+    }
+    return true;
+}
+
+bool AlertEngine::parseRule(std::string_view line, Rule& rule, std::string& error) {
+    size_t colon = line.find(':');
+    if (colon == std::string_view::npos || trim(line.substr(0, colon)).empty()) {
+        error = "expected 'name: condition => action'";
+        return false;
+    }
+    rule.name = std::string(trim(line.substr(0, colon)));
+    std::string_view rest = line.substr(colon + 1);
+
+    std::string_view action;
+    size_t arrow = rest.find("=>");
+    if (arrow != std::string_view::npos) {
+        action = trim(rest.substr(arrow + 2));
+        rest = rest.substr(0, arrow);
+    }
+
+    bool have_scope = false;
+    for (;;) {
+        // scope[filter].metric
+        std::string_view token = nextToken(rest);
+        size_t dot = token.rfind('.');
+        if (token.empty() || dot == std::string_view::npos) {
+            error = "expected scope.metric, got '" + std::string(token) + "'";
+            return false;
+        }
+        std::string_view scope_text = token.substr(0, dot);
+        std::string_view metric_text = token.substr(dot + 1);
+        std::string_view filter;
+        size_t open = scope_text.find('[');
+        if (open != std::string_view::npos) {
+            if (scope_text.back() != ']') {
+                error = "unterminated filter in '" + std::string(token) + "'";
+                return false;
+            }
+            filter = scope_text.substr(open + 1, scope_text.size() - open - 2);
+            scope_text = scope_text.substr(0, open);
+        }
+
+        int scope = -1;
+        for (int s = 0; s < static_cast<int>(Scope::Count); s++) {
+            if (scope_text == kScopeNames[s]) {
+                scope = s;
+            }
+        }
+        int metric = -1;
+        for (int m = 0; m < MetricCount; m++) {
+            if (kMetrics[m].scope == scope && metric_text == kMetrics[m].name) {
+                metric = m;
+            }
+        }
+        if (scope < 0 || metric < 0) {
+            error = "unknown metric '" + std::string(token) + "'";
+            return false;
+        }
+        if (have_scope && static_cast<int>(rule.scope) != scope) {
+            error = "all conditions of a rule must use the same scope";
+            return false;
+        }
+        if (!filter.empty()) {
+            rule.filter = std::string(filter);
+        }
+        rule.scope = static_cast<Scope>(scope);
+        have_scope = true;
+
+        Condition condition;
+        condition.metric = metric;
+        bool millis = metric_text.size() > 3 && metric_text.substr(metric_text.size() - 3) == "_ms";
+
+        std::string_view next = nextToken(rest);
+        static const char* const kOps[] = {">", ">=", "<", "<=", "==", "!="};
+        for (int op = 0; op < 6; op++) {
+            if (next == kOps[op]) {
+                condition.op = static_cast<Op>(op);
+            }
+        }
+        if (condition.op != Op::Truthy) {
+            std::string_view value = nextToken(rest);
+            if (!parseValue(value, millis, condition.threshold)) {
+                error = "bad value '" + std::string(value) + "'";
+                return false;
+            }
+            condition.clear = condition.threshold;
+            next = nextToken(rest);
+            if (next == "clear") {
+                value = nextToken(rest);
+                if (!parseValue(value, millis, condition.clear)) {
+                    error = "bad clear value '" + std::string(value) + "'";
+                    return false;
+                }
+                next = nextToken(rest);
+            }
+        }
+        rule.conditions.push_back(condition);
+
+        if (next == "and") {
+            continue;
+        }
+        if (next == "for") {
+            std::string_view value = nextToken(rest);
+            double ms = 0;
+            if (!parseValue(value, true, ms) || ms < 0) {
+                error = "bad duration '" + std::string(value) + "'";
+                return false;
+            }
+            rule.hold = std::chrono::milliseconds(static_cast<int64_t>(ms));
+            next = nextToken(rest);
+        }
+        if (!next.empty()) {
+            error = "unexpected '" + std::string(next) + "'";
+            return false;
+        }
+        break;
+    }
+
+    if (action.empty() || action == "none") {
+        rule.action = ActionKind::None;
+    } else if (action.substr(0, 5) == "exec ") {
+        rule.action = ActionKind::Exec;
+        rule.target = std::string(trim(action.substr(5)));
+    } else if (action.substr(0, 4) == "log ") {
+        rule.action = ActionKind::Log;
+        rule.target = std::string(trim(action.substr(4)));
+    } else {
+        error = "action must be 'exec <command>', 'log <path>' or 'none'";
+        return false;
+    }
+    return true;
+}
+
+std::vector<ActiveAlert> AlertEngine::evaluate(const DisplayInfo& info) {
+    auto now = std::chrono::steady_clock::now();
+    int64_t unix_now = static_cast<int64_t>(time(nullptr));
+    generation_++;
+    bool evaluated[static_cast<size_t>(Scope::Count)] = {};
+    double v[MetricCount] = {};
+
+    auto wants = [this](Scope scope) { return !rules_by_scope_[static_cast<size_t>(scope)].empty(); };
+    auto uses = [this](Scope scope, int metric) {
+        return (metrics_by_scope_[static_cast<size_t>(scope)] & bit(metric)) != 0;
+    };
+
+    if (wants(Scope::Gpu)) {
+        evaluated[static_cast<size_t>(Scope::Gpu)] = true;
+        for (const auto& gpu : info.gpu_infos) {
+            if (!gpu.available) {
+                continue;
+            }
+            v[GpuVramPercent] = gpu.getVRAMUsagePercent();
+            v[GpuVramUsedGb] = gpu.used_vram_gb;
+            v[GpuUtilization] = gpu.utilization_percent;
+            v[GpuTemperature] = gpu.temperature_c;
+            v[GpuPower] = gpu.power_watts;
+            v[GpuMemoryUtil] = gpu.memory_util_percent;
+            v[GpuThrottled] = gpu.throttle_reasons != 0 ? 1 : 0;
+            v[GpuEccUncorrected] = static_cast<double>(gpu.ecc_uncorrected);
+            v[GpuXidErrors] = gpu.xid_errors;
+            evaluateInstance(Scope::Gpu, "gpu" + std::to_string(gpu.index) + ":" + gpu.name, v, now, unix_now);
+        }
+    }
+
+    // Stale model lists would resolve alerts the server may still have; hold them
+    if (wants(Scope::Model) && info.ollama_status && !info.stale) {
+        evaluated[static_cast<size_t>(Scope::Model)] = true;
+        for (const auto& model : info.ollama_status->models) {
+            v[ModelOffloadPercent] = 100.0 - model.getGPUPercent();
+            v[ModelOffloaded] = model.isPartiallyOffloaded() ? 1 : 0;
+            v[ModelVramGb] = static_cast<double>(model.has_size_vram ? model.size_vram : model.size) / (1 << 30);
+            v[ModelSizeGb] = static_cast<double>(model.size) / (1 << 30);
+            v[ModelContext] = static_cast<double>(model.context_length);
+            if (uses(Scope::Model, ModelExpiresIn)) {
+                int64_t expires = parseTimestamp(model.expires_at);
+                v[ModelExpiresIn] = expires > 0 ? static_cast<double>(expires - unix_now) : 0.0;
+            }
+            evaluateInstance(Scope::Model, model.name, v, now, unix_now);
+        }
+    }
+
+    if (wants(Scope::Endpoint) && info.log_stats.active) {
+        evaluated[static_cast<size_t>(Scope::Endpoint)] = true;
+        for (const auto& endpoint : info.log_stats.endpoints) {
+            v[EndpointP50] = endpoint.p50_ms;
+            v[EndpointP95] = endpoint.p95_ms;
+            v[EndpointP99] = endpoint.p99_ms;
+            v[EndpointRequestsPerMin] = endpoint.requests_per_min;
+            v[EndpointErrors] = static_cast<double>(endpoint.errors);
+            evaluateInstance(Scope::Endpoint, endpoint.endpoint, v, now, unix_now);
+        }
+    }
+
+    if (wants(Scope::Host) && info.host_info.available) {
+        evaluated[static_cast<size_t>(Scope::Host)] = true;
+        const auto& host = info.host_info;
+        v[HostCpu] = host.cpu_percent;
+        v[HostIowait] = host.iowait_percent;
+        v[HostMem] = host.getMemUsagePercent();
+        v[HostSwapUsedGb] = static_cast<double>(host.swap_total_bytes - host.swap_free_bytes) / (1 << 30);
+        v[HostCpuPressure] = host.cpu_pressure_some;
+        v[HostMemPressure] = host.mem_pressure_some;
+        v[HostIoPressure] = host.io_pressure_some;
+        evaluateInstance(Scope::Host, "host", v, now, unix_now);
+    }
+
+    if (wants(Scope::Ollama)) {
+        evaluated[static_cast<size_t>(Scope::Ollama)] = true;
+        bool up = info.ollama_status && !info.stale;
+        v[OllamaUp] = up ? 1 : 0;
+        v[OllamaRunning] = up ? static_cast<double>(info.ollama_status->models.size()) : 0.0;
+        v[OllamaInstalled] = static_cast<double>(info.available_models.size());
+        evaluateInstance(Scope::Ollama, "ollama", v, now, unix_now);
+    }
+
+    // Instances gone from a scope that was sampled (unloaded model, removed
+    // GPU) resolve; scopes that weren't sampled keep their state
+    std::vector<ActiveAlert> active;
+    for (auto it = states_.begin(); it != states_.end();) {
+        State& state = it->second;
+        const Rule& rule = rules_[state.rule];
+        if (state.seen != generation_ && evaluated[static_cast<size_t>(rule.scope)]) {
+            if (state.firing) {
+                notify(rule, state, false, unix_now);
+            }
+            it = states_.erase(it);
+            continue;
+        }
+        if (state.firing) {
+            active.push_back({rule.name, state.instance, state.value, state.fired_at});
+        }
+        ++it;
+    }
+    std::sort(active.begin(), active.end(), [](const ActiveAlert& a, const ActiveAlert& b) {
+        return a.since != b.since ? a.since < b.since : a.rule < b.rule;
+    });
+    return active;
+}
+
+void AlertEngine::evaluateInstance(Scope scope, const std::string& instance, const double* values,
+                                   std::chrono::steady_clock::time_point now, int64_t unix_now) {
+    for (size_t index : rules_by_scope_[static_cast<size_t>(scope)]) {
+        const Rule& rule = rules_[index];
+        if (!rule.filter.empty() && instance.find(rule.filter) == std::string::npos) {
+            continue;
+        }
+
+        bool held = true;
+        bool cleared = false;
+        for (const auto& condition : rule.conditions) {
+            double value = values[condition.metric];
+            held = held && test(static_cast<int>(condition.op), value, condition.threshold);
+            cleared = cleared || !test(static_cast<int>(condition.op), value, condition.clear);
+        }
+
+        std::string key = std::to_string(index);
+        key.push_back('\x1f');
+        key += instance;
+        auto found = states_.find(key);
+        if (found == states_.end()) {
+            if (!held) {
+                continue;  // Only track instances that are or may become active
+            }
+            found = states_.emplace(std::move(key), State()).first;
+            found->second.rule = index;
+            found->second.instance = instance;
+        }
+        State& state = found->second;
+        state.seen = generation_;
+        state.value = values[rule.conditions.front().metric];
+
+        if (state.firing) {
+            if (cleared) {
+                state.firing = false;
+                state.pending = false;
+                notify(rule, state, false, unix_now);
+            }
+        } else if (held) {
+            if (!state.pending) {
+                state.pending = true;
+                state.pending_since = now;
+            }
+            if (now - state.pending_since >= rule.hold) {
+                state.firing = true;
+                state.fired_at = unix_now;
+                notify(rule, state, true, unix_now);
+            }
+        } else {
+            state.pending = false;
+        }
+    }
+}
+
+void AlertEngine::notify(const Rule& rule, const State& state, bool firing, int64_t unix_now) {
+    if (rule.action == ActionKind::None) {
+        return;
+    }
+    Job job;
+    job.kind = rule.action;
+    job.target = rule.target;
+    job.rule = rule.name;
+    job.instance = state.instance;
+    job.state = firing ? "firing" : "resolved";
+    job.value = state.value;
+    job.threshold = rule.conditions.front().threshold;
+    job.time = unix_now;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (jobs_.size() >= kMaxQueuedJobs) {
+            dropped_++;
+            return;
+        }
+        jobs_.push_back(std::move(job));
+    }
+    cv_.notify_one();
+}
+
+uint64_t AlertEngine::droppedActions() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return dropped_;
+}
+
+void AlertEngine::workerLoop() {
+    std::chrono::steady_clock::time_point drain_until{};
+    for (;;) {
+        Job job;
+        auto now = std::chrono::steady_clock::now();
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+            if (stopping_ && drain_until == std::chrono::steady_clock::time_point{}) {
+                drain_until = now + kDrainTimeout;
+            }
+            // Drain what was queued before shutdown, within the deadline
+            if (stopping_ && (jobs_.empty() || now >= drain_until)) {
+                dropped_ += jobs_.size();
+                jobs_.clear();
+                return;
+            }
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+        auto deadline = now + kHookTimeout;
+        if (drain_until != std::chrono::steady_clock::time_point{} && drain_until < deadline) {
+            deadline = drain_until;
+        }
+        runJob(job, deadline);
+    }
+}
+
+void AlertEngine::runJob(const Job& job, std::chrono::steady_clock::time_point deadline) {
+    char value[32];
+    char threshold[32];
+    auto v = std::to_chars(value, value + sizeof(value) - 1, job.value, std::chars_format::general, 6);
+    *v.ptr = '\0';
+    auto t = std::to_chars(threshold, threshold + sizeof(threshold) - 1, job.threshold, std::chars_format::general, 6);
+    *t.ptr = '\0';
+
+    if (job.kind == ActionKind::Log) {
+        char stamp[32];
+        time_t when = static_cast<time_t>(job.time);
+        struct tm utc;
+#ifdef _WIN32
+        gmtime_s(&utc, &when);
+#else
+        gmtime_r(&when, &utc);
+#endif
+        strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%SZ", &utc);
+        std::ofstream out(job.target, std::ios::app);
+        out << stamp << '\t' << job.state << '\t' << job.rule << '\t' << job.instance
+            << "\tvalue=" << value << "\tthreshold=" << threshold << '\n';
+        return;
+    }
+
+    // Hooks read the alert from the environment
+    std::string vars[] = {
+        "ALERT_NAME=" + job.rule,
+        "ALERT_STATE=" + job.state,
+        "ALERT_INSTANCE=" + job.instance,
+        std::string("ALERT_VALUE=") + value,
+        std::string("ALERT_THRESHOLD=") + threshold,
+    };
+
+#ifdef _WIN32
+    for (const auto& var : vars) {
+        size_t eq = var.find('=');
+        _putenv_s(var.substr(0, eq).c_str(), var.c_str() + eq + 1);
+    }
+    (void)deadline;  // std::system can't be timed out
+    std::system(job.target.c_str());
+#else
+    std::vector<char*> env;
+    for (char** e = environ; *e; e++) {
+        env.push_back(*e);
+    }
+    for (auto& var : vars) {
+        env.push_back(var.data());
+    }
+    env.push_back(nullptr);
+
+    // The event loop blocks SIGINT/SIGTERM; hooks get default handling back
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t none;
+    sigset_t defaults;
+    sigemptyset(&none);
+    sigemptyset(&defaults);
+    sigaddset(&defaults, SIGINT);
+    sigaddset(&defaults, SIGTERM);
+    sigaddset(&defaults, SIGPIPE);
+    posix_spawnattr_setsigmask(&attr, &none);
+    posix_spawnattr_setsigdefault(&attr, &defaults);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+    std::string command = job.target;
+    char sh[] = "/bin/sh";
+    char dash_c[] = "-c";
+    char* argv[] = {sh, dash_c, command.data(), nullptr};
+    pid_t pid;
+    int rc = posix_spawn(&pid, "/bin/sh", nullptr, &attr, argv, env.data());
+    posix_spawnattr_destroy(&attr);
+    if (rc != 0) {
+        return;
+    }
+
+    for (;;) {
+        int status;
+        pid_t done = waitpid(pid, &status, WNOHANG);
+        if (done == pid || (done < 0 && errno != EINTR)) {
+            return;
+        }
+        if (std::chrono::steady_clock::now() >= deadline) {
+            kill(pid, SIGKILL);
+            waitpid(pid, &status, 0);
+            return;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+#endif
+}
@@ -0,0 +1,201 @@
+#include "../include/catalog_watcher.h"
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <dirent.h>
+#include <unistd.h>
+#endif
+
+// Quiet time after the last manifest event before refreshing; a pull
+// writes the manifest once, a copy or delete touches a few files
+static const std::chrono::milliseconds kDebounce(500);
+// Catalog polling (and watch retry) when the tree can't be watched
+static const std::chrono::seconds kPollInterval(60);
+// Refresh even without events: network filesystems don't report writes
+// made by other hosts, and the server may not use the local models directory
+static const std::chrono::minutes kResyncInterval(10);
+
+#ifdef __linux__
+// Any entry appearing, being rewritten or going away changes the catalog
+static const uint32_t kWatchMask = IN_CREATE | IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM |
+                                   IN_DELETE | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+#endif
+
+CatalogWatcher::CatalogWatcher(const std::string& models_dir)
+    : root_(models_dir.empty() ? "" : models_dir + "/manifests") {}
+
+CatalogWatcher::~CatalogWatcher() {
+#ifdef __linux__
+    if (inotify_fd_ >= 0) {
+        close(inotify_fd_);
+    }
+#endif
+}
+
+bool CatalogWatcher::start(EventLoop& loop) {
+    loop_ = &loop;
+    last_attempt_ = loop.now();
+    return watch();
+}
+
+bool CatalogWatcher::refreshDue() {
+    auto now = loop_ ? loop_->now() : std::chrono::steady_clock::now();
+    if (!due(now)) {
+        return false;
+    }
+    // The fetch runs on another thread; what changes meanwhile isn't in its answer
+    requested_at_ = now;
+    requested_generation_ = generation_;
+    return true;
+}
+
+bool CatalogWatcher::due(std::chrono::steady_clock::time_point now) {
+    if (!fetched_) {
+        return true;
+    }
+    if (!watching()) {
+        if (now - last_fetch_ < kPollInterval) {
+            return false;
+        }
+        // The tree may exist or be readable by now
+        if (loop_ && now - last_attempt_ >= kPollInterval) {
+            last_attempt_ = now;
+            watch();
+        }
+        return true;
+    }
+    if (changed_ && now - last_change_ >= kDebounce) {
+        return true;
+    }
+    return now - last_fetch_ >= kResyncInterval;
+}
+
+void CatalogWatcher::refreshed(bool ok) {
+    if (!ok) {
+        fetched_ = false;
+        return;
+    }
+    // Changes or an invalidate() after the request still need a fetch
+    fetched_ = invalidated_generation_ <= requested_generation_;
+    if (generation_ == requested_generation_) {
+        changed_ = false;
+    }
+    last_fetch_ = requested_at_;
+}
+
+void CatalogWatcher::invalidate() {
+    fetched_ = false;
+    invalidated_generation_ = ++generation_;
+}
+
+#ifdef __linux__
+
+bool CatalogWatcher::watch() {
+    if (root_.empty() || !loop_) {
+        return false;
+    }
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd_ < 0) {
+        return false;
+    }
+    addTree(root_);
+    if (root_wd_ < 0 || !loop_->watchFd(inotify_fd_, true, false, [this](bool, bool) { onInotify(); })) {
+        unwatch();
+        return false;
+    }
+    return true;
+}
+
+void CatalogWatcher::unwatch() {
+    if (inotify_fd_ >= 0) {
+        if (loop_) {
+            loop_->unwatchFd(inotify_fd_);
+        }
+        close(inotify_fd_);
+        inotify_fd_ = -1;
+    }
+    root_wd_ = -1;
+    dirs_.clear();
+}
+
+// Watch dir and every directory below it (registry/namespace/model)
+void CatalogWatcher::addTree(const std::string& dir) {
+    // Only the root may be a symlink (a relocated manifests directory)
+    uint32_t mask = kWatchMask | (dir == root_ ? 0 : IN_DONT_FOLLOW);
+    int wd = inotify_add_watch(inotify_fd_, dir.c_str(), mask);
+    if (wd < 0) {
+        return;
+    }
+    dirs_[wd] = dir;
+    if (dir == root_) {
+        root_wd_ = wd;
+    }
+
+    DIR* entries = opendir(dir.c_str());
+    if (!entries) {
+        return;
+    }
+    while (struct dirent* entry = readdir(entries)) {
+        // Filesystems without d_type report DT_UNKNOWN; IN_ONLYDIR sorts it out
+        if ((entry->d_type == DT_DIR || entry->d_type == DT_UNKNOWN) && entry->d_name[0] != '.') {
+            addTree(dir + "/" + entry->d_name);
+        }
+    }
+    closedir(entries);
+}
+
+void CatalogWatcher::onInotify() {
+    alignas(struct inotify_event) char events[4096];
+    bool rewatch = false;
+    bool any = false;
+
+    ssize_t n;
+    while (inotify_fd_ >= 0 && (n = read(inotify_fd_, events, sizeof(events))) > 0) {
+        for (char* p = events; p < events + n;) {
+            auto* event = reinterpret_cast<struct inotify_event*>(p);
+            p += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                // Events were dropped, new directories among them perhaps
+                rewatch = true;
+            } else if (event->mask & IN_IGNORED) {
+                rewatch = rewatch || event->wd == root_wd_;
+                dirs_.erase(event->wd);
+                continue;
+            } else if ((event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO)) && event->len > 0) {
+                // A new model or namespace; its tags may already be inside
+                auto dir = dirs_.find(event->wd);
+                if (dir != dirs_.end()) {
+                    addTree(dir->second + "/" + event->name);
+                }
+            }
+            any = true;
+        }
+    }
+
+    if (any || rewatch) {
+        changed_ = true;
+        generation_++;
+        last_change_ = loop_->now();
+    }
+    // Root gone (falls back to polling) or events lost: start over
+    if (rewatch) {
+        unwatch();
+        last_attempt_ = loop_->now();
+        watch();
+    }
+}
+
+#else
+
+bool CatalogWatcher::watch() {
+    return false;
+}
+
+void CatalogWatcher::unwatch() {}
+
+void CatalogWatcher::addTree(const std::string&) {}
+
+void CatalogWatcher::onInotify() {}
+
+#endif
@@ -1,12 +1,20 @@
 #include "../include/console_ui.h"
+#include "../include/platform.h"
+#include "../include/profiler.h"
 #include <iostream>
-#include <iomanip>
-#include <sstream>
+#include <cstdio>
 #include <ctime>
 #include <chrono>
 
 #ifdef _WIN32
 #include <windows.h>
+#else
+#include <termios.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+// Terminal settings to restore when keyboard input was enabled
+static struct termios g_saved_termios;
 #endif
 
 ConsoleUI::ConsoleUI() : refresh_rate_(1), no_clear_(false) {
@@ -21,135 +29,326 @@ ConsoleUI::ConsoleUI() : refresh_rate_(1), no_clear_(false) {
     // Set console title
     SetConsoleTitleA("Ollama Monitor");
 #endif
+    updateTerminalSize();
 }
 
 ConsoleUI::~ConsoleUI() {
+    if (wrap_disabled_) {
+        std::cout << "\033[?7h" << std::flush;
+    }
+#ifndef _WIN32
+    if (keyboard_enabled_) {
+        tcsetattr(STDIN_FILENO, TCSANOW, &g_saved_termios);
+    }
+#endif
+}
+
+bool ConsoleUI::enableKeyboardInput() {
+#ifndef _WIN32
+    if (keyboard_enabled_) {
+        return true;
+    }
+    if (!isatty(STDIN_FILENO) || tcgetattr(STDIN_FILENO, &g_saved_termios) != 0) {
+        return false;
+    }
+    
+    // No line buffering or echo; reads return immediately when empty
+    struct termios raw = g_saved_termios;
+    raw.c_lflag &= ~static_cast<tcflag_t>(ICANON | ECHO);
+    raw.c_cc[VMIN] = 0;
+    raw.c_cc[VTIME] = 0;
+    if (tcsetattr(STDIN_FILENO, TCSANOW, &raw) != 0) {
+        return false;
+    }
+    keyboard_enabled_ = true;
+    return true;
+#else
+    return false;
+#endif
+}
+
+int ConsoleUI::keyboardFd() const {
+#ifndef _WIN32
+    return keyboard_enabled_ ? STDIN_FILENO : -1;
+#else
+    return -1;
+#endif
+}
+
+int ConsoleUI::readKey() {
+#ifndef _WIN32
+    unsigned char c;
+    if (keyboard_enabled_ && read(STDIN_FILENO, &c, 1) == 1) {
+        // Arrow keys arrive in one piece as ESC [ A-D (ESC O A-D in application mode)
+        unsigned char seq[2];
+        if (c == 27 && read(STDIN_FILENO, seq, 2) == 2 && (seq[0] == '[' || seq[0] == 'O') &&
+            seq[1] >= 'A' && seq[1] <= 'D') {
+            return kKeyUp + (seq[1] - 'A');
+        }
+        return c;
+    }
+#endif
+    return -1;
+}
+
+void ConsoleUI::updateTerminalSize() {
+    int rows = 0;
+    int cols = 0;
+#ifdef _WIN32
+    CONSOLE_SCREEN_BUFFER_INFO csbi;
+    if (GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &csbi)) {
+        rows = csbi.srWindow.Bottom - csbi.srWindow.Top + 1;
+        cols = csbi.srWindow.Right - csbi.srWindow.Left + 1;
+    }
+#else
+    struct winsize ws = {};
+    if (isatty(STDOUT_FILENO) && ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0) {
+        rows = ws.ws_row;
+        cols = ws.ws_col;
+    }
+#endif
+    if (rows != rows_ || cols != cols_) {
+        rows_ = rows;
+        cols_ = cols;
+        full_redraw_ = true;
+    }
+}
+
+void ConsoleUI::cycleHeatMetric() {
+    heat_metric_ = static_cast<HeatMetric>((static_cast<int>(heat_metric_) + 1) % static_cast<int>(HeatMetric::Count));
 }
 
 void ConsoleUI::moveCursorHome() {
     // Move cursor to top-left without clearing - prevents flicker
-    std::cout << "\033[H";
-    std::cout.flush();
+    frame_ << "\033[H";
 }
 
 void ConsoleUI::clearToEndOfScreen() {
     // Clear from cursor to end of screen - removes any leftover content
-    std::cout << "\033[J";
-    std::cout.flush();
+    frame_ << "\033[J";
 }
 
 void ConsoleUI::clearLine() {
     // Clear from cursor to end of line
-    std::cout << "\033[K";
+    frame_ << "\033[K";
 }
 
-std::string ConsoleUI::formatBytes(int64_t bytes) const {
-    const char* units[] = {"B", "KB", "MB", "GB", "TB"};
-    int unit_index = 0;
-    double size = static_cast<double>(bytes);
-    
-    while (size >= 1024.0 && unit_index < 4) {
-        size /= 1024.0;
-        unit_index++;
+void ConsoleUI::appendTimeUntil(const std::string& expires_at) {
+    if (expires_at.empty()) {
+        frame_ << "N/A";
+        return;
     }
     
-    std::ostringstream oss;
-    oss << std::fixed << std::setprecision(1) << size << " " << units[unit_index];
-    return oss.str();
-}
-
-std::string ConsoleUI::formatTimeUntil(const std::string& expires_at) const {
-    if (expires_at.empty()) {
-        return "N/A";
-    }
-    
-    // Parse ISO8601 timestamp (simplified - handles basic format)
-    // Format: 2024-01-15T10:30:00.123456Z
-    std::tm tm = {};
-    int year, month, day, hour, min, sec;
-    
-    if (sscanf(expires_at.c_str(), "%d-%d-%dT%d:%d:%d",
-               &year, &month, &day, &hour, &min, &sec) == 6) {
-        tm.tm_year = year - 1900;
-        tm.tm_mon = month - 1;
-        tm.tm_mday = day;
-        tm.tm_hour = hour;
-        tm.tm_min = min;
-        tm.tm_sec = sec;
-        
-        // Convert to time_t (UTC)
-        time_t expires_time = _mkgmtime(&tm);
-        time_t now = time(nullptr);
-        
-        // Get current time in UTC
-        std::tm* now_tm = gmtime(&now);
-        time_t now_utc = _mkgmtime(now_tm);
-        
-        double diff_seconds = difftime(expires_time, now_utc);
+    int64_t expires_time = parseTimestamp(expires_at);
+    if (expires_time > 0) {
+        int64_t diff_seconds = expires_time - static_cast<int64_t>(time(nullptr));
         
         if (diff_seconds <= 0) {
-            return "Expired";
+            frame_ << "Expired";
+            return;
         }
         
-        int minutes = static_cast<int>(diff_seconds / 60);
-        int seconds = static_cast<int>(diff_seconds) % 60;
+        int64_t minutes = diff_seconds / 60;
+        int64_t seconds = diff_seconds % 60;
         
-        std::ostringstream oss;
         if (minutes > 0) {
-            oss << minutes << "m " << seconds << "s";
+            frame_ << minutes << "m " << seconds << "s";
         } else {
-            oss << seconds << "s";
+            frame_ << seconds << "s";
         }
-        return oss.str();
+        return;
     }
     
-    return expires_at;
+    frame_ << expires_at;
 }
 
-std::string ConsoleUI::truncateString(const std::string& str, size_t max_length) const {
-    if (str.length() <= max_length) {
-        return str;
-    }
-    return str.substr(0, max_length - 3) + "...";
-}
-
-std::string ConsoleUI::getCurrentTime() const {
+void ConsoleUI::appendCurrentTime() {
     auto now = std::chrono::system_clock::now();
     auto time_t_now = std::chrono::system_clock::to_time_t(now);
     std::tm* local_tm = std::localtime(&time_t_now);
     
-    std::ostringstream oss;
-    oss << std::put_time(local_tm, "%Y-%m-%d %H:%M:%S");
-    return oss.str();
+    char buf[32];
+    size_t n = std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", local_tm);
+    frame_ << std::string_view(buf, n);
 }
 
-std::string ConsoleUI::getProgressBar(double percentage, int width) const {
-    int filled = static_cast<int>((percentage / 100.0) * width);
-    if (filled > width) filled = width;
-    if (filled < 0) filled = 0;
+void ConsoleUI::appendLatency(double ms) {
+    if (ms < 1000) {
+        frame_.fixed(ms, ms < 10 ? 1 : 0) << "ms";
+    } else {
+        frame_.fixed(ms / 1000, 2) << "s";
+    }
+}
+
+void ConsoleUI::appendEnergy(double joules) {
+    double wh = joules / 3600.0;
+    if (wh >= 1000) {
+        frame_.fixed(wh / 1000, 2) << " kWh";
+    } else {
+        frame_.fixed(wh, wh < 10 ? 2 : 1) << " Wh";
+    }
+}
+
+bool ConsoleUI::appendThrottleReasons(uint64_t reasons) {
+    // Only reasons that cost performance; idle and application clocks are benign
+    static const struct { uint64_t bit; const char* label; } kReasons[] = {
+        {0x4, "PWR CAP"},
+        {0x8, "HW SLOWDOWN"},
+        {0x10, "SYNC BOOST"},
+        {0x20, "SW THERMAL"},
+        {0x40, "HW THERMAL"},
+        {0x80, "PWR BRAKE"},
+    };
     
-    std::string bar = "[";
-    for (int i = 0; i < width; i++) {
-        if (i < filled) {
-            bar += "|";
+    bool any = false;
+    for (const auto& reason : kReasons) {
+        if (reasons & reason.bit) {
+            frame_ << (any ? ", " : "") << reason.label;
+            any = true;
+        }
+    }
+    return any;
+}
+
+static bool hasThrottleReasons(uint64_t reasons) {
+    return (reasons & (0x4 | 0x8 | 0x10 | 0x20 | 0x40 | 0x80)) != 0;
+}
+
+// Heatmap scales: upper bounds of the first five steps per metric, the
+// sixth is open-ended; colors from the 256-color palette, green to red
+static const char* const kHeatNames[] = {"VRAM %", "Util %", "Temp C", "Power W"};
+static const int kHeatBounds[][5] = {
+    {20, 40, 60, 80, 90}, {10, 30, 50, 70, 90}, {50, 60, 70, 80, 85}, {50, 100, 200, 300, 400},
+};
+static const int kHeatColors[] = {28, 34, 142, 220, 208, 196};
+static_assert(sizeof(kHeatNames) / sizeof(kHeatNames[0]) == static_cast<size_t>(HeatMetric::Count),
+              "heat metric names out of sync");
+
+// -1 when the GPU doesn't report the metric
+static double heatValue(HeatMetric metric, const GPUInfo& gpu) {
+    switch (metric) {
+    case HeatMetric::Vram:
+        return gpu.total_vram_gb > 0 ? gpu.getVRAMUsagePercent() : -1;
+    case HeatMetric::Util:
+        return gpu.utilization_percent;
+    case HeatMetric::Temp:
+        return gpu.temperature_c > 0 ? gpu.temperature_c : -1;
+    default:
+        return gpu.power_watts > 0 ? gpu.power_watts : -1;
+    }
+}
+
+static double heatValue(HeatMetric metric, const fleet::GpuSample& gpu) {
+    switch (metric) {
+    case HeatMetric::Vram:
+        return gpu.total_vram_mb > 0 ? static_cast<double>(gpu.used_vram_mb) * 100.0 / static_cast<double>(gpu.total_vram_mb) : -1;
+    case HeatMetric::Util:
+        return static_cast<double>(gpu.utilization_percent);
+    case HeatMetric::Temp:
+        return gpu.temperature_c > 0 ? static_cast<double>(gpu.temperature_c) : -1;
+    default:
+        return gpu.power_watts > 0 ? static_cast<double>(gpu.power_watts) : -1;
+    }
+}
+
+// One terminal cell per GPU: a colored blank, '#' under the cursor, '.' for
+// no data. The color escape is only repeated when it changes, so a row of
+// similar GPUs costs a byte each; current tracks it (-1 = reset).
+static void appendHeatCell(FrameBuffer& out, int& current, HeatMetric metric, double value, bool cursor) {
+    int color = -1;
+    if (value >= 0) {
+        size_t step = 0;
+        while (step < 5 && value >= kHeatBounds[static_cast<size_t>(metric)][step]) {
+            step++;
+        }
+        color = kHeatColors[step];
+    }
+    if (color < 0 || cursor) {
+        out << (current >= 0 ? "\033[0m" : "");
+        if (color < 0) {
+            out << (cursor ? "\033[7m.\033[0m" : "\033[90m.\033[0m");
         } else {
-            bar += " ";
+            out << "\033[1;38;5;" << color << "m#\033[0m";
         }
+        current = -1;
+        return;
     }
-    bar += "]";
-    return bar;
+    if (color != current) {
+        out << "\033[48;5;" << color << "m";
+        current = color;
+    }
+    out << ' ';
 }
 
-void ConsoleUI::displayGPUInfo(const std::vector<GPUInfo>& gpu_infos) {
-    std::cout << "\033[1;36m";  // Cyan bold
-    std::cout << "=== GPU Status ===\033[0m";
+void ConsoleUI::appendHeatLegend() {
+    size_t metric = static_cast<size_t>(heat_metric_);
+    frame_ << "  \033[90m" << kHeatNames[metric] << ":\033[0m";
+    for (size_t step = 0; step < 6; step++) {
+        frame_ << " \033[48;5;" << kHeatColors[step] << "m \033[0m ";
+        if (step < 5) {
+            frame_ << "<" << kHeatBounds[metric][step];
+        } else {
+            frame_ << kHeatBounds[metric][4] << "+";
+        }
+    }
+    frame_ << "  \033[90m. no data\033[0m";
+    clearLine();
+    frame_ << "\n";
+}
+
+void ConsoleUI::displayGPUInfo(const std::vector<GPUInfo>& gpu_infos, bool compact_allowed) {
+    frame_ << "\033[1;36m";  // Cyan bold
+    frame_ << "=== GPU Status ===\033[0m";
     clearLine();
-    std::cout << "\n";
+    frame_ << "\n";
     
     if (gpu_infos.empty()) {
-        std::cout << "\033[33m  GPU monitoring unavailable (NVML not found)\033[0m";
+        frame_ << "\033[33m  GPU monitoring unavailable (no NVML or DRM devices found)\033[0m";
         clearLine();
-        std::cout << "\n";
+        frame_ << "\n";
+        return;
+    }
+    
+    // Four or five lines per GPU; past half the terminal, one cell each instead
+    gpu_heatmap_ = false;
+    size_t lines = 0;
+    for (const auto& gpu_info : gpu_infos) {
+        lines += gpu_info.available ? (gpu_info.has_extended_metrics ? 5 : 4) : 0;
+    }
+    gpu_heatmap_ = compact_allowed && rows_ > 0 && lines > static_cast<size_t>(rows_) / 2;
+    if (gpu_heatmap_) {
+        int current = -1;
+        double sum = 0.0;
+        double highest = -1.0;
+        size_t counted = 0;
+        int hottest = 0;
+        size_t throttled = 0;
+        frame_ << "  ";
+        for (const auto& gpu_info : gpu_infos) {
+            double value = gpu_info.available ? heatValue(heat_metric_, gpu_info) : -1;
+            appendHeatCell(frame_, current, heat_metric_, value, false);
+            if (value >= 0) {
+                sum += value;
+                counted++;
+                if (value > highest) {
+                    highest = value;
+                    hottest = gpu_info.index;
+                }
+            }
+            throttled += hasThrottleReasons(gpu_info.throttle_reasons) ? 1 : 0;
+        }
+        frame_ << (current >= 0 ? "\033[0m" : "") << "  " << gpu_infos.size() << " GPUs";
+        if (counted > 0) {
+            frame_ << "  avg ";
+            frame_.fixed(sum / static_cast<double>(counted), 0) << "  max ";
+            frame_.fixed(highest, 0) << " (GPU " << hottest << ")";
+        }
+        if (throttled > 0) {
+            frame_ << "  \033[1;31m" << throttled << " THROTTLED\033[0m";
+        }
+        clearLine();
+        frame_ << "\n";
+        appendHeatLegend();
         return;
     }
     
@@ -162,199 +361,1363 @@ void ConsoleUI::displayGPUInfo(const std::vector<GPUInfo>& gpu_infos) {
         
         // GPU Name with index for multi-GPU systems
         if (gpu_infos.size() > 1) {
-            std::cout << "  \033[1mGPU " << gpu_info.index << ":\033[0m " << gpu_info.name;
+            frame_ << "  \033[1mGPU " << gpu_info.index << ":\033[0m " << gpu_info.name;
         } else {
-            std::cout << "  \033[1mGPU:\033[0m " << gpu_info.name;
+            frame_ << "  \033[1mGPU:\033[0m " << gpu_info.name;
         }
         clearLine();
-        std::cout << "\n";
+        frame_ << "\n";
         
-        // VRAM Usage
+        // VRAM Usage (integrated GPUs have none of their own)
         double vram_percent = gpu_info.getVRAMUsagePercent();
-        std::cout << "  \033[1mVRAM:\033[0m ";
-        
-        // Color code based on usage
-        if (vram_percent > 90) {
-            std::cout << "\033[31m";  // Red
-        } else if (vram_percent > 70) {
-            std::cout << "\033[33m";  // Yellow
+        frame_ << "  \033[1mVRAM:\033[0m ";
+        if (gpu_info.shared_memory) {
+            frame_ << "\033[90mshared with system RAM\033[0m";
         } else {
-            std::cout << "\033[32m";  // Green
+            // Color code based on usage
+            if (vram_percent > 90) {
+                frame_ << "\033[31m";  // Red
+            } else if (vram_percent > 70) {
+                frame_ << "\033[33m";  // Yellow
+            } else {
+                frame_ << "\033[32m";  // Green
+            }
+            
+            frame_.progressBar(vram_percent, 30) << " ";
+            frame_.fixed(vram_percent, 1) << "% ";
+            frame_ << "(";
+            frame_.fixed(gpu_info.used_vram_gb, 2) << "/";
+            frame_.fixed(gpu_info.total_vram_gb, 2) << " GB)\033[0m";
         }
-        
-        std::cout << getProgressBar(vram_percent, 30) << " ";
-        std::cout << std::fixed << std::setprecision(1) << vram_percent << "% ";
-        std::cout << "(" << std::setprecision(2) << gpu_info.used_vram_gb << "/"
-                  << gpu_info.total_vram_gb << " GB)\033[0m";
         clearLine();
-        std::cout << "\n";
+        frame_ << "\n";
         
         // GPU Utilization
-        std::cout << "  \033[1mUtil:\033[0m ";
+        frame_ << "  \033[1mUtil:\033[0m ";
         if (gpu_info.utilization_percent > 90) {
-            std::cout << "\033[31m";
+            frame_ << "\033[31m";
         } else if (gpu_info.utilization_percent > 50) {
-            std::cout << "\033[33m";
+            frame_ << "\033[33m";
         } else {
-            std::cout << "\033[32m";
+            frame_ << "\033[32m";
         }
-        std::cout << getProgressBar(gpu_info.utilization_percent, 30) << " "
-                  << std::fixed << std::setprecision(0) << gpu_info.utilization_percent << "%\033[0m";
+        frame_.progressBar(gpu_info.utilization_percent, 30) << " ";
+        frame_.fixed(gpu_info.utilization_percent, 0) << "%\033[0m";
         clearLine();
-        std::cout << "\n";
+        frame_ << "\n";
         
         // Temperature & Power
-        std::cout << "  \033[1mTemp:\033[0m ";
+        frame_ << "  \033[1mTemp:\033[0m ";
         if (gpu_info.temperature_c > 80) {
-            std::cout << "\033[31m";
+            frame_ << "\033[31m";
         } else if (gpu_info.temperature_c > 60) {
-            std::cout << "\033[33m";
+            frame_ << "\033[33m";
         } else {
-            std::cout << "\033[32m";
+            frame_ << "\033[32m";
         }
-        std::cout << gpu_info.temperature_c << " C\033[0m  ";
+        frame_ << gpu_info.temperature_c << " C\033[0m  ";
+        
+        frame_ << "\033[1mPower:\033[0m " << gpu_info.power_watts << " W";
         
-        std::cout << "\033[1mPower:\033[0m " << gpu_info.power_watts << " W";
+        // Throttling explains most "slow model" reports - make it loud
+        if (hasThrottleReasons(gpu_info.throttle_reasons)) {
+            frame_ << "  \033[1;31mTHROTTLED: ";
+            appendThrottleReasons(gpu_info.throttle_reasons);
+            frame_ << "\033[0m";
+        }
         clearLine();
-        std::cout << "\n";
+        frame_ << "\n";
+        
+        // Clocks, memory bandwidth, PCIe and error counters (NVML only)
+        if (gpu_info.has_extended_metrics) {
+            frame_ << "  \033[1mClk:\033[0m  " << gpu_info.sm_clock_mhz << "/"
+                   << gpu_info.mem_clock_mhz << " MHz  "
+                   << "\033[1mMemBW:\033[0m ";
+            frame_.fixed(gpu_info.memory_util_percent, 0) << "%  "
+                   << "\033[1mPCIe:\033[0m RX ";
+            frame_.fixed(gpu_info.pcie_rx_mb_s, 1) << " / TX ";
+            frame_.fixed(gpu_info.pcie_tx_mb_s, 1) << " MB/s";
+            
+            if (gpu_info.ecc_uncorrected > 0 || gpu_info.xid_errors > 0) {
+                frame_ << "  \033[1;31m";
+            } else if (gpu_info.ecc_corrected > 0 || gpu_info.pcie_replays > 0) {
+                frame_ << "  \033[33m";
+            } else {
+                frame_ << "  \033[90m";
+            }
+            if (gpu_info.ecc_enabled) {
+                frame_ << "ECC " << gpu_info.ecc_corrected << "/" << gpu_info.ecc_uncorrected << " ";
+            }
+            frame_ << "XID " << gpu_info.xid_errors;
+            if (gpu_info.xid_errors > 0) {
+                frame_ << " (last " << gpu_info.last_xid << ")";
+            }
+            if (gpu_info.pcie_replays > 0) {
+                frame_ << " Replays " << gpu_info.pcie_replays;
+            }
+            frame_ << "\033[0m";
+            clearLine();
+            frame_ << "\n";
+        }
         
         // Add a blank line between GPUs if there are multiple
         if (gpu_infos.size() > 1 && idx < gpu_infos.size() - 1) {
             clearLine();
-            std::cout << "\n";
+            frame_ << "\n";
+        }
+    }
+}
+
+// Precomputed table layouts
+static const Column kRunnerColumns[] = {
+    {"RUNNER PID", 12}, {"CPU%", 10}, {"RSS", 12}, {"THREADS", 10},
+};
+static const Column kTopologyColumns[] = {
+    {"GPU", 5}, {"BUS ID", 14}, {"NUMA", 6}, {"PCIE NOW", 10}, {"PCIE MAX", 10},
+    {"GPU0", 6}, {"GPU1", 6}, {"GPU2", 6}, {"GPU3", 6}, {"GPU4", 6}, {"GPU5", 6}, {"GPU6", 6}, {"GPU7", 6},
+};
+static const size_t kTopologyPeerColumns = 8;  // Wider machines show the first eight
+static const Column kRunningColumns[] = {
+    {"MODEL", 24}, {"SIZE", 10}, {"GPU%", 6}, {"CTX", 7}, {"KV", 10},
+    {"PARAMS", 8}, {"QUANT", 8}, {"EXPIRES", 10},
+};
+static const Column kRequestColumns[] = {
+    {"ENDPOINT", 28}, {"REQ/MIN", 9}, {"P50", 9}, {"P95", 9}, {"P99", 9}, {"5XX", 8}, {"TOTAL", 8},
+};
+static const Column kEnergyColumns[] = {
+    {"MODEL", 24}, {"POWER", 9}, {"ENERGY", 12}, {"TOKENS", 10}, {"J/TOKEN", 9},
+};
+static const Column kFleetColumns[] = {
+    {"NODE", 18}, {"STATE", 9}, {"GPU%", 6}, {"VRAM", 15}, {"POWER", 8}, {"TEMP", 6},
+    {"CPU%", 6}, {"MODELS", 22}, {"REQ/MIN", 8}, {"B/S", 6},
+};
+static const Column kCatalogColumns[] = {
+    {"MODEL", 35}, {"SIZE", 12}, {"CACHED", 8}, {"LOAD", 8}, {"IF LOADED NOW", 14},
+};
+static const Column kEngineColumns[] = {
+    {"ENGINE / MODEL", 35}, {"RUN", 6}, {"WAIT", 6}, {"KV%", 6}, {"GEN TOK/S", 11}, {"PROMPT TOK/S", 13},
+};
+static const Column kKeeperColumns[] = {
+    {"MODEL", 35}, {"STATE", 14},
+};
+static const Column kPlanColumns[] = {
+    {"MODEL", 35}, {"NEEDS", 12}, {"PLACEMENT", 14},
+};
+
+void ConsoleUI::displayHostInfo(const HostInfo& host_info) {
+    if (!host_info.available) {
+        return;
+    }
+    
+    clearLine();
+    frame_ << "\n\033[1;33m";  // Yellow bold
+    frame_ << "=== Host ===\033[0m";
+    clearLine();
+    frame_ << "\n";
+    
+    // CPU - saturation here means offloaded layers are the bottleneck
+    frame_ << "  \033[1mCPU:\033[0m  ";
+    if (host_info.cpu_percent > 90) {
+        frame_ << "\033[31m";
+    } else if (host_info.cpu_percent > 50) {
+        frame_ << "\033[33m";
+    } else {
+        frame_ << "\033[32m";
+    }
+    frame_.progressBar(host_info.cpu_percent, 30) << " ";
+    frame_.fixed(host_info.cpu_percent, 0) << "% (" << host_info.cpu_count << " cores, iowait ";
+    frame_.fixed(host_info.iowait_percent, 0) << "%)\033[0m";
+    clearLine();
+    frame_ << "\n";
+    
+    // RAM
+    double mem_percent = host_info.getMemUsagePercent();
+    frame_ << "  \033[1mRAM:\033[0m  ";
+    if (mem_percent > 90) {
+        frame_ << "\033[31m";
+    } else if (mem_percent > 70) {
+        frame_ << "\033[33m";
+    } else {
+        frame_ << "\033[32m";
+    }
+    frame_.progressBar(mem_percent, 30) << " ";
+    frame_.fixed(mem_percent, 1) << "% (";
+    frame_.bytes(static_cast<int64_t>(host_info.mem_total_bytes - host_info.mem_available_bytes)) << "/";
+    frame_.bytes(static_cast<int64_t>(host_info.mem_total_bytes)) << ")\033[0m";
+    clearLine();
+    frame_ << "\n";
+    
+    // Swap & pressure stalls
+    uint64_t swap_used = host_info.swap_total_bytes - host_info.swap_free_bytes;
+    frame_ << "  \033[1mSwap:\033[0m " << (swap_used > 0 ? "\033[33m" : "");
+    frame_.bytes(static_cast<int64_t>(swap_used)) << "/";
+    frame_.bytes(static_cast<int64_t>(host_info.swap_total_bytes)) << "\033[0m";
+    if (host_info.has_pressure) {
+        frame_ << "  \033[1mPSI:\033[0m cpu ";
+        frame_.fixed(host_info.cpu_pressure_some, 1) << "%  mem ";
+        frame_.fixed(host_info.mem_pressure_some, 1) << "/";
+        frame_.fixed(host_info.mem_pressure_full, 1) << "%  io ";
+        frame_.fixed(host_info.io_pressure_some, 1) << "%";
+    }
+    clearLine();
+    frame_ << "\n";
+    
+    if (host_info.runners.empty()) {
+        return;
+    }
+    
+    // Per-runner usage
+    frame_ << "  \033[4m";
+    frame_.header(kRunnerColumns) << "\033[0m";
+    clearLine();
+    frame_ << "\n";
+    
+    for (const auto& runner : host_info.runners) {
+        frame_ << "  ";
+        frame_.intCell(runner.pid, kRunnerColumns[0].width);
+        frame_.fixedCell(runner.cpu_percent, 0, "", kRunnerColumns[1].width);
+        frame_.bytesCell(static_cast<int64_t>(runner.rss_bytes), kRunnerColumns[2].width);
+        frame_.intCell(runner.threads, kRunnerColumns[3].width);
+        clearLine();
+        frame_ << "\n";
+    }
+}
+
+void ConsoleUI::displayTopology(const DisplayInfo& info) {
+    bool any_bus_id = false;
+    for (const auto& gpu : info.gpu_infos) {
+        any_bus_id = any_bus_id || !gpu.pci_bus_id.empty();
+    }
+    if (info.topology_warnings.empty() && (!topology_shown_ || !any_bus_id)) {
+        return;
+    }
+    
+    clearLine();
+    frame_ << "\n\033[1;36m";  // Cyan bold
+    frame_ << "=== GPU Topology ===\033[0m";
+    clearLine();
+    frame_ << "\n";
+    
+    for (const auto& warning : info.topology_warnings) {
+        frame_ << (warning.severe ? "  \033[31m! " : "  \033[33m! ") << warning.text << "\033[0m";
+        clearLine();
+        frame_ << "\n";
+    }
+    if (!topology_shown_ || !any_bus_id) {
+        return;
+    }
+    
+    size_t peers = info.gpu_topology ? static_cast<size_t>(info.gpu_topology->count) : 0;
+    if (peers > kTopologyPeerColumns) {
+        peers = kTopologyPeerColumns;
+    }
+    frame_ << "  \033[4m";
+    frame_.header(kTopologyColumns, 5 + peers) << "\033[0m";
+    clearLine();
+    frame_ << "\n";
+    
+    char link[16];
+    for (const auto& gpu : info.gpu_infos) {
+        frame_ << "  ";
+        frame_.intCell(gpu.index, kTopologyColumns[0].width);
+        frame_.cell(gpu.pci_bus_id.empty() ? "-" : gpu.pci_bus_id, kTopologyColumns[1].width);
+        if (gpu.numa_node >= 0) {
+            frame_.intCell(gpu.numa_node, kTopologyColumns[2].width);
+        } else {
+            frame_.cell("-", kTopologyColumns[2].width);
+        }
+        
+        // Degraded links in yellow; idle GPUs downshift speed on purpose
+        std::snprintf(link, sizeof(link), "Gen%d x%d", gpu.pcie_gen, gpu.pcie_width);
+        bool narrow = gpu.pcie_width > 0 && gpu.pcie_width < gpu.pcie_width_max;
+        frame_ << (narrow ? "\033[33m" : "");
+        frame_.cell(gpu.pcie_gen > 0 ? link : "-", kTopologyColumns[3].width) << (narrow ? "\033[0m" : "");
+        std::snprintf(link, sizeof(link), "Gen%d x%d", gpu.pcie_gen_max, gpu.pcie_width_max);
+        frame_.cell(gpu.pcie_gen_max > 0 ? link : "-", kTopologyColumns[4].width);
+        
+        for (size_t peer = 0; peer < peers; peer++) {
+            GPUPeer p = info.gpu_topology->peer(gpu.index, static_cast<int>(peer));
+            const char* color = p.link == GPULink::System ? "\033[31m" :
+                                p.link == GPULink::NVLink || p.link == GPULink::XGMI ? "\033[32m" : "";
+            frame_ << color;
+            frame_.cell(gpuLinkLabel(p), kTopologyColumns[5 + peer].width) << (*color ? "\033[0m" : "");
+        }
+        clearLine();
+        frame_ << "\n";
+    }
+    
+    // Where each runner may run and which GPUs it has open
+    for (const auto& runner : info.host_info.runners) {
+        if (runner.gpus.empty() && runner.cpu_nodes == 0) {
+            continue;
+        }
+        frame_ << "  \033[90mRunner " << runner.pid << ": ";
+        if (runner.cpu_nodes != 0) {
+            frame_ << "CPUs on node";
+            const char* separator = " ";
+            for (int node = 0; node < 64; node++) {
+                if (runner.cpu_nodes & (1ULL << node)) {
+                    frame_ << separator << node;
+                    separator = ",";
+                }
+            }
+        } else {
+            frame_ << "CPUs on any node";
+        }
+        frame_ << ", GPUs ";
+        const char* separator = "";
+        for (const auto& bus_id : runner.gpus) {
+            const char* name = bus_id.c_str();
+            for (const auto& gpu : info.gpu_infos) {
+                if (gpu.pci_bus_id == bus_id) {
+                    std::snprintf(link, sizeof(link), "%d", gpu.index);
+                    name = link;
+                }
+            }
+            frame_ << separator << name;
+            separator = ",";
         }
+        frame_ << (runner.gpus.empty() ? "none" : "") << "\033[0m";
+        clearLine();
+        frame_ << "\n";
     }
 }
 
-void ConsoleUI::displayRunningModels(const std::vector<OllamaRunningModel>& models) {
+void ConsoleUI::displayRunningModels(const std::vector<OllamaRunningModel>& models,
+                                     const std::unordered_map<std::string, std::shared_ptr<const ModelMetadata>>& metadata) {
     clearLine();
-    std::cout << "\n\033[1;35m";  // Magenta bold
-    std::cout << "=== Running Models ===\033[0m";
+    frame_ << "\n\033[1;35m";  // Magenta bold
+    frame_ << "=== Running Models ===\033[0m";
     clearLine();
-    std::cout << "\n";
+    frame_ << "\n";
     
     if (models.empty()) {
-        std::cout << "  \033[33mNo models currently loaded\033[0m";
+        frame_ << "  \033[33mNo models currently loaded\033[0m";
         clearLine();
-        std::cout << "\n";
+        frame_ << "\n";
         return;
     }
     
     // Header
-    std::cout << "  \033[4m" << std::left
-              << std::setw(30) << "MODEL"
-              << std::setw(12) << "SIZE"
-              << std::setw(12) << "PARAMS"
-              << std::setw(10) << "QUANT"
-              << std::setw(12) << "EXPIRES"
-              << "\033[0m";
+    frame_ << "  \033[4m";
+    frame_.header(kRunningColumns) << "\033[0m";
     clearLine();
-    std::cout << "\n";
+    frame_ << "\n";
     
     for (const auto& model : models) {
-        std::cout << "  \033[32m" << std::left
-                  << std::setw(30) << truncateString(model.name, 29)
-                  << "\033[0m"
-                  << std::setw(12) << formatBytes(model.size)
-                  << std::setw(12) << model.details.parameter_size
-                  << std::setw(10) << model.details.quantization_level
-                  << std::setw(12) << formatTimeUntil(model.expires_at);
+        frame_ << "  \033[32m";
+        frame_.cell(model.name, kRunningColumns[0].width) << "\033[0m";
+        frame_.bytesCell(model.size, kRunningColumns[1].width);
+        
+        // GPU share: anything below 100% is partially on the CPU
+        int gpu_width = kRunningColumns[2].width;
+        if (!model.has_size_vram) {
+            frame_ << "\033[90m";
+            frame_.cell("?", gpu_width) << "\033[0m";
+        } else {
+            frame_ << (model.isPartiallyOffloaded() ? "\033[1;31m" : "\033[32m");
+            frame_.fixedCell(model.getGPUPercent(), 0, "%", gpu_width) << "\033[0m";
+        }
+        
+        if (model.context_length > 0) {
+            frame_.intCell(model.context_length, kRunningColumns[3].width);
+        } else {
+            frame_.cell("-", kRunningColumns[3].width);
+        }
+        
+        // Expected KV cache at the loaded context, once /api/show has been fetched
+        int kv_width = kRunningColumns[4].width;
+        auto meta = metadata.find(model.digest);
+        if (meta == metadata.end()) {
+            frame_.cell("...", kv_width);
+        } else if (int64_t kv_bytes = meta->second->estimateKVCacheBytes(model.context_length); kv_bytes > 0) {
+            frame_.bytesCell(kv_bytes, kv_width);
+        } else {
+            frame_.cell("-", kv_width);
+        }
+        
+        frame_.cell(model.details.parameter_size, kRunningColumns[5].width);
+        frame_.cell(model.details.quantization_level, kRunningColumns[6].width);
+        size_t expires = frame_.mark();
+        appendTimeUntil(model.expires_at);
+        frame_.padFrom(expires, kRunningColumns[7].width);
         clearLine();
-        std::cout << "\n";
+        frame_ << "\n";
+    }
+    
+    // Highlighted warning for every model split between GPU and CPU
+    for (const auto& model : models) {
+        if (!model.isPartiallyOffloaded()) {
+            continue;
+        }
+        frame_ << "  \033[1;37;41m WARNING \033[0m \033[1;31m" << model.name << ": ";
+        frame_.bytes(model.size - model.size_vram) << " offloaded to CPU (";
+        frame_.fixed(100.0 - model.getGPUPercent(), 0) << "%) - expect 5-20x slower generation\033[0m";
+        clearLine();
+        frame_ << "\n";
     }
 }
 
-void ConsoleUI::displayAvailableModels(const std::vector<OllamaModel>& models) {
+void ConsoleUI::displayAvailableModels(const std::vector<OllamaModel>& models, const ModelStoreInfo& store,
+                                       const std::vector<Placement>& placements) {
     clearLine();
-    std::cout << "\n\033[1;34m";  // Blue bold
-    std::cout << "=== Available Models (" << models.size() << ") ===\033[0m";
+    frame_ << "\n\033[1;34m";  // Blue bold
+    frame_ << "=== Available Models (" << models.size() << ") ===\033[0m";
     clearLine();
-    std::cout << "\n";
+    frame_ << "\n";
     
     if (models.empty()) {
-        std::cout << "  \033[33mNo models installed\033[0m";
+        frame_ << "  \033[33mNo models installed\033[0m";
         clearLine();
-        std::cout << "\n";
+        frame_ << "\n";
         return;
     }
     
+    // What is on disk, what deduplication saves, and what a cold load will hit
+    if (store.available && store.store_bytes > 0) {
+        frame_ << "  \033[90mStore: ";
+        frame_.bytes(store.store_bytes) << " on disk";
+        if (store.dedup_saved_bytes > 0) {
+            frame_ << " (";
+            frame_.bytes(store.dedup_saved_bytes) << " shared)";
+        }
+        frame_ << ", ";
+        frame_.bytes(store.cached_bytes) << " in page cache, "
+               << (store.disk_kind.empty() ? std::string_view("disk") : std::string_view(store.disk_kind)) << " ~";
+        frame_.fixed(store.disk_mb_s, 0) << " MB/s"
+               << (store.disk_kind.empty() ? " (assumed)" : "") << "\033[0m";
+        clearLine();
+        frame_ << "\n";
+    }
+    
     // Show first 10 models
     size_t display_count = models.size() < 10 ? models.size() : 10;
     
     // Header
-    std::cout << "  \033[4m" << std::left
-              << std::setw(35) << "MODEL"
-              << std::setw(12) << "SIZE"
-              << "\033[0m";
+    frame_ << "  \033[4m";
+    frame_.header(kCatalogColumns, store.available ? 4 : 2);
+    if (!placements.empty()) {
+        frame_.cell(kCatalogColumns[4].title, kCatalogColumns[4].width);
+    }
+    frame_ << "\033[0m";
     clearLine();
-    std::cout << "\n";
+    frame_ << "\n";
     
     for (size_t i = 0; i < display_count; i++) {
         const auto& model = models[i];
-        std::cout << "  " << std::left
-                  << std::setw(35) << truncateString(model.name, 34)
-                  << std::setw(12) << formatBytes(model.size);
+        frame_ << "  ";
+        frame_.cell(model.name, kCatalogColumns[0].width);
+        frame_.bytesCell(model.size, kCatalogColumns[1].width);
+        
+        auto entry = store.models.find(model.name);
+        if (store.available && entry != store.models.end()) {
+            // Mostly cached loads fast; cold blobs are where prewarming pays off
+            double cached = entry->second.cached_percent;
+            frame_ << (cached >= 90 ? "\033[32m" : cached >= 0 && cached < 10 ? "\033[33m" : "");
+            if (cached >= 0) {
+                frame_.fixedCell(cached, 0, "%", kCatalogColumns[2].width);
+            } else {
+                frame_.cell("?", kCatalogColumns[2].width);
+            }
+            frame_ << "\033[0m";
+            frame_.fixedCell(entry->second.est_load_seconds, 1, "s", kCatalogColumns[3].width);
+        } else if (store.available) {
+            frame_ << "\033[90m";
+            frame_.cell("-", kCatalogColumns[2].width).cell("-", kCatalogColumns[3].width) << "\033[0m";
+        }
+        
+        // What a load would do to the GPUs right now
+        if (i < placements.size()) {
+            appendPlacement(placements[i], false);
+        }
         clearLine();
-        std::cout << "\n";
+        frame_ << "\n";
     }
     
     if (models.size() > 10) {
-        std::cout << "  \033[90m... and " << (models.size() - 10) << " more\033[0m";
+        frame_ << "  \033[90m... and " << (models.size() - 10) << " more\033[0m";
         clearLine();
-        std::cout << "\n";
+        frame_ << "\n";
     }
 }
 
-void ConsoleUI::displayOllamaInfo(const std::unique_ptr<OllamaStatus>& status) {
-    if (!status) {
+void ConsoleUI::appendPlacement(const Placement& placement, bool verbose) {
+    switch (placement.kind) {
+    case PlacementKind::Loaded:
+        frame_ << "\033[32mloaded";
+        break;
+    case PlacementKind::Fits:
+        frame_ << "\033[32mfits gpu" << placement.gpu;
+        break;
+    case PlacementKind::Split:
+        frame_ << "\033[33msplit x" << placement.gpu_count;
+        break;
+    case PlacementKind::Offload:
+        frame_ << "\033[1;31moffload ";
+        frame_.fixed(100.0 - placement.gpu_percent, 0) << "% cpu";
+        break;
+    case PlacementKind::CpuOnly:
+        frame_ << "\033[1;31mcpu only";
+        break;
+    case PlacementKind::Unknown:
+        frame_ << "\033[90mnot installed";
+        break;
+    }
+    
+    if (!placement.evicts.empty()) {
+        frame_ << "\033[0;33m, evicts ";
+        if (verbose) {
+            for (size_t i = 0; i < placement.evicts.size(); i++) {
+                frame_ << (i > 0 ? ", " : "") << placement.evicts[i];
+            }
+        } else {
+            frame_.truncated(placement.evicts[0], 24);
+            if (placement.evicts.size() > 1) {
+                frame_ << " +" << (placement.evicts.size() - 1);
+            }
+        }
+    }
+    if (verbose && !placement.kv_known && placement.kind != PlacementKind::Loaded &&
+        placement.kind != PlacementKind::Unknown) {
+        frame_ << "\033[0;90m (weights only, KV cache pending)";
+    }
+    frame_ << "\033[0m";
+}
+
+void ConsoleUI::displayPlan(const DisplayInfo& info) {
+    if (!info.plan_editing && info.plan.empty()) {
+        return;
+    }
+    
+    clearLine();
+    frame_ << "\n\033[1;33m";  // Yellow bold
+    frame_ << "=== Load Plan ===\033[0m";
+    clearLine();
+    frame_ << "\n";
+    
+    if (info.plan_editing) {
+        frame_ << "  Plan> " << info.plan_input << "\033[7m \033[0m  "
+               << "\033[90m(models separated by spaces, name@ctx for a context, Enter runs, Esc cancels)\033[0m";
         clearLine();
-        std::cout << "\n\033[1;31m";
-        std::cout << "=== Ollama Status ===\033[0m";
+        frame_ << "\n";
+    }
+    appendPlanRows(info.plan);
+}
+
+void ConsoleUI::appendPlanRows(const std::vector<PlannedModel>& plan) {
+    if (plan.empty()) {
+        return;
+    }
+    
+    frame_ << "  \033[4m";
+    frame_.header(kPlanColumns) << "\033[0m";
+    clearLine();
+    frame_ << "\n";
+    
+    // Each row sees the models above it as already loaded
+    for (const auto& entry : plan) {
+        frame_ << "  ";
+        frame_.cell(entry.name, kPlanColumns[0].width);
+        if (entry.placement.kind == PlacementKind::Unknown) {
+            frame_.cell("-", kPlanColumns[1].width);
+        } else {
+            frame_.bytesCell(entry.placement.required_bytes, kPlanColumns[1].width);
+        }
+        appendPlacement(entry.placement, true);
         clearLine();
-        std::cout << "\n";
-        std::cout << "  \033[31mCannot connect to Ollama server\033[0m";
+        frame_ << "\n";
+    }
+}
+
+void ConsoleUI::printPlan(const std::vector<PlannedModel>& plan) {
+    frame_.clear();
+    appendPlanRows(plan);
+    std::cout.write(frame_.data(), static_cast<std::streamsize>(frame_.size()));
+    std::cout.flush();
+}
+
+void ConsoleUI::displayKeeper(const KeeperInfo& keeper) {
+    if (!keeper.active) {
+        return;
+    }
+    
+    clearLine();
+    frame_ << "\n\033[1;32m";  // Green bold
+    frame_ << "=== Keeper (" << keeper.models.size() << " desired) ===\033[0m";
+    clearLine();
+    frame_ << "\n";
+    
+    frame_ << "  \033[4m";
+    frame_.header(kKeeperColumns) << "\033[0m";
+    clearLine();
+    frame_ << "\n";
+    
+    for (const auto& model : keeper.models) {
+        frame_ << "  ";
+        frame_.cell(model.name, kKeeperColumns[0].width);
+        static const char* const kColors[] = {"\033[90m", "\033[32m", "\033[36m", "\033[36m", "\033[33m", "\033[33m", "\033[31m"};
+        frame_ << kColors[static_cast<int>(model.state)];
+        frame_.cell(keepStateName(model.state), kKeeperColumns[1].width) << "\033[0m";
+        if (model.state == KeepState::Resident) {
+            frame_ << "expires in ";
+            if (model.expires_in >= 365LL * 24 * 3600) {
+                frame_ << "never";
+            } else if (model.expires_in >= 60) {
+                frame_ << model.expires_in / 60 << "m " << model.expires_in % 60 << "s";
+            } else {
+                frame_ << (model.expires_in > 0 ? model.expires_in : 0) << "s";
+            }
+        } else if (model.state == KeepState::NoRoom) {
+            frame_ << "\033[90mwould evict or offload\033[0m";
+        } else if (model.state == KeepState::Backoff && model.retry_in > 0) {
+            frame_ << "retry in " << model.retry_in << "s";
+        } else if (model.state == KeepState::Backoff) {
+            frame_ << "\033[90mqueued\033[0m";
+        }
         clearLine();
-        std::cout << "\n";
-        std::cout << "  \033[90mMake sure Ollama is running (ollama serve)\033[0m";
+        frame_ << "\n";
+    }
+    
+    // Latest actions, newest first
+    size_t shown = 0;
+    for (auto it = keeper.recent.rbegin(); it != keeper.recent.rend() && shown < 3; ++it, ++shown) {
+        time_t when = static_cast<time_t>(it->time);
+        char buf[16];
+        size_t n = std::strftime(buf, sizeof(buf), "%H:%M:%S", std::localtime(&when));
+        frame_ << "  \033[90m" << std::string_view(buf, n) << "\033[0m " << (it->ok ? "\033[32m" : "\033[31m")
+               << it->model << ": " << it->text << "\033[0m";
         clearLine();
-        std::cout << "\n";
+        frame_ << "\n";
+    }
+}
+
+void ConsoleUI::displayEngines(const std::vector<EngineStats>& engines) {
+    if (engines.empty()) {
         return;
     }
     
-    displayRunningModels(status->models);
+    clearLine();
+    frame_ << "\n\033[1;36m";  // Cyan bold
+    frame_ << "=== Other Engines ===\033[0m";
+    clearLine();
+    frame_ << "\n";
+    
+    frame_ << "  \033[4m";
+    frame_.header(kEngineColumns) << "\033[0m";
+    clearLine();
+    frame_ << "\n";
+    
+    for (const auto& engine : engines) {
+        frame_ << "  \033[1m";
+        frame_.cell(engine.name, kEngineColumns[0].width) << "\033[0m";
+        if (!engine.up) {
+            frame_ << "\033[31mnot responding\033[0m";
+        } else {
+            frame_ << "\033[90m" << engine.series << " series, ";
+            frame_.bytes(static_cast<int64_t>(engine.bytes)) << " parsed in ";
+            frame_.fixed(engine.parse_ms, 3) << " ms\033[0m";
+        }
+        clearLine();
+        frame_ << "\n";
+        
+        for (const auto& model : engine.models) {
+            frame_ << "    ";
+            frame_.cell(model.name, kEngineColumns[0].width - 2);
+            for (size_t m = 0; m < static_cast<size_t>(EngineMetric::Count); m++) {
+                int width = kEngineColumns[m + 1].width;
+                if (!model.has[m]) {
+                    frame_.cell("-", width);
+                    continue;
+                }
+                bool busy = m == static_cast<size_t>(EngineMetric::Waiting) && model.values[m] > 0;
+                bool full = m == static_cast<size_t>(EngineMetric::KvCache) && model.values[m] >= 90;
+                frame_ << (busy || full ? "\033[33m" : "");
+                frame_.fixedCell(model.values[m], m >= static_cast<size_t>(EngineMetric::KvCache) ? 1 : 0, "", width);
+                frame_ << (busy || full ? "\033[0m" : "");
+            }
+            clearLine();
+            frame_ << "\n";
+        }
+    }
+}
+
+void ConsoleUI::displayRequestStats(const LogStats& stats) {
+    if (!stats.active) {
+        return;
+    }
+    
+    clearLine();
+    frame_ << "\n\033[1;36m";  // Cyan bold
+    frame_ << "=== Requests (";
+    frame_.truncated(stats.path, 50) << ") ===\033[0m";
+    clearLine();
+    frame_ << "\n";
+    
+    // Latest load: anything short of all layers means CPU offload
+    if (stats.has_offload) {
+        bool partial = stats.offloaded_layers < stats.total_layers;
+        frame_ << "  Last load: " << (partial ? "\033[1;31m" : "\033[32m")
+               << stats.offloaded_layers << "/" << stats.total_layers
+               << " layers on GPU\033[0m";
+        clearLine();
+        frame_ << "\n";
+    }
+    
+    if (stats.endpoints.empty()) {
+        frame_ << "  \033[90mNo requests seen yet\033[0m";
+        clearLine();
+        frame_ << "\n";
+        return;
+    }
+    
+    // Header
+    frame_ << "  \033[4m";
+    frame_.header(kRequestColumns) << "\033[0m";
+    clearLine();
+    frame_ << "\n";
+    
+    size_t display_count = stats.endpoints.size() < 8 ? stats.endpoints.size() : 8;
+    for (size_t i = 0; i < display_count; i++) {
+        const auto& endpoint = stats.endpoints[i];
+        frame_ << "  ";
+        frame_.cell(endpoint.endpoint, kRequestColumns[0].width);
+        frame_.fixedCell(endpoint.requests_per_min, endpoint.requests_per_min < 10 ? 1 : 0, "",
+                         kRequestColumns[1].width);
+        
+        const double percentiles[] = {endpoint.p50_ms, endpoint.p95_ms, endpoint.p99_ms};
+        for (int p = 0; p < 3; p++) {
+            size_t start = frame_.mark();
+            appendLatency(percentiles[p]);
+            frame_.padFrom(start, kRequestColumns[2 + p].width);
+        }
+        
+        frame_ << (endpoint.errors > 0 ? "\033[31m" : "");
+        frame_.intCell(static_cast<int64_t>(endpoint.errors), kRequestColumns[5].width) << "\033[0m";
+        frame_.intCell(static_cast<int64_t>(endpoint.total), kRequestColumns[6].width);
+        clearLine();
+        frame_ << "\n";
+    }
+}
+
+void ConsoleUI::displayEnergy(const EnergyInfo& energy) {
+    if (!energy.available) {
+        return;
+    }
+    
+    clearLine();
+    frame_ << "\n\033[1;36m";  // Cyan bold
+    frame_ << "=== Energy ===\033[0m";
+    clearLine();
+    frame_ << "\n";
+    
+    // Totals: this session, lifetime, per GPU
+    frame_ << "  \033[1mSession:\033[0m ";
+    appendEnergy(energy.session_joules);
+    frame_ << "  \033[1mTotal:\033[0m ";
+    appendEnergy(energy.total_joules);
+    if (energy.gpus.size() > 1) {
+        for (size_t i = 0; i < energy.gpus.size(); i++) {
+            frame_ << "  GPU" << i << " ";
+            appendEnergy(energy.gpus[i].joules);
+        }
+    }
+    if (energy.session_joules_per_token >= 0) {
+        frame_ << "  \033[1mJ/token:\033[0m ";
+        frame_.fixed(energy.session_joules_per_token, 2);
+    }
+    clearLine();
+    frame_ << "\n";
+    
+    // Header
+    frame_ << "  \033[4m";
+    frame_.header(kEnergyColumns, energy.has_tokens ? 5 : 3) << "\033[0m";
+    clearLine();
+    frame_ << "\n";
+    
+    // Resident models, then the biggest consumers that have been unloaded
+    size_t display_count = energy.models.size() < 6 ? energy.models.size() : 6;
+    for (size_t i = 0; i < display_count; i++) {
+        const auto& model = energy.models[i];
+        frame_ << "  " << (model.resident ? "" : "\033[90m");
+        frame_.cell(model.name, kEnergyColumns[0].width);
+        if (model.resident) {
+            frame_.fixedCell(model.watts, 0, " W", kEnergyColumns[1].width);
+        } else {
+            frame_.cell("-", kEnergyColumns[1].width);
+        }
+        size_t start = frame_.mark();
+        appendEnergy(model.joules);
+        frame_.padFrom(start, kEnergyColumns[2].width);
+        if (energy.has_tokens) {
+            frame_.intCell(static_cast<int64_t>(model.tokens), kEnergyColumns[3].width);
+            double per_token = model.joulesPerToken();
+            if (per_token >= 0) {
+                frame_.fixed(per_token, 2);
+            } else {
+                frame_ << "-";
+            }
+        }
+        frame_ << "\033[0m";
+        clearLine();
+        frame_ << "\n";
+    }
+    
+    // Energy nobody could be charged for
+    frame_ << "  \033[90m";
+    frame_.cell("(idle)", kEnergyColumns[0].width);
+    frame_.cell("", kEnergyColumns[1].width);
+    appendEnergy(energy.idle_joules);
+    if (energy.unattributed_joules > 0) {
+        frame_ << "   (server unreachable: ";
+        appendEnergy(energy.unattributed_joules);
+        frame_ << ")";
+    }
+    frame_ << "\033[0m";
+    clearLine();
+    frame_ << "\n";
+}
+
+void ConsoleUI::displayAlerts(const std::vector<ActiveAlert>& alerts) {
+    if (alerts.empty()) {
+        return;
+    }
+    int64_t now = static_cast<int64_t>(time(nullptr));
+    
+    frame_ << "\033[1;37;41m ALERTS (" << alerts.size() << " firing) \033[0m";
+    clearLine();
+    frame_ << "\n";
+    
+    size_t display_count = alerts.size() < 5 ? alerts.size() : 5;
+    for (size_t i = 0; i < display_count; i++) {
+        const auto& alert = alerts[i];
+        frame_ << "  \033[1;31m";
+        frame_.cell(alert.rule, 20) << "\033[0m";
+        frame_.cell(alert.instance, 36);
+        size_t start = frame_.mark();
+        frame_.fixed(alert.value, alert.value < 10 ? 2 : 1);
+        frame_.padFrom(start, 10);
+        int64_t age = now - alert.since;
+        frame_ << "for ";
+        if (age >= 3600) {
+            frame_ << age / 3600 << "h " << (age % 3600) / 60 << "m";
+        } else if (age >= 60) {
+            frame_ << age / 60 << "m " << age % 60 << "s";
+        } else {
+            frame_ << (age > 0 ? age : 0) << "s";
+        }
+        clearLine();
+        frame_ << "\n";
+    }
+    if (alerts.size() > display_count) {
+        frame_ << "  \033[90m... and " << (alerts.size() - display_count) << " more\033[0m";
+        clearLine();
+        frame_ << "\n";
+    }
+    clearLine();
+    frame_ << "\n";
+}
+
+void ConsoleUI::displayOllamaInfo(const DisplayInfo& info) {
+    if (!info.ollama_status) {
+        clearLine();
+        frame_ << "\n\033[1;31m";
+        frame_ << "=== Ollama Status ===\033[0m";
+        clearLine();
+        frame_ << "\n";
+        frame_ << "  \033[31mCannot connect to Ollama server\033[0m";
+        clearLine();
+        frame_ << "\n";
+        frame_ << "  \033[90mMake sure Ollama is running (ollama serve)\033[0m";
+        clearLine();
+        frame_ << "\n";
+        return;
+    }
+    
+    // Restored or last-known data until the server answers again
+    if (info.stale) {
+        int64_t age = static_cast<int64_t>(time(nullptr)) - info.stale_since;
+        clearLine();
+        frame_ << "\n  \033[1;30;43m STALE \033[0m \033[33mNot connected to Ollama - showing last known state from ";
+        if (age >= 3600) {
+            frame_ << age / 3600 << "h " << (age % 3600) / 60 << "m";
+        } else if (age >= 60) {
+            frame_ << age / 60 << "m " << age % 60 << "s";
+        } else {
+            frame_ << (age > 0 ? age : 0) << "s";
+        }
+        frame_ << " ago\033[0m";
+        clearLine();
+        frame_ << "\n";
+    }
+    
+    displayRunningModels(info.ollama_status->models, info.model_metadata);
+}
+
+void ConsoleUI::displayFleet(const std::vector<FleetNode>& nodes, int port, const FleetView& view) {
+    updateTerminalSize();
+    frame_.clear();
+    {
+        PROFILE_SCOPE(Compose);
+        composeFleet(nodes, port, view);
+    }
+    present();
+}
+
+// "up", "offline", ... for a fleet node
+static void appendNodeState(FrameBuffer& out, const FleetNode& node, int64_t now) {
+    if (!node.connected) {
+        out << "\033[31moffline\033[0m";
+    } else if (now - node.updated_at > 10) {
+        out << "\033[33mstale\033[0m";
+    } else if (!node.snapshot.ollama_up) {
+        out << "\033[33mno ollama\033[0m";
+    } else {
+        out << "\033[32mup\033[0m";
+    }
+}
+
+void ConsoleUI::composeFleet(const std::vector<FleetNode>& nodes, int port, const FleetView& view) {
+    appendHeader("OLLAMA FLEET");
+    fleet_heatmap_ = false;
+    int64_t now = static_cast<int64_t>(time(nullptr));
+    
+    // Fleet totals
+    size_t online = 0;
+    size_t gpus = 0;
+    size_t resident = 0;
+    int64_t used_mb = 0;
+    int64_t total_mb = 0;
+    int64_t watts = 0;
+    double ingest = 0.0;
+    for (const auto& node : nodes) {
+        if (!node.connected) {
+            continue;
+        }
+        online++;
+        gpus += node.snapshot.gpus.size();
+        resident += node.snapshot.models.size();
+        for (const auto& gpu : node.snapshot.gpus) {
+            used_mb += gpu.used_vram_mb;
+            total_mb += gpu.total_vram_mb;
+            watts += gpu.power_watts;
+        }
+        ingest += node.bytes_per_sec;
+    }
+    
+    frame_ << "\033[1;36m=== Fleet (port " << port << ") ===\033[0m";
+    clearLine();
+    frame_ << "\n";
+    frame_ << "  \033[1mNodes:\033[0m " << online << "/" << nodes.size() << " online  "
+           << "\033[1mGPUs:\033[0m " << gpus << "  \033[1mVRAM:\033[0m ";
+    frame_.bytes(used_mb << 20) << " / ";
+    frame_.bytes(total_mb << 20) << "  \033[1mPower:\033[0m " << watts << " W  "
+           << "\033[1mModels:\033[0m " << resident << "  \033[1mIngest:\033[0m ";
+    frame_.fixed(ingest, 0) << " B/s";
+    clearLine();
+    frame_ << "\n";
+    clearLine();
+    frame_ << "\n";
+    
+    if (nodes.empty()) {
+        frame_ << "  \033[90mWaiting for agents (ollama-monitor --agent <this host>:" << port << ")\033[0m";
+        clearLine();
+        frame_ << "\n";
+        appendFooter();
+        return;
+    }
+    
+    size_t cursor = view.node < nodes.size() ? view.node : nodes.size() - 1;
+    if (view.detail) {
+        composeFleetNode(nodes[cursor]);
+        appendFooter("Esc to go back, ");
+        return;
+    }
+    
+    // One table row per node stops fitting long before a heatmap row does
+    if (view.layout == FleetLayout::Heatmap ||
+        (view.layout == FleetLayout::Auto && rows_ > 0 && nodes.size() + 10 > static_cast<size_t>(rows_))) {
+        fleet_heatmap_ = true;
+        composeFleetHeatmap(nodes, view);
+        appendFooter("arrows to move, Enter for details, m for metric, v for table, ");
+        return;
+    }
+    
+    frame_ << "  \033[4m";
+    frame_.header(kFleetColumns) << "\033[0m";
+    clearLine();
+    frame_ << "\n";
+    
+    const size_t kMaxRows = 60;
+    size_t display_count = nodes.size() < kMaxRows ? nodes.size() : kMaxRows;
+    for (size_t i = 0; i < display_count; i++) {
+        const auto& node = nodes[i];
+        const auto& snap = node.snapshot;
+        
+        frame_ << (keyboard_enabled_ && i == cursor ? "\033[1m>\033[0m " : "  ");
+        frame_.cell(snap.hostname, kFleetColumns[0].width);
+        
+        // Offline nodes keep their last state, greyed out
+        size_t start = frame_.mark();
+        appendNodeState(frame_, node, now);
+        if (!node.connected) {
+            frame_ << "\033[90m";
+        }
+        frame_.padFrom(start, kFleetColumns[1].width);
+        
+        int64_t util = 0;
+        int64_t node_used = 0;
+        int64_t node_total = 0;
+        int64_t node_watts = 0;
+        int64_t temp = 0;
+        for (const auto& gpu : snap.gpus) {
+            util += gpu.utilization_percent;
+            node_used += gpu.used_vram_mb;
+            node_total += gpu.total_vram_mb;
+            node_watts += gpu.power_watts;
+            temp = gpu.temperature_c > temp ? gpu.temperature_c : temp;
+        }
+        if (snap.gpus.empty()) {
+            frame_.cell("-", kFleetColumns[2].width);
+            frame_.cell("-", kFleetColumns[3].width);
+            frame_.cell("-", kFleetColumns[4].width);
+            frame_.cell("-", kFleetColumns[5].width);
+        } else {
+            frame_.intCell(util / static_cast<int64_t>(snap.gpus.size()), kFleetColumns[2].width);
+            start = frame_.mark();
+            frame_.fixed(static_cast<double>(node_used) / 1024, 1) << "/";
+            frame_.fixed(static_cast<double>(node_total) / 1024, 1) << " GB";
+            frame_.padFrom(start, kFleetColumns[3].width);
+            start = frame_.mark();
+            frame_ << node_watts << " W";
+            frame_.padFrom(start, kFleetColumns[4].width);
+            frame_.intCell(temp, kFleetColumns[5].width);
+        }
+        frame_.fixedCell(static_cast<double>(snap.cpu_permille) / 10, 0, "", kFleetColumns[6].width);
+        
+        start = frame_.mark();
+        if (snap.models.empty()) {
+            frame_ << "-";
+        } else {
+            size_t more_width = snap.models.size() > 1 ? 4 : 0;
+            frame_.truncated(snap.models[0].name, static_cast<size_t>(kFleetColumns[7].width) - 1 - more_width);
+            if (snap.models.size() > 1) {
+                frame_ << " +" << snap.models.size() - 1;
+            }
+        }
+        frame_.padFrom(start, kFleetColumns[7].width);
+        
+        frame_.fixedCell(static_cast<double>(snap.requests_per_min_x10) / 10, 1, "", kFleetColumns[8].width);
+        frame_.fixedCell(node.bytes_per_sec, 0, "", kFleetColumns[9].width);
+        if (!node.connected) {
+            frame_ << "\033[0m";
+        }
+        clearLine();
+        frame_ << "\n";
+    }
+    if (nodes.size() > kMaxRows) {
+        frame_ << "  \033[90m... and " << (nodes.size() - kMaxRows) << " more\033[0m";
+        clearLine();
+        frame_ << "\n";
+    }
+    
+    appendFooter("arrows to move, Enter for details, v for heatmap, ");
+}
+
+void ConsoleUI::composeFleetHeatmap(const std::vector<FleetNode>& nodes, const FleetView& view) {
+    const size_t kNameWidth = 13;
+    size_t cursor = view.node < nodes.size() ? view.node : nodes.size() - 1;
+    
+    // Node blocks (name, one cell per GPU) packed into as many columns as fit;
+    // nodes run down each column, so up/down steps through them in order
+    size_t widest = 1;
+    for (const auto& node : nodes) {
+        widest = node.snapshot.gpus.size() > widest ? node.snapshot.gpus.size() : widest;
+    }
+    size_t width = cols_ > 0 ? static_cast<size_t>(cols_) : 80;
+    size_t max_cells = width > kNameWidth + 6 ? width - kNameWidth - 6 : 1;
+    size_t cells = widest < max_cells ? widest : max_cells;
+    size_t block = kNameWidth + cells + 2;
+    size_t per_line = (width - 2) / block;
+    per_line = per_line > 0 ? per_line : 1;
+    size_t grid_rows = (nodes.size() + per_line - 1) / per_line;
+    
+    appendHeatLegend();
+    clearLine();
+    frame_ << "\n";
+    
+    // Everything else on screen takes 13 lines; scroll to keep the cursor visible
+    size_t room = rows_ > 16 ? static_cast<size_t>(rows_) - 13 : 3;
+    size_t first = 0;
+    if (grid_rows > room && cursor % grid_rows >= room) {
+        first = cursor % grid_rows - room + 1;
+    }
+    size_t last = first + room < grid_rows ? first + room : grid_rows;
+    for (size_t row = first; row < last; row++) {
+        frame_ << "  ";
+        for (size_t column = 0; column < per_line; column++) {
+            size_t i = column * grid_rows + row;
+            if (i >= nodes.size()) {
+                break;
+            }
+            const auto& node = nodes[i];
+            const auto& gpus = node.snapshot.gpus;
+            frame_ << (i == cursor ? "\033[1;4m" : node.connected ? "" : "\033[90m");
+            frame_.cell(node.snapshot.hostname, static_cast<int>(kNameWidth)) << "\033[0m";
+            
+            // Offline nodes keep their layout but show no data
+            int current = -1;
+            for (size_t g = 0; g < cells; g++) {
+                if (g < gpus.size()) {
+                    double value = node.connected ? heatValue(heat_metric_, gpus[g]) : -1;
+                    appendHeatCell(frame_, current, heat_metric_, value, i == cursor && g == view.gpu);
+                } else {
+                    frame_ << (current >= 0 ? "\033[0m " : " ");
+                    current = -1;
+                }
+            }
+            frame_ << (current >= 0 ? "\033[0m" : "") << (gpus.size() > cells ? "> " : "  ");
+        }
+        clearLine();
+        frame_ << "\n";
+    }
+    if (grid_rows > room) {
+        frame_ << "  \033[90mrows " << first + 1 << "-" << last << " of " << grid_rows << "\033[0m";
+        clearLine();
+        frame_ << "\n";
+    }
+    clearLine();
+    frame_ << "\n";
+    
+    // What the cursor is on
+    const auto& node = nodes[cursor];
+    const auto& gpus = node.snapshot.gpus;
+    frame_ << "  \033[1m" << node.snapshot.hostname << "\033[0m ";
+    appendNodeState(frame_, node, static_cast<int64_t>(time(nullptr)));
+    if (gpus.empty()) {
+        frame_ << "  no GPUs";
+    } else {
+        const auto& gpu = gpus[view.gpu < gpus.size() ? view.gpu : gpus.size() - 1];
+        frame_ << "  \033[1mGPU " << (view.gpu < gpus.size() ? view.gpu : gpus.size() - 1) << ":\033[0m ";
+        frame_.truncated(gpu.name, 32) << "  VRAM ";
+        frame_.fixed(static_cast<double>(gpu.used_vram_mb) / 1024, 1) << "/";
+        frame_.fixed(static_cast<double>(gpu.total_vram_mb) / 1024, 1) << " GB  Util "
+               << gpu.utilization_percent << "%  " << gpu.temperature_c << " C  " << gpu.power_watts << " W";
+    }
+    clearLine();
+    frame_ << "\n";
+}
+
+static const Column kNodeModelColumns[] = {
+    {"MODEL", 35}, {"SIZE", 12}, {"VRAM", 12}, {"EXPIRES", 12},
+};
+
+void ConsoleUI::composeFleetNode(const FleetNode& node) {
+    const auto& snap = node.snapshot;
+    frame_ << "\033[1;36m=== " << snap.hostname << " ===\033[0m ";
+    appendNodeState(frame_, node, static_cast<int64_t>(time(nullptr)));
+    frame_ << " \033[90m" << node.address << "\033[0m";
+    clearLine();
+    frame_ << "\n";
+    frame_ << "  \033[1mCPU:\033[0m ";
+    frame_.fixed(static_cast<double>(snap.cpu_permille) / 10, 0) << "%  \033[1mRAM:\033[0m ";
+    frame_.bytes(snap.mem_used_mb << 20) << " / ";
+    frame_.bytes(snap.mem_total_mb << 20) << "  \033[1mRequests:\033[0m ";
+    frame_.fixed(static_cast<double>(snap.requests_per_min_x10) / 10, 1) << "/min";
+    if (snap.p95_ms > 0) {
+        frame_ << "  \033[1mp95:\033[0m " << snap.p95_ms << " ms";
+    }
+    clearLine();
+    frame_ << "\n";
+    clearLine();
+    frame_ << "\n";
+    
+    // The regular GPU panel, from what the agent sends
+    node_gpus_.resize(snap.gpus.size());
+    for (size_t i = 0; i < snap.gpus.size(); i++) {
+        const auto& sample = snap.gpus[i];
+        GPUInfo& gpu = node_gpus_[i];
+        gpu.available = true;
+        gpu.index = static_cast<int>(i);
+        gpu.name = sample.name;
+        gpu.total_vram_gb = static_cast<double>(sample.total_vram_mb) / 1024;
+        gpu.used_vram_gb = static_cast<double>(sample.used_vram_mb) / 1024;
+        gpu.free_vram_gb = gpu.total_vram_gb - gpu.used_vram_gb;
+        gpu.shared_memory = sample.total_vram_mb == 0;  // Not on the wire; no VRAM reported
+        gpu.utilization_percent = static_cast<double>(sample.utilization_percent);
+        gpu.temperature_c = static_cast<int>(sample.temperature_c);
+        gpu.power_watts = static_cast<int>(sample.power_watts);
+    }
+    displayGPUInfo(node_gpus_, false);
+    
+    clearLine();
+    frame_ << "\n\033[1;35m=== Running Models ===\033[0m";
+    clearLine();
+    frame_ << "\n";
+    if (snap.models.empty()) {
+        frame_ << "  \033[33mNo models currently loaded\033[0m";
+        clearLine();
+        frame_ << "\n";
+        return;
+    }
+    frame_ << "  \033[4m";
+    frame_.header(kNodeModelColumns) << "\033[0m";
+    clearLine();
+    frame_ << "\n";
+    int64_t now = static_cast<int64_t>(time(nullptr));
+    for (const auto& model : snap.models) {
+        frame_ << "  ";
+        frame_.cell(model.name, kNodeModelColumns[0].width);
+        frame_.bytesCell(model.size_mb << 20, kNodeModelColumns[1].width);
+        frame_.bytesCell(model.vram_mb << 20, kNodeModelColumns[2].width);
+        int64_t left = model.expires_at - now;
+        if (model.expires_at == 0) {
+            frame_ << "-";
+        } else if (left <= 0) {
+            frame_ << "Expired";
+        } else if (left >= 60) {
+            frame_ << left / 60 << "m " << left % 60 << "s";
+        } else {
+            frame_ << left << "s";
+        }
+        clearLine();
+        frame_ << "\n";
+    }
 }
 
 void ConsoleUI::display(const DisplayInfo& info) {
+    // Compose the whole frame in memory, then hand it to the terminal at once
+    updateTerminalSize();
+    frame_.clear();
+    {
+        PROFILE_SCOPE(Compose);
+        composeFrame(info);
+    }
+    present();
+}
+
+void ConsoleUI::present() {
+    PROFILE_SCOPE(TerminalWrite);
+    
+    // Line starts of the new frame; the text after the last newline (the
+    // clear to end of screen) counts as a line too
+    lines_.clear();
+    lines_.push_back(0);
+    for (size_t i = 0; i < frame_.size(); i++) {
+        if (frame_.data()[i] == '\n') {
+            lines_.push_back(i + 1);
+        }
+    }
+    
+    // Appended output (--no-clear), output that isn't a terminal, frames
+    // taller than the terminal (it scrolls) and the first frame after a
+    // resize go out whole
+    out_.clear();
+    if (no_clear_ || rows_ == 0 || lines_.size() > static_cast<size_t>(rows_)) {
+        out_ << std::string_view(frame_.data(), frame_.size());
+        full_redraw_ = true;
+    } else if (full_redraw_) {
+        // Lines are clipped rather than wrapped so each stays on its own row
+        out_ << "\033[?7l" << std::string_view(frame_.data(), frame_.size());
+        wrap_disabled_ = true;
+        full_redraw_ = false;
+    } else {
+        // Only rows that changed, each after a cursor move. The last line is
+        // always sent so the cursor ends up below the frame.
+        for (size_t row = 0; row < lines_.size(); row++) {
+            size_t begin = lines_[row];
+            size_t end = row + 1 < lines_.size() ? lines_[row + 1] : frame_.size();
+            std::string_view line(frame_.data() + begin, end - begin);
+            if (row + 1 < lines_.size() && row + 1 < shown_lines_.size()) {
+                std::string_view before(shown_.data() + shown_lines_[row], shown_lines_[row + 1] - shown_lines_[row]);
+                if (line == before) {
+                    continue;
+                }
+            }
+            out_ << "\033[" << row + 1 << ";1H" << line;
+        }
+    }
+    std::cout.write(out_.data(), static_cast<std::streamsize>(out_.size()));
+    std::cout.flush();
+    
+    shown_.assign(frame_.data(), frame_.size());
+    shown_lines_.swap(lines_);
+}
+
+void ConsoleUI::appendHeader(const char* title) {
     if (!no_clear_) {
         // Move cursor to home position without clearing - prevents flicker
         moveCursorHome();
     }
     
-    // Header
-    std::cout << "\033[1;37;44m";  // White on blue
-    std::cout << " OLLAMA MONITOR                                              ";
-    std::cout << getCurrentTime() << " \033[0m";
+    frame_ << "\033[1;37;44m";  // White on blue
+    size_t start = frame_.mark();
+    frame_ << ' ' << title;
+    frame_.padFrom(start, 61);
+    appendCurrentTime();
+    frame_ << " \033[0m";
     clearLine();
-    std::cout << "\n";
+    frame_ << "\n";
     clearLine();
-    std::cout << "\n";
+    frame_ << "\n";
+}
+
+void ConsoleUI::appendFooter(const char* keys) {
+    clearLine();
+    frame_ << "\n\033[90mPress " << (keyboard_enabled_ ? keys : "")
+           << (keyboard_enabled_ ? "q or " : "")
+           << "Ctrl+C to exit | Refreshing every " << refresh_rate_ << "s\033[0m";
+    clearLine();
+    frame_ << "\n";
+    
+    // Clear any remaining content below (from previous frames with more content)
+    clearToEndOfScreen();
+}
+
+void ConsoleUI::composeFrame(const DisplayInfo& info) {
+    appendHeader("OLLAMA MONITOR");
+    
+    // Firing alert rules (--alerts) go above everything else
+    displayAlerts(info.alerts);
     
     // GPU Information
     displayGPUInfo(info.gpu_infos);
     
+    // Host CPU/RAM (matters once layers are offloaded to the CPU)
+    displayHostInfo(info.host_info);
+    
+    // PCIe/NVLink paths and NUMA placement ('t' shows the matrix)
+    displayTopology(info);
+    
     // Ollama Status
-    displayOllamaInfo(info.ollama_status);
+    displayOllamaInfo(info);
+    
+    // What-if load query ('p')
+    displayPlan(info);
+    
+    // Desired resident set (--keep)
+    displayKeeper(info.keeper);
+    
+    // What else is using the GPUs (--scrape)
+    displayEngines(info.engines);
+    
+    // GPU energy per model
+    displayEnergy(info.energy);
+    
+    // Traffic from the server log (--log)
+    displayRequestStats(info.log_stats);
     
     // Available Models
-    displayAvailableModels(info.available_models);
+    displayAvailableModels(info.available_models, info.model_store, info.placements);
     
-    // Footer
-    clearLine();
-    std::cout << "\n\033[90mPress Ctrl+C to exit | Refreshing every " 
-              << refresh_rate_ << "s\033[0m";
-    clearLine();
-    std::cout << "\n";
+    // Self-profile of the previous frame (--profile)
+    if (profiler::enabled()) {
+        clearLine();
+        frame_ << "\n\033[36m";
+        profiler::appendOverlay(frame_);
+        frame_ << "\033[0m";
+        clearLine();
+        frame_ << "\n";
+    }
     
-    // Clear any remaining content below (from previous frames with more content)
-    clearToEndOfScreen();
+    appendFooter(gpu_heatmap_ ? "p to plan a load, t for topology, m for metric, " : "p to plan a load, t for topology, ");
 }
@@ -0,0 +1,272 @@
+#include "../include/energy_meter.h"
+#include "../include/platform.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+// Longer gaps between samples (suspend, stalled driver) are not integrated:
+// a straight line across them would be a guess. Slow refreshes get three
+// of their own periods, as power is sampled once per refresh.
+static const std::chrono::seconds kMaxSampleGap(30);
+static const int kGapRefreshes = 3;
+// Totals are written at least this often while energy accrues
+static const std::chrono::seconds kSaveInterval(60);
+// Lifetime totals kept per model; unloaded models with the least energy go first
+static const size_t kMaxModels = 64;
+
+EnergyMeter::EnergyMeter(const std::string& path, std::chrono::seconds refresh)
+    : path_(path), max_gap_(std::max(kMaxSampleGap, refresh * kGapRefreshes)) {
+    load();
+    saved_at_ = std::chrono::steady_clock::now();
+}
+
+EnergyMeter::~EnergyMeter() {
+    save();
+}
+
+EnergyMeter::Model& EnergyMeter::model(const std::string& name) {
+    for (auto& m : models_) {
+        if (m.name == name) {
+            return m;
+        }
+    }
+    models_.emplace_back();
+    models_.back().name = name;
+    return models_.back();
+}
+
+void EnergyMeter::addSamples(const std::vector<GPUInfo>& gpus, const OllamaStatus* status) {
+    // Energy of every GPU since its previous sample
+    double joules = 0.0;
+    double watts = 0.0;
+    for (auto& gpu : gpus_) {
+        gpu.seen = false;
+    }
+    for (const auto& info : gpus) {
+        if (info.power_sampled_at == std::chrono::steady_clock::time_point{}) {
+            continue;
+        }
+        std::string key = std::to_string(info.index) + ":" + info.name;
+        Gpu* gpu = nullptr;
+        for (auto& candidate : gpus_) {
+            if (candidate.key == key) {
+                gpu = &candidate;
+            }
+        }
+        if (!gpu) {
+            gpus_.emplace_back();
+            gpu = &gpus_.back();
+            gpu->key = std::move(key);
+            gpu->name = info.name;
+        }
+        gpu->seen = true;
+        power_seen_ = true;
+        watts += info.power_milliwatts / 1000.0;
+
+        if (gpu->sampled_at != std::chrono::steady_clock::time_point{} && info.power_sampled_at > gpu->sampled_at) {
+            auto gap = info.power_sampled_at - gpu->sampled_at;
+            if (gap <= max_gap_) {
+                double seconds = std::chrono::duration<double>(gap).count();
+                double e = (gpu->milliwatts + info.power_milliwatts) / 2000.0 * seconds;
+                gpu->joules += e;
+                joules += e;
+            }
+        }
+        if (info.power_sampled_at > gpu->sampled_at) {
+            gpu->sampled_at = info.power_sampled_at;
+            gpu->milliwatts = info.power_milliwatts;
+        }
+    }
+    session_joules_ += joules;
+
+    // Attribute by VRAM share; /api/ps doesn't say which GPU holds a model,
+    // so the split covers all GPUs together
+    int64_t resident_vram = 0;
+    size_t resident_count = 0;
+    for (auto& m : models_) {
+        m.vram_bytes = 0;
+        m.watts = 0.0;
+    }
+    if (status) {
+        for (const auto& running : status->models) {
+            int64_t vram = running.has_size_vram ? running.size_vram : running.size;
+            if (vram > 0) {
+                model(running.name).vram_bytes += vram;
+                resident_vram += vram;
+            }
+        }
+        for (const auto& m : models_) {
+            resident_count += m.vram_bytes > 0 ? 1 : 0;
+        }
+    }
+
+    if (!status) {
+        unattributed_joules_ += joules;
+    } else if (resident_vram == 0) {
+        idle_joules_ += joules;
+    } else {
+        for (auto& m : models_) {
+            if (m.vram_bytes == 0) {
+                continue;
+            }
+            double share = static_cast<double>(m.vram_bytes) / static_cast<double>(resident_vram);
+            m.joules += joules * share;
+            m.watts = watts * share;
+            // Tokens can only be pinned on a model when it is alone
+            if (counting_tokens_ && resident_count == 1) {
+                m.token_joules += joules;
+            }
+        }
+    }
+    if (counting_tokens_) {
+        session_token_joules_ += joules;
+    }
+
+    // Churned models would otherwise keep an entry, copied every refresh, forever
+    models_.erase(std::remove_if(models_.begin(), models_.end(), [](const Model& m) {
+        return m.vram_bytes == 0 && m.joules == 0.0 && m.tokens == 0;
+    }), models_.end());
+    while (models_.size() > kMaxModels) {
+        auto smallest = models_.end();
+        for (auto it = models_.begin(); it != models_.end(); ++it) {
+            if (it->vram_bytes == 0 && (smallest == models_.end() || it->joules < smallest->joules)) {
+                smallest = it;
+            }
+        }
+        if (smallest == models_.end()) {
+            break;
+        }
+        models_.erase(smallest);
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (joules > 0 && now - saved_at_ >= kSaveInterval) {
+        save();
+    }
+}
+
+void EnergyMeter::addTokens(uint64_t total_generated) {
+    // The log tail counts from zero, so the first total is all new tokens
+    counting_tokens_ = true;
+    if (total_generated < last_token_total_) {
+        last_token_total_ = total_generated;
+        return;
+    }
+    uint64_t delta = total_generated - last_token_total_;
+    last_token_total_ = total_generated;
+    session_tokens_ += delta;
+
+    Model* sole = nullptr;
+    for (auto& m : models_) {
+        if (m.vram_bytes > 0) {
+            if (sole) {
+                return;
+            }
+            sole = &m;
+        }
+    }
+    if (sole) {
+        sole->tokens += delta;
+    }
+}
+
+EnergyInfo EnergyMeter::getInfo() const {
+    EnergyInfo info;
+    info.available = power_seen_;
+    info.session_joules = session_joules_;
+    info.idle_joules = idle_joules_;
+    info.unattributed_joules = unattributed_joules_;
+    for (const auto& gpu : gpus_) {
+        info.total_joules += gpu.joules;
+        if (gpu.seen) {
+            info.gpus.push_back({gpu.name, gpu.joules});
+        }
+    }
+
+    info.models.reserve(models_.size());
+    for (const auto& m : models_) {
+        ModelEnergy me;
+        me.name = m.name;
+        me.resident = m.vram_bytes > 0;
+        me.watts = m.watts;
+        me.joules = m.joules;
+        me.tokens = m.tokens;
+        me.token_joules = m.token_joules;
+        info.models.push_back(std::move(me));
+    }
+    std::sort(info.models.begin(), info.models.end(), [](const ModelEnergy& a, const ModelEnergy& b) {
+        if (a.resident != b.resident) {
+            return a.resident;
+        }
+        return a.resident ? a.watts > b.watts : a.joules > b.joules;
+    });
+
+    info.has_tokens = counting_tokens_;
+    info.session_tokens = session_tokens_;
+    if (session_tokens_ > 0) {
+        info.session_joules_per_token = session_token_joules_ / static_cast<double>(session_tokens_);
+    }
+    return info;
+}
+
+// gpu\t<index:name>\t<name>\t<joules>
+// model\t<name>\t<joules>\t<token joules>\t<tokens>
+// idle\t<joules>
+// unattributed\t<joules>
+void EnergyMeter::load() {
+    if (path_.empty()) {
+        return;
+    }
+    std::ifstream in(path_);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string kind;
+        if (!std::getline(fields, kind, '\t')) {
+            continue;
+        }
+
+        if (kind == "gpu") {
+            Gpu gpu;
+            if (!std::getline(fields, gpu.key, '\t') || !std::getline(fields, gpu.name, '\t')) {
+                continue;
+            }
+            fields >> gpu.joules;
+            if (fields) {
+                gpus_.push_back(std::move(gpu));
+            }
+        } else if (kind == "model") {
+            Model m;
+            if (!std::getline(fields, m.name, '\t')) {
+                continue;
+            }
+            fields >> m.joules >> m.token_joules >> m.tokens;
+            if (fields) {
+                models_.push_back(std::move(m));
+            }
+        } else if (kind == "idle") {
+            fields >> idle_joules_;
+        } else if (kind == "unattributed") {
+            fields >> unattributed_joules_;
+        }
+    }
+}
+
+void EnergyMeter::save() {
+    saved_at_ = std::chrono::steady_clock::now();
+    if (path_.empty() || !power_seen_) {
+        return;
+    }
+
+    std::ostringstream out;
+    out.precision(17);
+    for (const auto& gpu : gpus_) {
+        out << "gpu\t" << gpu.key << '\t' << gpu.name << '\t' << gpu.joules << '\n';
+    }
+    for (const auto& m : models_) {
+        out << "model\t" << m.name << '\t' << m.joules << '\t' << m.token_joules << '\t' << m.tokens << '\n';
+    }
+    out << "idle\t" << idle_joules_ << '\n';
+    out << "unattributed\t" << unattributed_joules_ << '\n';
+    writeFileAtomically(path_, out.str());
+}
@@ -0,0 +1,368 @@
+#include "../include/event_loop.h"
+#include <csignal>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+
+// Console control events arrive on their own thread, so they can post()
+static EventLoop* g_ctrl_loop = nullptr;
+static EventLoop::Callback g_ctrl_callback;
+
+static BOOL WINAPI consoleCtrlHandler(DWORD type) {
+    if ((type == CTRL_C_EVENT || type == CTRL_BREAK_EVENT || type == CTRL_CLOSE_EVENT) && g_ctrl_loop) {
+        g_ctrl_loop->post(g_ctrl_callback);
+        return TRUE;
+    }
+    return FALSE;
+}
+#endif
+
+EventLoop::EventLoop() {
+#ifdef __linux__
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ >= 0 && event_fd_ >= 0) {
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.fd = event_fd_;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, event_fd_, &ev);
+    }
+#endif
+}
+
+EventLoop::~EventLoop() {
+#ifdef __linux__
+    for (auto& [id, timer] : timers_) {
+        if (timer.fd >= 0) {
+            close(timer.fd);
+        }
+    }
+    if (signal_fd_ >= 0) {
+        close(signal_fd_);
+    }
+    if (event_fd_ >= 0) {
+        close(event_fd_);
+    }
+    if (epoll_fd_ >= 0) {
+        close(epoll_fd_);
+    }
+#endif
+#ifdef _WIN32
+    if (g_ctrl_loop == this) {
+        SetConsoleCtrlHandler(consoleCtrlHandler, FALSE);
+        g_ctrl_loop = nullptr;
+    }
+#endif
+}
+
+int EventLoop::addTimer(std::chrono::milliseconds period, Callback callback, bool fire_immediately) {
+    int id = next_timer_id_++;
+    Timer timer;
+    timer.period = period;
+    timer.callback = std::move(callback);
+    timer.next = now() + (fire_immediately ? std::chrono::milliseconds(0) : period);
+    if (simulated_) {
+        timers_[id] = std::move(timer);
+        return id;
+    }
+
+#ifdef __linux__
+    timer.fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer.fd < 0) {
+        return -1;
+    }
+
+    // steady_clock is CLOCK_MONOTONIC on Linux, so the first deadline maps 1:1
+    auto first = timer.next.time_since_epoch();
+    auto first_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(first).count();
+    auto period_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(period).count();
+    if (first_ns <= 0) {
+        first_ns = 1;
+    }
+
+    // Absolute first deadline plus a kernel-maintained interval: no drift
+    struct itimerspec spec = {};
+    spec.it_value.tv_sec = first_ns / 1000000000;
+    spec.it_value.tv_nsec = first_ns % 1000000000;
+    spec.it_interval.tv_sec = period_ns / 1000000000;
+    spec.it_interval.tv_nsec = period_ns % 1000000000;
+    timerfd_settime(timer.fd, TFD_TIMER_ABSTIME, &spec, nullptr);
+
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.fd = timer.fd;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, timer.fd, &ev);
+    timer_by_fd_[timer.fd] = id;
+#endif
+
+    timers_[id] = std::move(timer);
+    return id;
+}
+
+void EventLoop::removeTimer(int id) {
+    auto it = timers_.find(id);
+    if (it == timers_.end()) {
+        return;
+    }
+#ifdef __linux__
+    if (it->second.fd >= 0) {
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, it->second.fd, nullptr);
+        timer_by_fd_.erase(it->second.fd);
+        close(it->second.fd);
+    }
+#endif
+    timers_.erase(it);
+}
+
+bool EventLoop::watchFd(int fd, bool want_read, bool want_write, FdCallback callback) {
+#ifdef __linux__
+    struct epoll_event ev = {};
+    ev.events = (want_read ? static_cast<uint32_t>(EPOLLIN) : 0u) |
+                (want_write ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+    ev.data.fd = fd;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        return false;
+    }
+    fd_callbacks_[fd] = std::move(callback);
+    return true;
+#else
+    (void)fd;
+    (void)want_read;
+    (void)want_write;
+    (void)callback;
+    return false;
+#endif
+}
+
+void EventLoop::updateFd(int fd, bool want_read, bool want_write) {
+#ifdef __linux__
+    struct epoll_event ev = {};
+    ev.events = (want_read ? static_cast<uint32_t>(EPOLLIN) : 0u) |
+                (want_write ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+    ev.data.fd = fd;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev);
+#else
+    (void)fd;
+    (void)want_read;
+    (void)want_write;
+#endif
+}
+
+void EventLoop::unwatchFd(int fd) {
+#ifdef __linux__
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+#endif
+    fd_callbacks_.erase(fd);
+}
+
+void EventLoop::onSignal(int signo, Callback callback) {
+    signal_callbacks_[signo] = std::move(callback);
+
+#ifdef __linux__
+    // Block the signal process-wide and read it from one signalfd instead
+    sigset_t mask;
+    sigemptyset(&mask);
+    for (const auto& [registered, cb] : signal_callbacks_) {
+        sigaddset(&mask, registered);
+    }
+    sigprocmask(SIG_BLOCK, &mask, nullptr);
+
+    bool created = signal_fd_ < 0;
+    signal_fd_ = signalfd(signal_fd_, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (created && signal_fd_ >= 0) {
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.fd = signal_fd_;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, signal_fd_, &ev);
+    }
+#elif defined(_WIN32)
+    // Only Ctrl+C/close exist on the Windows console
+    if (signo == SIGINT) {
+        g_ctrl_loop = this;
+        g_ctrl_callback = signal_callbacks_[signo];
+        SetConsoleCtrlHandler(consoleCtrlHandler, TRUE);
+    }
+#endif
+}
+
+void EventLoop::post(Callback callback) {
+    {
+        std::lock_guard<std::mutex> lock(post_mutex_);
+        posted_.push_back(std::move(callback));
+#ifndef __linux__
+        woken_ = true;
+#endif
+    }
+#ifdef __linux__
+    uint64_t one = 1;
+    ssize_t written = write(event_fd_, &one, sizeof(one));
+    (void)written;
+#else
+    post_cv_.notify_one();
+#endif
+}
+
+void EventLoop::runPosted() {
+    std::vector<Callback> callbacks;
+    {
+        std::lock_guard<std::mutex> lock(post_mutex_);
+        callbacks.swap(posted_);
+    }
+    for (auto& callback : callbacks) {
+        if (!running_) {
+            break;
+        }
+        callback();
+    }
+}
+
+void EventLoop::stop() {
+    running_ = false;
+}
+
+void EventLoop::simulateTime() {
+    simulated_ = true;
+    simulated_now_ = std::chrono::steady_clock::now();
+}
+
+std::chrono::steady_clock::time_point EventLoop::now() const {
+    return simulated_ ? simulated_now_ : std::chrono::steady_clock::now();
+}
+
+void EventLoop::runNextSimulated() {
+    // Earliest deadline first; ties go to the older timer
+    auto due = timers_.end();
+    for (auto it = timers_.begin(); it != timers_.end(); ++it) {
+        if (due == timers_.end() || it->second.next < due->second.next ||
+            (it->second.next == due->second.next && it->first < due->first)) {
+            due = it;
+        }
+    }
+    if (due == timers_.end()) {
+        return;
+    }
+    simulated_now_ = due->second.next;
+    due->second.next += due->second.period;
+    Callback callback = due->second.callback;
+    callback();
+}
+
+#ifdef __linux__
+
+void EventLoop::handleSignals() {
+    struct signalfd_siginfo info;
+    while (read(signal_fd_, &info, sizeof(info)) == sizeof(info)) {
+        auto it = signal_callbacks_.find(static_cast<int>(info.ssi_signo));
+        if (it != signal_callbacks_.end()) {
+            it->second();
+        }
+    }
+}
+
+void EventLoop::run() {
+    running_ = true;
+    struct epoll_event events[32];
+
+    while (running_) {
+        // Block until something happens - no periodic wakeups. Simulated
+        // time only polls: the next timer is due as soon as fds are drained.
+        bool poll_only = simulated_ && !timers_.empty();
+        int n = epoll_wait(epoll_fd_, events, 32, poll_only ? 0 : -1);
+        for (int i = 0; i < n && running_; i++) {
+            int fd = events[i].data.fd;
+            uint32_t ev = events[i].events;
+
+            if (fd == event_fd_) {
+                uint64_t count;
+                ssize_t got = read(event_fd_, &count, sizeof(count));
+                (void)got;
+                runPosted();
+            } else if (fd == signal_fd_) {
+                handleSignals();
+            } else if (auto timer = timer_by_fd_.find(fd); timer != timer_by_fd_.end()) {
+                // Expiration count > 1 means we overran; run once, stay on the grid
+                uint64_t expirations;
+                if (read(fd, &expirations, sizeof(expirations)) == sizeof(expirations)) {
+                    int id = timer->second;
+                    auto it = timers_.find(id);
+                    if (it != timers_.end()) {
+                        Callback callback = it->second.callback;
+                        callback();
+                    }
+                }
+            } else if (auto watch = fd_callbacks_.find(fd); watch != fd_callbacks_.end()) {
+                // Copy: the callback may unwatch its own fd
+                FdCallback callback = watch->second;
+                callback((ev & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0, (ev & EPOLLOUT) != 0);
+            }
+        }
+        if (poll_only && running_) {
+            runNextSimulated();
+        }
+    }
+}
+
+#else
+
+void EventLoop::run() {
+    running_ = true;
+
+    while (running_) {
+        if (simulated_ && !timers_.empty()) {
+            runPosted();
+            if (running_) {
+                runNextSimulated();
+            }
+            continue;
+        }
+
+        // Sleep until the earliest timer deadline or a post()
+        auto deadline = std::chrono::steady_clock::time_point::max();
+        for (const auto& [id, timer] : timers_) {
+            if (timer.next < deadline) {
+                deadline = timer.next;
+            }
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(post_mutex_);
+            if (deadline == std::chrono::steady_clock::time_point::max()) {
+                post_cv_.wait(lock, [this] { return woken_; });
+            } else {
+                post_cv_.wait_until(lock, deadline, [this] { return woken_; });
+            }
+            woken_ = false;
+        }
+        runPosted();
+
+        auto now = std::chrono::steady_clock::now();
+        std::vector<int> due;
+        for (const auto& [id, timer] : timers_) {
+            if (timer.next <= now) {
+                due.push_back(id);
+            }
+        }
+        for (int id : due) {
+            auto it = timers_.find(id);
+            if (it == timers_.end() || !running_) {
+                continue;
+            }
+            // Advance on the original grid, skipping missed periods
+            while (it->second.next <= now) {
+                it->second.next += it->second.period;
+            }
+            Callback callback = it->second.callback;
+            callback();
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,89 @@
+#include "../include/fetch_worker.h"
+
+FetchWorker::FetchWorker(OllamaClient& client, std::vector<std::unique_ptr<MetricsScraper>>& scrapers,
+                         EventLoop* loop)
+    : client_(client), scrapers_(scrapers), loop_(loop) {
+    if (loop_) {
+        worker_ = std::thread(&FetchWorker::workerLoop, this);
+    }
+}
+
+FetchWorker::~FetchWorker() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    // Waits out at most the request in progress (bounded by the HTTP timeout)
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+bool FetchWorker::request(bool with_catalog, Done done) {
+    if (!loop_) {
+        FetchResult result;
+        fetch(result, with_catalog);
+        done(result);
+        return true;
+    }
+    if (busy_) {
+        return false;
+    }
+    busy_ = true;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_ = true;
+        with_catalog_ = with_catalog;
+        done_ = std::move(done);
+    }
+    cv_.notify_one();
+    return true;
+}
+
+void FetchWorker::fetch(FetchResult& result, bool with_catalog) {
+    // While the probe says the server is down, don't wait on requests that will time out
+    if (client_.isConnected()) {
+        result.status = client_.getStatus();
+        if (result.status && with_catalog) {
+            result.catalog_requested = true;
+            result.catalog = client_.getModels(&result.catalog_complete);
+        }
+    }
+    for (auto& scraper : scrapers_) {
+        {
+            // Shutting down: skip what's left rather than wait out each timeout
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_) {
+                return;
+            }
+        }
+        scraper->scrape();
+        result.engines.push_back(scraper->getStats());
+    }
+}
+
+void FetchWorker::workerLoop() {
+    for (;;) {
+        bool with_catalog = false;
+        Done done;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return stopping_ || pending_; });
+            if (stopping_) {
+                return;
+            }
+            pending_ = false;
+            with_catalog = with_catalog_;
+            done = std::move(done_);
+        }
+
+        // Shared: posted callbacks must be copyable, the status is not
+        auto result = std::make_shared<FetchResult>();
+        fetch(*result, with_catalog);
+        loop_->post([this, result, done] {
+            busy_ = false;
+            done(*result);
+        });
+    }
+}
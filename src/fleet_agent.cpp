@@ -0,0 +1,241 @@
+#include "../include/fleet_agent.h"
+#include "../include/console_ui.h"
+#include <cstdlib>
+#include <cstring>
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+// Wait between connection attempts
+static const std::chrono::seconds kReconnectDelay(5);
+// An aggregator this far behind is treated as gone
+static const size_t kMaxBuffered = 256 * 1024;
+
+FleetAgent::FleetAgent(const std::string& address, const std::string& hostname) : hostname_(hostname) {
+    size_t colon = address.rfind(':');
+    if (colon != std::string::npos && colon + 1 < address.size()) {
+        host_ = address.substr(0, colon);
+        port_ = std::atoi(address.c_str() + colon + 1);
+    }
+    // [::1]:7000
+    if (host_.size() > 2 && host_.front() == '[' && host_.back() == ']') {
+        host_ = host_.substr(1, host_.size() - 2);
+    }
+}
+
+FleetAgent::~FleetAgent() {
+    disconnect();
+}
+
+#ifdef __linux__
+
+bool FleetAgent::start(EventLoop& loop) {
+    if (host_.empty() || port_ <= 0 || port_ > 65535) {
+        return false;
+    }
+    loop_ = &loop;
+    connect();
+    return true;
+}
+
+void FleetAgent::connect() {
+    next_attempt_ = std::chrono::steady_clock::now() + kReconnectDelay;
+
+    struct addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* addrs = nullptr;
+    if (getaddrinfo(host_.c_str(), std::to_string(port_).c_str(), &hints, &addrs) != 0) {
+        return;
+    }
+
+    for (struct addrinfo* ai = addrs; ai; ai = ai->ai_next) {
+        int fd = socket(ai->ai_family, ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        if (::connect(fd, ai->ai_addr, ai->ai_addrlen) == 0 || errno == EINPROGRESS) {
+            // Frames are tiny and latency-sensitive
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            fd_ = fd;
+            connecting_ = true;
+            break;
+        }
+        close(fd);
+    }
+    freeaddrinfo(addrs);
+
+    if (fd_ >= 0) {
+        loop_->watchFd(fd_, true, true, [this](bool readable, bool writable) { onEvent(readable, writable); });
+    }
+}
+
+void FleetAgent::disconnect() {
+    if (fd_ < 0) {
+        return;
+    }
+    if (loop_) {
+        loop_->unwatchFd(fd_);
+    }
+    close(fd_);
+    fd_ = -1;
+    connecting_ = false;
+    out_.clear();
+    in_.clear();
+
+    // A new connection starts from a keyframe
+    have_acked_ = false;
+    in_flight_.clear();
+    force_keyframe_ = true;
+}
+
+void FleetAgent::onEvent(bool readable, bool writable) {
+    if (connecting_ && writable) {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        if (getsockopt(fd_, SOL_SOCKET, SO_ERROR, &err, &len) != 0 || err != 0) {
+            disconnect();
+            return;
+        }
+        connecting_ = false;
+    }
+
+    if (readable) {
+        char buf[4096];
+        for (;;) {
+            ssize_t n = recv(fd_, buf, sizeof(buf), 0);
+            if (n > 0) {
+                in_.append(buf, static_cast<size_t>(n));
+                continue;
+            }
+            if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                disconnect();
+                return;
+            }
+            break;
+        }
+
+        size_t consumed = 0;
+        for (;;) {
+            std::string_view payload;
+            size_t used = 0;
+            int result = fleet::nextMessage(std::string_view(in_).substr(consumed), payload, used);
+            if (result < 0) {
+                disconnect();
+                return;
+            }
+            if (result == 0) {
+                break;
+            }
+            handleMessage(payload);
+            consumed += used;
+        }
+        in_.erase(0, consumed);
+    }
+
+    flush();
+}
+
+void FleetAgent::flush() {
+    if (fd_ < 0 || connecting_) {
+        return;
+    }
+    while (!out_.empty()) {
+        ssize_t n = send(fd_, out_.data(), out_.size(), MSG_NOSIGNAL);
+        if (n > 0) {
+            bytes_sent_ += static_cast<uint64_t>(n);
+            out_.erase(0, static_cast<size_t>(n));
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        disconnect();
+        return;
+    }
+    loop_->updateFd(fd_, true, !out_.empty());
+}
+
+#else
+
+bool FleetAgent::start(EventLoop& loop) {
+    (void)loop;
+    return false;
+}
+
+void FleetAgent::connect() {}
+void FleetAgent::disconnect() {}
+void FleetAgent::onEvent(bool, bool) {}
+void FleetAgent::flush() {}
+
+#endif // __linux__
+
+void FleetAgent::handleMessage(std::string_view payload) {
+    fleet::Message message;
+    size_t body = 0;
+    if (!fleet::parseHeader(payload, message, body)) {
+        return;
+    }
+    if (message.type == fleet::kResync) {
+        force_keyframe_ = true;
+        return;
+    }
+    if (message.type != fleet::kAck) {
+        return;
+    }
+    // Older unacknowledged frames are superseded by this one
+    while (!in_flight_.empty() && in_flight_.front().seq <= message.seq) {
+        if (in_flight_.front().seq == message.seq) {
+            acked_ = std::move(in_flight_.front().fields);
+            acked_seq_ = message.seq;
+            have_acked_ = true;
+        }
+        in_flight_.pop_front();
+    }
+}
+
+void FleetAgent::publish(const DisplayInfo& info) {
+    if (!loop_) {
+        return;
+    }
+    if (fd_ < 0) {
+        if (std::chrono::steady_clock::now() >= next_attempt_) {
+            connect();
+        }
+        return;
+    }
+    if (connecting_) {
+        return;
+    }
+
+    Pending pending;
+    pending.seq = next_seq_++;
+    pending.fields = fleet::flatten(fleet::fromDisplayInfo(info, hostname_));
+
+    if (!have_acked_ || force_keyframe_ || frames_since_keyframe_ >= kKeyframeInterval) {
+        fleet::encodeKeyframe(out_, pending.seq, pending.fields);
+        force_keyframe_ = false;
+        frames_since_keyframe_ = 0;
+    } else {
+        fleet::encodeDelta(out_, pending.seq, acked_seq_, acked_, pending.fields);
+        frames_since_keyframe_++;
+    }
+
+    in_flight_.push_back(std::move(pending));
+    if (in_flight_.size() > kMaxInFlight) {
+        in_flight_.pop_front();
+    }
+    if (out_.size() > kMaxBuffered) {
+        disconnect();
+        return;
+    }
+    flush();
+}
@@ -0,0 +1,242 @@
+#include "../include/fleet_aggregator.h"
+#include "../include/platform.h"
+#include <ctime>
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+// Inbound rate is averaged over this window
+static const std::chrono::seconds kRateWindow(10);
+// Acks a connection may owe before it counts as stuck
+static const size_t kMaxPendingOut = 64 * 1024;
+
+FleetAggregator::FleetAggregator(int port) : port_(port) {}
+
+#ifdef __linux__
+
+FleetAggregator::~FleetAggregator() {
+    for (auto& [fd, connection] : connections_) {
+        ::close(fd);
+    }
+    if (listen_fd_ >= 0) {
+        ::close(listen_fd_);
+    }
+}
+
+bool FleetAggregator::start(EventLoop& loop) {
+    listen_fd_ = listenTcp(port_);
+    if (listen_fd_ < 0) {
+        return false;
+    }
+
+    loop_ = &loop;
+    return loop.watchFd(listen_fd_, true, false, [this](bool, bool) { accept(); });
+}
+
+void FleetAggregator::accept() {
+    for (;;) {
+        struct sockaddr_storage peer = {};
+        socklen_t peer_len = sizeof(peer);
+        int fd = accept4(listen_fd_, reinterpret_cast<struct sockaddr*>(&peer), &peer_len,
+                         SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+
+        char text[INET6_ADDRSTRLEN] = "?";
+        if (peer.ss_family == AF_INET6) {
+            const auto* in6 = reinterpret_cast<const struct sockaddr_in6*>(&peer);
+            inet_ntop(AF_INET6, &in6->sin6_addr, text, sizeof(text));
+        } else if (peer.ss_family == AF_INET) {
+            const auto* in4 = reinterpret_cast<const struct sockaddr_in*>(&peer);
+            inet_ntop(AF_INET, &in4->sin_addr, text, sizeof(text));
+        }
+        std::string_view address = text;
+        if (address.substr(0, 7) == "::ffff:") {
+            address.remove_prefix(7);
+        }
+
+        Connection& connection = connections_[fd];
+        connection.address = std::string(address);
+        connection.window_start = std::chrono::steady_clock::now();
+        loop_->watchFd(fd, true, false, [this, fd](bool readable, bool writable) {
+            if (writable) {
+                auto it = connections_.find(fd);
+                if (it != connections_.end()) {
+                    flush(fd, it->second);
+                }
+            }
+            if (readable) {
+                onReadable(fd);
+            }
+        });
+    }
+}
+
+void FleetAggregator::onReadable(int fd) {
+    auto it = connections_.find(fd);
+    if (it == connections_.end()) {
+        return;
+    }
+    Connection& connection = it->second;
+
+    char buf[16384];
+    for (;;) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n > 0) {
+            connection.in.append(buf, static_cast<size_t>(n));
+            connection.window_bytes += static_cast<uint64_t>(n);
+            continue;
+        }
+        if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            close(fd);
+            return;
+        }
+        break;
+    }
+
+    size_t consumed = 0;
+    for (;;) {
+        std::string_view payload;
+        size_t used = 0;
+        int result = fleet::nextMessage(std::string_view(connection.in).substr(consumed), payload, used);
+        if (result < 0 || (result > 0 && !handleMessage(connection, payload))) {
+            close(fd);
+            return;
+        }
+        if (result == 0) {
+            break;
+        }
+        consumed += used;
+    }
+    connection.in.erase(0, consumed);
+
+    // Update the inbound rate once per window
+    auto now = std::chrono::steady_clock::now();
+    if (now - connection.window_start >= kRateWindow && !connection.hostname.empty()) {
+        double seconds = std::chrono::duration<double>(now - connection.window_start).count();
+        nodes_[connection.hostname].bytes_per_sec = static_cast<double>(connection.window_bytes) / seconds;
+        connection.window_bytes = 0;
+        connection.window_start = now;
+    }
+
+    flush(fd, connection);
+}
+
+void FleetAggregator::flush(int fd, Connection& connection) {
+    while (!connection.out.empty()) {
+        ssize_t n = send(fd, connection.out.data(), connection.out.size(), MSG_NOSIGNAL);
+        if (n > 0) {
+            connection.out.erase(0, static_cast<size_t>(n));
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) && connection.out.size() < kMaxPendingOut) {
+            break;
+        }
+        close(fd);
+        return;
+    }
+    loop_->updateFd(fd, true, !connection.out.empty());
+}
+
+void FleetAggregator::close(int fd) {
+    auto it = connections_.find(fd);
+    if (it != connections_.end()) {
+        if (!it->second.hostname.empty()) {
+            auto node = nodes_.find(it->second.hostname);
+            // A reconnect may already own the entry
+            if (node != nodes_.end() && node->second.address == it->second.address) {
+                node->second.connected = false;
+                if (on_update_) {
+                    on_update_(node->second);
+                }
+            }
+        }
+        connections_.erase(it);
+    }
+    loop_->unwatchFd(fd);
+    ::close(fd);
+}
+
+#else
+
+FleetAggregator::~FleetAggregator() {}
+
+bool FleetAggregator::start(EventLoop& loop) {
+    (void)loop;
+    return false;
+}
+
+void FleetAggregator::accept() {}
+void FleetAggregator::onReadable(int) {}
+void FleetAggregator::flush(int, Connection&) {}
+void FleetAggregator::close(int) {}
+
+#endif // __linux__
+
+bool FleetAggregator::handleMessage(Connection& connection, std::string_view payload) {
+    fleet::Message message;
+    size_t body = 0;
+    if (!fleet::parseHeader(payload, message, body)) {
+        return false;
+    }
+    if (message.type != fleet::kKeyframe && message.type != fleet::kDelta) {
+        return true;
+    }
+
+    const fleet::Fields* base = nullptr;
+    if (message.type == fleet::kDelta) {
+        for (const auto& [seq, fields] : connection.history) {
+            if (seq == message.base_seq) {
+                base = &fields;
+            }
+        }
+        if (!base) {
+            fleet::encodeResync(connection.out);
+            if (!connection.hostname.empty()) {
+                nodes_[connection.hostname].resyncs++;
+            }
+            return true;
+        }
+    }
+
+    static const fleet::Fields kEmpty;
+    fleet::Fields fields;
+    fleet::NodeSnapshot snapshot;
+    if (!fleet::applyBody(message, payload, body, base ? *base : kEmpty, fields) ||
+        !fleet::unflatten(fields, snapshot)) {
+        return false;
+    }
+
+    FleetNode& node = nodes_[snapshot.hostname];
+    connection.hostname = snapshot.hostname;
+    node.snapshot = std::move(snapshot);
+    node.address = connection.address;
+    node.connected = true;
+    node.updated_at = static_cast<int64_t>(time(nullptr));
+    node.frames++;
+    if (on_update_) {
+        on_update_(node);
+    }
+
+    connection.history.emplace_back(message.seq, std::move(fields));
+    if (connection.history.size() > kHistory) {
+        connection.history.pop_front();
+    }
+    fleet::encodeAck(connection.out, message.seq);
+    return true;
+}
+
+std::vector<FleetNode> FleetAggregator::nodes() const {
+    std::vector<FleetNode> result;
+    result.reserve(nodes_.size());
+    for (const auto& [hostname, node] : nodes_) {
+        result.push_back(node);
+    }
+    return result;
+}
@@ -0,0 +1,367 @@
+#include "../include/fleet_protocol.h"
+#include "../include/console_ui.h"
+#include "../include/platform.h"
+#include <algorithm>
+#include <ctime>
+
+namespace fleet {
+
+// Scalar fields ahead of the GPU and model sections
+static const size_t kHeaderFields = 8;
+static const size_t kGpuFields = 5;
+static const size_t kModelFields = 3;
+
+static void putVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+static bool getVarint(std::string_view in, size_t& pos, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && pos < in.size(); shift += 7) {
+        uint8_t byte = static_cast<uint8_t>(in[pos++]);
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Small magnitudes of either sign encode in few bytes
+static uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+static int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>((value >> 1) ^ (~(value & 1) + 1));
+}
+
+static void putStrings(std::string& out, const std::vector<std::string>& strings) {
+    putVarint(out, strings.size());
+    for (const auto& s : strings) {
+        putVarint(out, s.size());
+        out.append(s);
+    }
+}
+
+static bool getStrings(std::string_view in, size_t& pos, std::vector<std::string>& strings) {
+    uint64_t count = 0;
+    if (!getVarint(in, pos, count) || count > in.size() - pos) {
+        return false;
+    }
+    strings.clear();
+    strings.reserve(count);
+    for (uint64_t i = 0; i < count; i++) {
+        uint64_t length = 0;
+        if (!getVarint(in, pos, length) || length > in.size() - pos) {
+            return false;
+        }
+        strings.emplace_back(in.substr(pos, length));
+        pos += length;
+    }
+    return true;
+}
+
+static void putMessage(std::string& out, const std::string& payload) {
+    putVarint(out, payload.size());
+    out.append(payload);
+}
+
+NodeSnapshot fromDisplayInfo(const DisplayInfo& info, const std::string& hostname) {
+    NodeSnapshot snapshot;
+    snapshot.hostname = hostname;
+    snapshot.collected_at = static_cast<int64_t>(time(nullptr));
+    snapshot.ollama_up = info.ollama_status && !info.stale;
+    snapshot.cpu_permille = static_cast<int64_t>(info.host_info.cpu_percent * 10);
+    snapshot.mem_total_mb = static_cast<int64_t>(info.host_info.mem_total_bytes >> 20);
+    snapshot.mem_used_mb = static_cast<int64_t>(
+        (info.host_info.mem_total_bytes - info.host_info.mem_available_bytes) >> 20);
+    snapshot.energy_wh = static_cast<int64_t>(info.energy.total_joules / 3600.0);
+
+    double rpm = 0.0;
+    double p95 = 0.0;
+    for (const auto& endpoint : info.log_stats.endpoints) {
+        rpm += endpoint.requests_per_min;
+        p95 = std::max(p95, endpoint.p95_ms);
+    }
+    snapshot.requests_per_min_x10 = static_cast<int64_t>(rpm * 10);
+    snapshot.p95_ms = static_cast<int64_t>(p95);
+
+    for (const auto& gpu : info.gpu_infos) {
+        if (!gpu.available) {
+            continue;
+        }
+        GpuSample g;
+        g.name = gpu.name;
+        g.utilization_percent = static_cast<int64_t>(gpu.utilization_percent);
+        g.used_vram_mb = static_cast<int64_t>(gpu.used_vram_gb * 1024);
+        g.total_vram_mb = static_cast<int64_t>(gpu.total_vram_gb * 1024);
+        g.temperature_c = gpu.temperature_c;
+        g.power_watts = gpu.power_watts;
+        snapshot.gpus.push_back(std::move(g));
+    }
+    if (snapshot.ollama_up) {
+        for (const auto& model : info.ollama_status->models) {
+            ModelSample m;
+            m.name = model.name;
+            m.digest = model.digest;
+            m.size_mb = model.size >> 20;
+            m.vram_mb = (model.has_size_vram ? model.size_vram : model.size) >> 20;
+            m.expires_at = parseTimestamp(model.expires_at);
+            snapshot.models.push_back(std::move(m));
+        }
+    }
+    return snapshot;
+}
+
+Fields flatten(const NodeSnapshot& snapshot) {
+    Fields fields;
+    auto& v = fields.values;
+    v.reserve(kHeaderFields + 2 + snapshot.gpus.size() * kGpuFields + snapshot.models.size() * kModelFields);
+    v.push_back(snapshot.collected_at);
+    v.push_back(snapshot.ollama_up ? 1 : 0);
+    v.push_back(snapshot.cpu_permille);
+    v.push_back(snapshot.mem_used_mb);
+    v.push_back(snapshot.mem_total_mb);
+    v.push_back(snapshot.energy_wh);
+    v.push_back(snapshot.requests_per_min_x10);
+    v.push_back(snapshot.p95_ms);
+
+    fields.strings.push_back(snapshot.hostname);
+    v.push_back(static_cast<int64_t>(snapshot.gpus.size()));
+    for (const auto& gpu : snapshot.gpus) {
+        v.push_back(gpu.utilization_percent);
+        v.push_back(gpu.used_vram_mb);
+        v.push_back(gpu.total_vram_mb);
+        v.push_back(gpu.temperature_c);
+        v.push_back(gpu.power_watts);
+        fields.strings.push_back(gpu.name);
+    }
+    v.push_back(static_cast<int64_t>(snapshot.models.size()));
+    for (const auto& model : snapshot.models) {
+        v.push_back(model.size_mb);
+        v.push_back(model.vram_mb);
+        v.push_back(model.expires_at);
+        fields.strings.push_back(model.name);
+        fields.strings.push_back(model.digest);
+    }
+    return fields;
+}
+
+bool unflatten(const Fields& fields, NodeSnapshot& snapshot) {
+    const auto& v = fields.values;
+    if (v.size() < kHeaderFields + 2 || fields.strings.empty()) {
+        return false;
+    }
+    size_t i = 0;
+    snapshot.collected_at = v[i++];
+    snapshot.ollama_up = v[i++] != 0;
+    snapshot.cpu_permille = v[i++];
+    snapshot.mem_used_mb = v[i++];
+    snapshot.mem_total_mb = v[i++];
+    snapshot.energy_wh = v[i++];
+    snapshot.requests_per_min_x10 = v[i++];
+    snapshot.p95_ms = v[i++];
+    snapshot.hostname = fields.strings[0];
+    size_t s = 1;
+
+    uint64_t gpu_count = static_cast<uint64_t>(v[i++]);
+    if (gpu_count > (v.size() - i) / kGpuFields || gpu_count > fields.strings.size() - s) {
+        return false;
+    }
+    snapshot.gpus.resize(gpu_count);
+    for (auto& gpu : snapshot.gpus) {
+        gpu.utilization_percent = v[i++];
+        gpu.used_vram_mb = v[i++];
+        gpu.total_vram_mb = v[i++];
+        gpu.temperature_c = v[i++];
+        gpu.power_watts = v[i++];
+        gpu.name = fields.strings[s++];
+    }
+
+    if (i >= v.size()) {
+        return false;
+    }
+    uint64_t model_count = static_cast<uint64_t>(v[i++]);
+    if (model_count != (v.size() - i) / kModelFields || model_count > (fields.strings.size() - s) / 2) {
+        return false;
+    }
+    snapshot.models.resize(model_count);
+    for (auto& model : snapshot.models) {
+        model.size_mb = v[i++];
+        model.vram_mb = v[i++];
+        model.expires_at = v[i++];
+        model.name = fields.strings[s++];
+        model.digest = fields.strings[s++];
+    }
+    return true;
+}
+
+void encodeKeyframe(std::string& out, uint64_t seq, const Fields& fields) {
+    std::string payload;
+    payload.push_back(static_cast<char>(kKeyframe));
+    putVarint(payload, seq);
+    putVarint(payload, kVersion);
+    putVarint(payload, fields.values.size());
+    for (int64_t value : fields.values) {
+        putVarint(payload, zigzag(value));
+    }
+    putStrings(payload, fields.strings);
+    putMessage(out, payload);
+}
+
+void encodeDelta(std::string& out, uint64_t seq, uint64_t base_seq, const Fields& base, const Fields& fields) {
+    std::string payload;
+    payload.push_back(static_cast<char>(kDelta));
+    putVarint(payload, seq);
+    putVarint(payload, base_seq);
+    putVarint(payload, fields.values.size());
+
+    // Fields past the end of the base are diffed against zero
+    auto baseValue = [&base](size_t i) { return i < base.values.size() ? base.values[i] : 0; };
+    size_t changed = 0;
+    for (size_t i = 0; i < fields.values.size(); i++) {
+        changed += fields.values[i] != baseValue(i) ? 1 : 0;
+    }
+    putVarint(payload, changed);
+    size_t previous = 0;
+    for (size_t i = 0; i < fields.values.size(); i++) {
+        if (fields.values[i] == baseValue(i)) {
+            continue;
+        }
+        putVarint(payload, i - previous);
+        putVarint(payload, zigzag(static_cast<int64_t>(
+            static_cast<uint64_t>(fields.values[i]) - static_cast<uint64_t>(baseValue(i)))));
+        previous = i;
+    }
+
+    if (fields.strings == base.strings) {
+        payload.push_back(0);
+    } else {
+        payload.push_back(1);
+        putStrings(payload, fields.strings);
+    }
+    putMessage(out, payload);
+}
+
+void encodeAck(std::string& out, uint64_t seq) {
+    std::string payload;
+    payload.push_back(static_cast<char>(kAck));
+    putVarint(payload, seq);
+    putMessage(out, payload);
+}
+
+void encodeResync(std::string& out) {
+    putMessage(out, std::string(1, static_cast<char>(kResync)));
+}
+
+int nextMessage(std::string_view buffer, std::string_view& payload, size_t& used) {
+    size_t pos = 0;
+    uint64_t length = 0;
+    if (!getVarint(buffer, pos, length)) {
+        // Only an unfinished prefix is fine; ten bytes would be a broken one
+        return buffer.size() < 10 ? 0 : -1;
+    }
+    if (length == 0 || length > kMaxMessage) {
+        return -1;
+    }
+    if (buffer.size() - pos < length) {
+        return 0;
+    }
+    payload = buffer.substr(pos, length);
+    used = pos + length;
+    return 1;
+}
+
+bool parseHeader(std::string_view payload, Message& message, size_t& body_offset) {
+    if (payload.empty()) {
+        return false;
+    }
+    message.type = static_cast<MessageType>(static_cast<uint8_t>(payload[0]));
+    size_t pos = 1;
+    message.seq = 0;
+    message.base_seq = 0;
+    switch (message.type) {
+        case kKeyframe:
+        case kAck:
+            if (!getVarint(payload, pos, message.seq)) {
+                return false;
+            }
+            break;
+        case kDelta:
+            if (!getVarint(payload, pos, message.seq) || !getVarint(payload, pos, message.base_seq)) {
+                return false;
+            }
+            break;
+        case kResync:
+            break;
+        default:
+            return false;
+    }
+    body_offset = pos;
+    return true;
+}
+
+bool applyBody(const Message& message, std::string_view payload, size_t body_offset,
+               const Fields& base, Fields& out) {
+    size_t pos = body_offset;
+    uint64_t count = 0;
+
+    if (message.type == kKeyframe) {
+        uint64_t version = 0;
+        if (!getVarint(payload, pos, version) || version != kVersion ||
+            !getVarint(payload, pos, count) || count > payload.size() - pos) {
+            return false;
+        }
+        out.values.resize(count);
+        for (auto& value : out.values) {
+            uint64_t raw = 0;
+            if (!getVarint(payload, pos, raw)) {
+                return false;
+            }
+            value = unzigzag(raw);
+        }
+        return getStrings(payload, pos, out.strings) && pos == payload.size();
+    }
+
+    if (message.type != kDelta || !getVarint(payload, pos, count) || count > kMaxMessage) {
+        return false;
+    }
+    out.values.assign(base.values.begin(), base.values.begin() + static_cast<std::ptrdiff_t>(
+        std::min<size_t>(count, base.values.size())));
+    out.values.resize(count, 0);
+
+    uint64_t changed = 0;
+    if (!getVarint(payload, pos, changed) || changed > count) {
+        return false;
+    }
+    uint64_t index = 0;
+    for (uint64_t i = 0; i < changed; i++) {
+        uint64_t gap = 0;
+        uint64_t raw = 0;
+        if (!getVarint(payload, pos, gap) || !getVarint(payload, pos, raw)) {
+            return false;
+        }
+        index += gap;
+        if (index >= count) {
+            return false;
+        }
+        out.values[index] = static_cast<int64_t>(static_cast<uint64_t>(out.values[index]) +
+                                                 static_cast<uint64_t>(unzigzag(raw)));
+    }
+
+    if (pos >= payload.size()) {
+        return false;
+    }
+    if (payload[pos++] == 0) {
+        out.strings = base.strings;
+        return pos == payload.size();
+    }
+    return getStrings(payload, pos, out.strings) && pos == payload.size();
+}
+
+} // namespace fleet
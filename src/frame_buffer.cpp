@@ -0,0 +1,162 @@
+#include "../include/frame_buffer.h"
+
+// Decode one UTF-8 code point starting at i, advancing i; invalid bytes
+// decode as themselves so malformed names still take one cell per byte
+static uint32_t decodeUtf8(std::string_view text, size_t& i) {
+    unsigned char c = static_cast<unsigned char>(text[i]);
+    size_t length = c < 0x80 ? 1 : (c >> 5) == 0x6 ? 2 : (c >> 4) == 0xe ? 3 : (c >> 3) == 0x1e ? 4 : 0;
+    if (length == 0 || i + length > text.size()) {
+        i++;
+        return c;
+    }
+    uint32_t cp = length == 1 ? c : c & (0xff >> (length + 1));
+    for (size_t k = 1; k < length; k++) {
+        unsigned char next = static_cast<unsigned char>(text[i + k]);
+        if ((next & 0xc0) != 0x80) {
+            i++;
+            return c;
+        }
+        cp = (cp << 6) | (next & 0x3f);
+    }
+    i += length;
+    return cp;
+}
+
+static int codePointWidth(uint32_t cp) {
+    // Combining marks, zero-width spaces/joiners and variation selectors
+    if ((cp >= 0x0300 && cp <= 0x036f) || (cp >= 0x200b && cp <= 0x200f) ||
+        (cp >= 0x20d0 && cp <= 0x20ff) || (cp >= 0xfe00 && cp <= 0xfe0f)) {
+        return 0;
+    }
+    // East Asian wide/fullwidth ranges and emoji
+    if ((cp >= 0x1100 && cp <= 0x115f) || (cp >= 0x2e80 && cp <= 0xa4cf && cp != 0x303f) ||
+        (cp >= 0xac00 && cp <= 0xd7a3) || (cp >= 0xf900 && cp <= 0xfaff) ||
+        (cp >= 0xfe30 && cp <= 0xfe4f) || (cp >= 0xff00 && cp <= 0xff60) ||
+        (cp >= 0xffe0 && cp <= 0xffe6) || (cp >= 0x1f300 && cp <= 0x1f64f) ||
+        (cp >= 0x1f900 && cp <= 0x1f9ff) || (cp >= 0x20000 && cp <= 0x3fffd)) {
+        return 2;
+    }
+    return 1;
+}
+
+// Skip an ANSI CSI sequence ("\033[...m") starting at i
+static bool skipEscape(std::string_view text, size_t& i) {
+    if (text[i] != '\033' || i + 1 >= text.size() || text[i + 1] != '[') {
+        return false;
+    }
+    i += 2;
+    while (i < text.size() && !(text[i] >= 0x40 && text[i] <= 0x7e)) {
+        i++;
+    }
+    if (i < text.size()) {
+        i++;
+    }
+    return true;
+}
+
+size_t displayWidth(std::string_view text) {
+    size_t width = 0;
+    size_t i = 0;
+    while (i < text.size()) {
+        if (skipEscape(text, i)) {
+            continue;
+        }
+        width += static_cast<size_t>(codePointWidth(decodeUtf8(text, i)));
+    }
+    return width;
+}
+
+FrameBuffer& FrameBuffer::fixed(double value, int precision) {
+    char tmp[64];
+    auto result = std::to_chars(tmp, tmp + sizeof(tmp), value, std::chars_format::fixed, precision);
+    if (result.ec != std::errc()) {
+        buf_.push_back('?');
+        return *this;
+    }
+    buf_.append(tmp, static_cast<size_t>(result.ptr - tmp));
+    return *this;
+}
+
+FrameBuffer& FrameBuffer::repeat(char c, size_t count) {
+    buf_.append(count, c);
+    return *this;
+}
+
+FrameBuffer& FrameBuffer::bytes(int64_t bytes) {
+    static const char* const units[] = {"B", "KB", "MB", "GB", "TB"};
+    int unit_index = 0;
+    double size = static_cast<double>(bytes);
+
+    while (size >= 1024.0 && unit_index < 4) {
+        size /= 1024.0;
+        unit_index++;
+    }
+    return fixed(size, 1) << ' ' << units[unit_index];
+}
+
+FrameBuffer& FrameBuffer::progressBar(double percentage, int width) {
+    int filled = static_cast<int>((percentage / 100.0) * width);
+    if (filled > width) filled = width;
+    if (filled < 0) filled = 0;
+
+    buf_.push_back('[');
+    buf_.append(static_cast<size_t>(filled), '|');
+    buf_.append(static_cast<size_t>(width - filled), ' ');
+    buf_.push_back(']');
+    return *this;
+}
+
+FrameBuffer& FrameBuffer::padFrom(size_t mark, int width) {
+    size_t used = displayWidth(std::string_view(buf_).substr(mark));
+    if (used < static_cast<size_t>(width)) {
+        buf_.append(static_cast<size_t>(width) - used, ' ');
+    }
+    return *this;
+}
+
+FrameBuffer& FrameBuffer::truncated(std::string_view text, size_t limit) {
+    if (displayWidth(text) <= limit) {
+        buf_.append(text.data(), text.size());
+    } else {
+        // Keep whole code points up to limit - 3 cells, then the ellipsis
+        size_t budget = limit > 3 ? limit - 3 : 0;
+        size_t used = 0;
+        size_t i = 0;
+        while (i < text.size()) {
+            size_t next = i;
+            int w = codePointWidth(decodeUtf8(text, next));
+            if (used + static_cast<size_t>(w) > budget) {
+                break;
+            }
+            used += static_cast<size_t>(w);
+            i = next;
+        }
+        buf_.append(text.data(), i);
+        buf_.append("...");
+    }
+    return *this;
+}
+
+FrameBuffer& FrameBuffer::cell(std::string_view text, int width) {
+    size_t start = buf_.size();
+    truncated(text, width > 1 ? static_cast<size_t>(width - 1) : 1);
+    return padFrom(start, width);
+}
+
+FrameBuffer& FrameBuffer::bytesCell(int64_t value, int width) {
+    size_t start = buf_.size();
+    bytes(value);
+    return padFrom(start, width);
+}
+
+FrameBuffer& FrameBuffer::intCell(int64_t value, int width) {
+    size_t start = buf_.size();
+    *this << value;
+    return padFrom(start, width);
+}
+
+FrameBuffer& FrameBuffer::fixedCell(double value, int precision, std::string_view suffix, int width) {
+    size_t start = buf_.size();
+    fixed(value, precision) << suffix;
+    return padFrom(start, width);
+}
@@ -1,20 +1,92 @@
 #include "../include/gpu_monitor.h"
+#include "../include/sysfs_gpu.h"
+#include "../include/gpu_topology.h"
+#include "../include/profiler.h"
 #include <iostream>
 
 #ifdef _WIN32
 #include <windows.h>
 #include <dxgi.h>
 #pragma comment(lib, "dxgi.lib")
+#else
+#include <dlfcn.h>
+#endif
+#include <cstring>
 
 // NVML types for dynamic loading
 typedef int nvmlReturn_t;
 typedef struct nvmlDevice_st* nvmlDevice_t;
+typedef struct nvmlEventSet_st* nvmlEventSet_t;
 typedef struct { unsigned long long total; unsigned long long free; unsigned long long used; } nvmlMemory_t;
 typedef struct { unsigned int gpu; unsigned int memory; } nvmlUtilization_t;
 typedef enum { NVML_TEMPERATURE_GPU = 0 } nvmlTemperatureSensors_t;
+typedef enum { NVML_CLOCK_GRAPHICS = 0, NVML_CLOCK_SM = 1, NVML_CLOCK_MEM = 2 } nvmlClockType_t;
+typedef enum { NVML_PCIE_UTIL_TX_BYTES = 0, NVML_PCIE_UTIL_RX_BYTES = 1 } nvmlPcieUtilCounter_t;
+
+typedef union {
+    double dVal;
+    unsigned int uiVal;
+    unsigned long ulVal;
+    unsigned long long ullVal;
+    signed long long sllVal;
+    signed int siVal;
+} nvmlValue_t;
+
+typedef struct {
+    unsigned int fieldId;
+    unsigned int scopeId;
+    long long timestamp;
+    long long latencyUsec;
+    int valueType;
+    nvmlReturn_t nvmlReturn;
+    nvmlValue_t value;
+} nvmlFieldValue_t;
+
+typedef struct {
+    char busIdLegacy[16];
+    unsigned int domain;
+    unsigned int bus;
+    unsigned int device;
+    unsigned int pciDeviceId;
+    unsigned int pciSubSystemId;
+    char busId[32];
+} nvmlPciInfo_t;
+
+typedef struct {
+    nvmlDevice_t device;
+    unsigned long long eventType;
+    unsigned long long eventData;
+    unsigned int gpuInstanceId;
+    unsigned int computeInstanceId;
+} nvmlEventData_t;
 
 #define NVML_SUCCESS 0
 #define NVML_DEVICE_NAME_BUFFER_SIZE 64
+#define NVML_EVENT_TYPE_XID_CRITICAL_ERROR 0x0000000000000008ULL
+#define NVML_NVLINK_MAX_LINKS 18
+
+// nvmlGpuTopologyLevel_t: closest common ancestor of two devices
+#define NVML_TOPOLOGY_INTERNAL 0
+#define NVML_TOPOLOGY_SINGLE 10
+#define NVML_TOPOLOGY_MULTIPLE 20
+#define NVML_TOPOLOGY_HOSTBRIDGE 30
+#define NVML_TOPOLOGY_NODE 40
+#define NVML_TOPOLOGY_SYSTEM 50
+
+// Field IDs requested in one nvmlDeviceGetFieldValues batch
+#define NVML_FI_DEV_ECC_CURRENT 1
+#define NVML_FI_DEV_ECC_SBE_VOL_TOTAL 3
+#define NVML_FI_DEV_ECC_DBE_VOL_TOTAL 4
+#define NVML_FI_DEV_PCIE_REPLAY_COUNTER 94
+#define NVML_FI_DEV_POWER_INSTANT 186
+
+// nvmlFieldValue_t::valueType
+#define NVML_VALUE_TYPE_DOUBLE 0
+#define NVML_VALUE_TYPE_UNSIGNED_INT 1
+#define NVML_VALUE_TYPE_UNSIGNED_LONG 2
+#define NVML_VALUE_TYPE_UNSIGNED_LONG_LONG 3
+#define NVML_VALUE_TYPE_SIGNED_LONG_LONG 4
+#define NVML_VALUE_TYPE_SIGNED_INT 5
 
 // Function pointer types
 typedef nvmlReturn_t (*nvmlInit_t)(void);
@@ -26,9 +98,64 @@ typedef nvmlReturn_t (*nvmlDeviceGetMemoryInfo_t)(nvmlDevice_t, nvmlMemory_t*);
 typedef nvmlReturn_t (*nvmlDeviceGetUtilizationRates_t)(nvmlDevice_t, nvmlUtilization_t*);
 typedef nvmlReturn_t (*nvmlDeviceGetTemperature_t)(nvmlDevice_t, nvmlTemperatureSensors_t, unsigned int*);
 typedef nvmlReturn_t (*nvmlDeviceGetPowerUsage_t)(nvmlDevice_t, unsigned int*);
+typedef nvmlReturn_t (*nvmlDeviceGetFieldValues_t)(nvmlDevice_t, int, nvmlFieldValue_t*);
+typedef nvmlReturn_t (*nvmlDeviceGetClockInfo_t)(nvmlDevice_t, nvmlClockType_t, unsigned int*);
+typedef nvmlReturn_t (*nvmlDeviceGetCurrentClocksThrottleReasons_t)(nvmlDevice_t, unsigned long long*);
+typedef nvmlReturn_t (*nvmlDeviceGetPcieThroughput_t)(nvmlDevice_t, nvmlPcieUtilCounter_t, unsigned int*);
+typedef nvmlReturn_t (*nvmlEventSetCreate_t)(nvmlEventSet_t*);
+typedef nvmlReturn_t (*nvmlEventSetFree_t)(nvmlEventSet_t);
+typedef nvmlReturn_t (*nvmlDeviceRegisterEvents_t)(nvmlDevice_t, unsigned long long, nvmlEventSet_t);
+typedef nvmlReturn_t (*nvmlEventSetWait_t)(nvmlEventSet_t, nvmlEventData_t*, unsigned int);
+typedef nvmlReturn_t (*nvmlDeviceGetPciInfo_t)(nvmlDevice_t, nvmlPciInfo_t*);
+typedef nvmlReturn_t (*nvmlDeviceGetPcieLinkValue_t)(nvmlDevice_t, unsigned int*);
+typedef nvmlReturn_t (*nvmlDeviceGetTopologyCommonAncestor_t)(nvmlDevice_t, nvmlDevice_t, int*);
+typedef nvmlReturn_t (*nvmlDeviceGetNvLinkState_t)(nvmlDevice_t, unsigned int, int*);
+typedef nvmlReturn_t (*nvmlDeviceGetNvLinkRemotePciInfo_t)(nvmlDevice_t, unsigned int, nvmlPciInfo_t*);
+
+// Platform library loading - nvml.dll ships with the Windows driver,
+// libnvidia-ml.so.1 with the Linux one
+#ifdef _WIN32
+typedef HMODULE NvmlLibrary;
+
+static NvmlLibrary openNvmlLibrary() {
+    // Try to load nvml.dll from system (comes with NVIDIA driver)
+    NvmlLibrary lib = LoadLibraryA("nvml.dll");
+    if (!lib) {
+        // Try alternate location
+        lib = LoadLibraryA("C:\\Program Files\\NVIDIA Corporation\\NVSMI\\nvml.dll");
+    }
+    return lib;
+}
+
+static void* nvmlSymbol(NvmlLibrary lib, const char* name) {
+    return (void*)GetProcAddress(lib, name);
+}
+
+static void closeNvmlLibrary(NvmlLibrary lib) {
+    FreeLibrary(lib);
+}
+#else
+typedef void* NvmlLibrary;
+
+static NvmlLibrary openNvmlLibrary() {
+    NvmlLibrary lib = dlopen("libnvidia-ml.so.1", RTLD_NOW);
+    if (!lib) {
+        lib = dlopen("libnvidia-ml.so", RTLD_NOW);
+    }
+    return lib;
+}
+
+static void* nvmlSymbol(NvmlLibrary lib, const char* name) {
+    return dlsym(lib, name);
+}
+
+static void closeNvmlLibrary(NvmlLibrary lib) {
+    dlclose(lib);
+}
+#endif
 
 // Global NVML state
-static HMODULE g_nvmlDll = nullptr;
+static NvmlLibrary g_nvmlDll = nullptr;
 static nvmlInit_t g_nvmlInit = nullptr;
 static nvmlShutdown_t g_nvmlShutdown = nullptr;
 static nvmlDeviceGetCount_t g_nvmlDeviceGetCount = nullptr;
@@ -38,33 +165,65 @@ static nvmlDeviceGetMemoryInfo_t g_nvmlDeviceGetMemoryInfo = nullptr;
 static nvmlDeviceGetUtilizationRates_t g_nvmlDeviceGetUtilizationRates = nullptr;
 static nvmlDeviceGetTemperature_t g_nvmlDeviceGetTemperature = nullptr;
 static nvmlDeviceGetPowerUsage_t g_nvmlDeviceGetPowerUsage = nullptr;
+static nvmlDeviceGetFieldValues_t g_nvmlDeviceGetFieldValues = nullptr;
+static nvmlDeviceGetClockInfo_t g_nvmlDeviceGetClockInfo = nullptr;
+static nvmlDeviceGetCurrentClocksThrottleReasons_t g_nvmlDeviceGetCurrentClocksThrottleReasons = nullptr;
+static nvmlDeviceGetPcieThroughput_t g_nvmlDeviceGetPcieThroughput = nullptr;
+static nvmlEventSetCreate_t g_nvmlEventSetCreate = nullptr;
+static nvmlEventSetFree_t g_nvmlEventSetFree = nullptr;
+static nvmlDeviceRegisterEvents_t g_nvmlDeviceRegisterEvents = nullptr;
+static nvmlEventSetWait_t g_nvmlEventSetWait = nullptr;
+static nvmlDeviceGetPciInfo_t g_nvmlDeviceGetPciInfo = nullptr;
+static nvmlDeviceGetPcieLinkValue_t g_nvmlDeviceGetCurrPcieLinkGeneration = nullptr;
+static nvmlDeviceGetPcieLinkValue_t g_nvmlDeviceGetMaxPcieLinkGeneration = nullptr;
+static nvmlDeviceGetPcieLinkValue_t g_nvmlDeviceGetCurrPcieLinkWidth = nullptr;
+static nvmlDeviceGetPcieLinkValue_t g_nvmlDeviceGetMaxPcieLinkWidth = nullptr;
+static nvmlDeviceGetTopologyCommonAncestor_t g_nvmlDeviceGetTopologyCommonAncestor = nullptr;
+static nvmlDeviceGetNvLinkState_t g_nvmlDeviceGetNvLinkState = nullptr;
+static nvmlDeviceGetNvLinkRemotePciInfo_t g_nvmlDeviceGetNvLinkRemotePciInfo = nullptr;
 
 static bool loadNvmlFunctions() {
-    // Try to load nvml.dll from system (comes with NVIDIA driver)
-    g_nvmlDll = LoadLibraryA("nvml.dll");
-    if (!g_nvmlDll) {
-        // Try alternate location
-        g_nvmlDll = LoadLibraryA("C:\\Program Files\\NVIDIA Corporation\\NVSMI\\nvml.dll");
-    }
+    g_nvmlDll = openNvmlLibrary();
     if (!g_nvmlDll) {
         return false;
     }
     
-    g_nvmlInit = (nvmlInit_t)GetProcAddress(g_nvmlDll, "nvmlInit_v2");
-    if (!g_nvmlInit) g_nvmlInit = (nvmlInit_t)GetProcAddress(g_nvmlDll, "nvmlInit");
+    g_nvmlInit = (nvmlInit_t)nvmlSymbol(g_nvmlDll, "nvmlInit_v2");
+    if (!g_nvmlInit) g_nvmlInit = (nvmlInit_t)nvmlSymbol(g_nvmlDll, "nvmlInit");
     
-    g_nvmlShutdown = (nvmlShutdown_t)GetProcAddress(g_nvmlDll, "nvmlShutdown");
-    g_nvmlDeviceGetCount = (nvmlDeviceGetCount_t)GetProcAddress(g_nvmlDll, "nvmlDeviceGetCount_v2");
-    if (!g_nvmlDeviceGetCount) g_nvmlDeviceGetCount = (nvmlDeviceGetCount_t)GetProcAddress(g_nvmlDll, "nvmlDeviceGetCount");
-    g_nvmlDeviceGetHandleByIndex = (nvmlDeviceGetHandleByIndex_t)GetProcAddress(g_nvmlDll, "nvmlDeviceGetHandleByIndex");
-    g_nvmlDeviceGetName = (nvmlDeviceGetName_t)GetProcAddress(g_nvmlDll, "nvmlDeviceGetName");
-    g_nvmlDeviceGetMemoryInfo = (nvmlDeviceGetMemoryInfo_t)GetProcAddress(g_nvmlDll, "nvmlDeviceGetMemoryInfo");
-    g_nvmlDeviceGetUtilizationRates = (nvmlDeviceGetUtilizationRates_t)GetProcAddress(g_nvmlDll, "nvmlDeviceGetUtilizationRates");
-    g_nvmlDeviceGetTemperature = (nvmlDeviceGetTemperature_t)GetProcAddress(g_nvmlDll, "nvmlDeviceGetTemperature");
-    g_nvmlDeviceGetPowerUsage = (nvmlDeviceGetPowerUsage_t)GetProcAddress(g_nvmlDll, "nvmlDeviceGetPowerUsage");
+    g_nvmlShutdown = (nvmlShutdown_t)nvmlSymbol(g_nvmlDll, "nvmlShutdown");
+    g_nvmlDeviceGetCount = (nvmlDeviceGetCount_t)nvmlSymbol(g_nvmlDll, "nvmlDeviceGetCount_v2");
+    if (!g_nvmlDeviceGetCount) g_nvmlDeviceGetCount = (nvmlDeviceGetCount_t)nvmlSymbol(g_nvmlDll, "nvmlDeviceGetCount");
+    g_nvmlDeviceGetHandleByIndex = (nvmlDeviceGetHandleByIndex_t)nvmlSymbol(g_nvmlDll, "nvmlDeviceGetHandleByIndex_v2");
+    if (!g_nvmlDeviceGetHandleByIndex) g_nvmlDeviceGetHandleByIndex = (nvmlDeviceGetHandleByIndex_t)nvmlSymbol(g_nvmlDll, "nvmlDeviceGetHandleByIndex");
+    g_nvmlDeviceGetName = (nvmlDeviceGetName_t)nvmlSymbol(g_nvmlDll, "nvmlDeviceGetName");
+    g_nvmlDeviceGetMemoryInfo = (nvmlDeviceGetMemoryInfo_t)nvmlSymbol(g_nvmlDll, "nvmlDeviceGetMemoryInfo");
+    g_nvmlDeviceGetUtilizationRates = (nvmlDeviceGetUtilizationRates_t)nvmlSymbol(g_nvmlDll, "nvmlDeviceGetUtilizationRates");
+    g_nvmlDeviceGetTemperature = (nvmlDeviceGetTemperature_t)nvmlSymbol(g_nvmlDll, "nvmlDeviceGetTemperature");
+    g_nvmlDeviceGetPowerUsage = (nvmlDeviceGetPowerUsage_t)nvmlSymbol(g_nvmlDll, "nvmlDeviceGetPowerUsage");
+    
+    // Optional - older drivers lack some of these and the sampler falls back
+    g_nvmlDeviceGetFieldValues = (nvmlDeviceGetFieldValues_t)nvmlSymbol(g_nvmlDll, "nvmlDeviceGetFieldValues");
+    g_nvmlDeviceGetClockInfo = (nvmlDeviceGetClockInfo_t)nvmlSymbol(g_nvmlDll, "nvmlDeviceGetClockInfo");
+    g_nvmlDeviceGetCurrentClocksThrottleReasons = (nvmlDeviceGetCurrentClocksThrottleReasons_t)nvmlSymbol(g_nvmlDll, "nvmlDeviceGetCurrentClocksEventReasons");
+    if (!g_nvmlDeviceGetCurrentClocksThrottleReasons) g_nvmlDeviceGetCurrentClocksThrottleReasons = (nvmlDeviceGetCurrentClocksThrottleReasons_t)nvmlSymbol(g_nvmlDll, "nvmlDeviceGetCurrentClocksThrottleReasons");
+    g_nvmlDeviceGetPcieThroughput = (nvmlDeviceGetPcieThroughput_t)nvmlSymbol(g_nvmlDll, "nvmlDeviceGetPcieThroughput");
+    g_nvmlEventSetCreate = (nvmlEventSetCreate_t)nvmlSymbol(g_nvmlDll, "nvmlEventSetCreate");
+    g_nvmlEventSetFree = (nvmlEventSetFree_t)nvmlSymbol(g_nvmlDll, "nvmlEventSetFree");
+    g_nvmlDeviceRegisterEvents = (nvmlDeviceRegisterEvents_t)nvmlSymbol(g_nvmlDll, "nvmlDeviceRegisterEvents");
+    g_nvmlEventSetWait = (nvmlEventSetWait_t)nvmlSymbol(g_nvmlDll, "nvmlEventSetWait_v2");
+    if (!g_nvmlEventSetWait) g_nvmlEventSetWait = (nvmlEventSetWait_t)nvmlSymbol(g_nvmlDll, "nvmlEventSetWait");
+    g_nvmlDeviceGetPciInfo = (nvmlDeviceGetPciInfo_t)nvmlSymbol(g_nvmlDll, "nvmlDeviceGetPciInfo_v3");
+    g_nvmlDeviceGetCurrPcieLinkGeneration = (nvmlDeviceGetPcieLinkValue_t)nvmlSymbol(g_nvmlDll, "nvmlDeviceGetCurrPcieLinkGeneration");
+    g_nvmlDeviceGetMaxPcieLinkGeneration = (nvmlDeviceGetPcieLinkValue_t)nvmlSymbol(g_nvmlDll, "nvmlDeviceGetMaxPcieLinkGeneration");
+    g_nvmlDeviceGetCurrPcieLinkWidth = (nvmlDeviceGetPcieLinkValue_t)nvmlSymbol(g_nvmlDll, "nvmlDeviceGetCurrPcieLinkWidth");
+    g_nvmlDeviceGetMaxPcieLinkWidth = (nvmlDeviceGetPcieLinkValue_t)nvmlSymbol(g_nvmlDll, "nvmlDeviceGetMaxPcieLinkWidth");
+    g_nvmlDeviceGetTopologyCommonAncestor = (nvmlDeviceGetTopologyCommonAncestor_t)nvmlSymbol(g_nvmlDll, "nvmlDeviceGetTopologyCommonAncestor");
+    g_nvmlDeviceGetNvLinkState = (nvmlDeviceGetNvLinkState_t)nvmlSymbol(g_nvmlDll, "nvmlDeviceGetNvLinkState");
+    g_nvmlDeviceGetNvLinkRemotePciInfo = (nvmlDeviceGetNvLinkRemotePciInfo_t)nvmlSymbol(g_nvmlDll, "nvmlDeviceGetNvLinkRemotePciInfo_v2");
     
     if (!g_nvmlInit || !g_nvmlShutdown || !g_nvmlDeviceGetHandleByIndex || !g_nvmlDeviceGetCount) {
-        FreeLibrary(g_nvmlDll);
+        closeNvmlLibrary(g_nvmlDll);
         g_nvmlDll = nullptr;
         return false;
     }
@@ -72,33 +231,93 @@ static bool loadNvmlFunctions() {
     return true;
 }
 
-#endif // _WIN32
+static uint64_t fieldValueAsU64(const nvmlFieldValue_t& field) {
+    switch (field.valueType) {
+        case NVML_VALUE_TYPE_DOUBLE: return static_cast<uint64_t>(field.value.dVal);
+        case NVML_VALUE_TYPE_UNSIGNED_INT: return field.value.uiVal;
+        case NVML_VALUE_TYPE_UNSIGNED_LONG: return field.value.ulVal;
+        case NVML_VALUE_TYPE_UNSIGNED_LONG_LONG: return field.value.ullVal;
+        case NVML_VALUE_TYPE_SIGNED_LONG_LONG: return field.value.sllVal < 0 ? 0 : static_cast<uint64_t>(field.value.sllVal);
+        case NVML_VALUE_TYPE_SIGNED_INT: return field.value.siVal < 0 ? 0 : static_cast<uint64_t>(field.value.siVal);
+        default: return 0;
+    }
+}
+
+// nvmlDeviceGetPcieThroughput blocks for a ~20 ms driver sampling window
+// (per direction, per device), so the PCIe thread samples this often
+static const std::chrono::seconds kPcieSampleInterval(5);
+// Link speed/width; GPUs retrain between Gen1 idle and full speed under load
+static const std::chrono::seconds kLinkSampleInterval(10);
 
-GPUMonitor::GPUMonitor() : initialized_(false), gpu_count_(0) {
-#ifdef _WIN32
+GPUMonitor::GPUMonitor(const std::string& sysfs_root)
+    : initialized_(false), gpu_count_(0), sysfs_root_(sysfs_root) {
     initialized_ = initializeNVML();
+    
+#ifdef __linux__
+    // AMD and Intel cards are never visible to NVML
+    sysfs_ = std::make_unique<SysfsGPUBackend>(sysfs_root);
+    if (sysfs_->discover()) {
+        gpu_count_ += static_cast<int>(sysfs_->deviceCount());
+    } else {
+        sysfs_.reset();
+    }
 #endif
+    discoverTopology();
+    
+    if (initialized_ && g_nvmlDeviceGetPcieThroughput) {
+        pcie_thread_ = std::thread(&GPUMonitor::pcieLoop, this);
+    }
 }
 
 GPUMonitor::~GPUMonitor() {
-#ifdef _WIN32
+    if (pcie_thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(pcie_mutex_);
+            pcie_stop_ = true;
+        }
+        pcie_cv_.notify_all();
+        pcie_thread_.join();
+    }
     cleanupNVML();
-#endif
+}
+
+void GPUMonitor::pcieLoop() {
+    std::unique_lock<std::mutex> lock(pcie_mutex_);
+    while (!pcie_stop_) {
+        for (auto& device : devices_) {
+            lock.unlock();
+            unsigned int rx = 0;
+            unsigned int tx = 0;
+            auto handle = static_cast<nvmlDevice_t>(device.handle);
+            bool has_rx = g_nvmlDeviceGetPcieThroughput(handle, NVML_PCIE_UTIL_RX_BYTES, &rx) == NVML_SUCCESS;
+            bool has_tx = g_nvmlDeviceGetPcieThroughput(handle, NVML_PCIE_UTIL_TX_BYTES, &tx) == NVML_SUCCESS;
+            lock.lock();
+            if (pcie_stop_) {
+                return;
+            }
+            if (has_rx) {
+                device.pcie_rx_mb_s = rx / 1024.0;
+            }
+            if (has_tx) {
+                device.pcie_tx_mb_s = tx / 1024.0;
+            }
+        }
+        pcie_cv_.wait_for(lock, kPcieSampleInterval, [this] { return pcie_stop_; });
+    }
 }
 
 bool GPUMonitor::isAvailable() const {
-    return initialized_;
+    return initialized_ || sysfs_;
 }
 
 bool GPUMonitor::initializeNVML() {
-#ifdef _WIN32
     if (!loadNvmlFunctions()) {
         return false;
     }
     
     nvmlReturn_t result = g_nvmlInit();
     if (result != NVML_SUCCESS) {
-        FreeLibrary(g_nvmlDll);
+        closeNvmlLibrary(g_nvmlDll);
         g_nvmlDll = nullptr;
         return false;
     }
@@ -108,16 +327,52 @@ bool GPUMonitor::initializeNVML() {
     result = g_nvmlDeviceGetCount(&deviceCount);
     if (result != NVML_SUCCESS || deviceCount == 0) {
         g_nvmlShutdown();
-        FreeLibrary(g_nvmlDll);
+        closeNvmlLibrary(g_nvmlDll);
         g_nvmlDll = nullptr;
         return false;
     }
     
     gpu_count_ = static_cast<int>(deviceCount);
+    
+    // Resolve handles and names once instead of on every refresh
+    devices_.resize(deviceCount);
+    for (unsigned int i = 0; i < deviceCount; i++) {
+        nvmlDevice_t device = nullptr;
+        if (g_nvmlDeviceGetHandleByIndex(i, &device) != NVML_SUCCESS) {
+            continue;
+        }
+        devices_[i].handle = device;
+        
+        if (g_nvmlDeviceGetName) {
+            char name[NVML_DEVICE_NAME_BUFFER_SIZE];
+            if (g_nvmlDeviceGetName(device, name, NVML_DEVICE_NAME_BUFFER_SIZE) == NVML_SUCCESS) {
+                devices_[i].name = name;
+            }
+        }
+    }
+    
+    // Critical XID errors arrive as events; register every device on one set
+    if (g_nvmlEventSetCreate && g_nvmlDeviceRegisterEvents && g_nvmlEventSetWait) {
+        nvmlEventSet_t event_set = nullptr;
+        if (g_nvmlEventSetCreate(&event_set) == NVML_SUCCESS) {
+            bool registered = false;
+            for (const auto& device : devices_) {
+                if (device.handle &&
+                    g_nvmlDeviceRegisterEvents(static_cast<nvmlDevice_t>(device.handle),
+                                               NVML_EVENT_TYPE_XID_CRITICAL_ERROR,
+                                               event_set) == NVML_SUCCESS) {
+                    registered = true;
+                }
+            }
+            if (registered) {
+                xid_event_set_ = event_set;
+            } else if (g_nvmlEventSetFree) {
+                g_nvmlEventSetFree(event_set);
+            }
+        }
+    }
+    
     return true;
-#else
-    return false;
-#endif
 }
 
 int GPUMonitor::getGPUCount() const {
@@ -125,23 +380,291 @@ int GPUMonitor::getGPUCount() const {
 }
 
 void GPUMonitor::cleanupNVML() {
-#ifdef _WIN32
+    if (xid_event_set_ && g_nvmlEventSetFree) {
+        g_nvmlEventSetFree(static_cast<nvmlEventSet_t>(xid_event_set_));
+    }
+    xid_event_set_ = nullptr;
+    devices_.clear();
+    
     if (g_nvmlDll) {
         if (g_nvmlShutdown) {
             g_nvmlShutdown();
         }
-        FreeLibrary(g_nvmlDll);
+        closeNvmlLibrary(g_nvmlDll);
         g_nvmlDll = nullptr;
     }
     initialized_ = false;
-#endif
 }
 
 bool GPUMonitor::update() {
-    return initialized_;
+    return isAvailable();
+}
+
+void GPUMonitor::discoverTopology() {
+    size_t nvml_count = devices_.size();
+    size_t count = nvml_count + (sysfs_ ? sysfs_->deviceCount() : 0);
+    if (count == 0) {
+        return;
+    }
+    device_topology_.resize(count);
+    
+    // Bus ids from NVML for NVIDIA cards, from the DRM device for the rest
+    for (size_t i = 0; i < nvml_count; i++) {
+        nvmlPciInfo_t pci;
+        if (devices_[i].handle && g_nvmlDeviceGetPciInfo &&
+            g_nvmlDeviceGetPciInfo(static_cast<nvmlDevice_t>(devices_[i].handle), &pci) == NVML_SUCCESS) {
+            device_topology_[i].pci_bus_id = normalizeBusId(pci.busId);
+        }
+    }
+    for (size_t i = nvml_count; i < count; i++) {
+        device_topology_[i].pci_bus_id = sysfs_->pciSlot(i - nvml_count);
+    }
+    for (auto& device : device_topology_) {
+        if (!device.pci_bus_id.empty()) {
+            device.numa_node = pciNumaNode(sysfs_root_, device.pci_bus_id);
+        }
+    }
+    
+    // NVLink lanes per peer; lanes into an NVSwitch reach every GPU on it
+    std::vector<int> lanes(count * count, 0);
+    std::vector<int> switch_lanes(count, 0);
+    for (size_t i = 0; i < nvml_count && g_nvmlDeviceGetNvLinkState && g_nvmlDeviceGetNvLinkRemotePciInfo; i++) {
+        nvmlDevice_t handle = static_cast<nvmlDevice_t>(devices_[i].handle);
+        for (unsigned int link = 0; handle && link < NVML_NVLINK_MAX_LINKS; link++) {
+            int active = 0;
+            nvmlPciInfo_t remote;
+            if (g_nvmlDeviceGetNvLinkState(handle, link, &active) != NVML_SUCCESS || !active ||
+                g_nvmlDeviceGetNvLinkRemotePciInfo(handle, link, &remote) != NVML_SUCCESS) {
+                continue;
+            }
+            std::string remote_bus = normalizeBusId(remote.busId);
+            bool to_gpu = false;
+            for (size_t j = 0; j < count; j++) {
+                if (j != i && device_topology_[j].pci_bus_id == remote_bus) {
+                    lanes[i * count + j]++;
+                    to_gpu = true;
+                }
+            }
+            if (!to_gpu) {
+                switch_lanes[i]++;
+            }
+        }
+    }
+    
+    auto topology = std::make_shared<GPUTopology>();
+    topology->count = static_cast<int>(count);
+    topology->peers.resize(count * count);
+    for (size_t a = 0; a < count; a++) {
+        for (size_t b = 0; b < count; b++) {
+            GPUPeer& peer = topology->peers[a * count + b];
+            if (a == b) {
+                peer.link = GPULink::Self;
+                continue;
+            }
+            int nvlinks = lanes[a * count + b] > 0 ? lanes[a * count + b]
+                        : (switch_lanes[a] < switch_lanes[b] ? switch_lanes[a] : switch_lanes[b]);
+            if (nvlinks > 0) {
+                peer.link = GPULink::NVLink;
+                peer.nvlinks = nvlinks;
+                continue;
+            }
+            
+            // NVML knows the PCIe path between its own devices; sysfs the rest
+            int level = -1;
+            if (a < nvml_count && b < nvml_count && g_nvmlDeviceGetTopologyCommonAncestor &&
+                devices_[a].handle && devices_[b].handle &&
+                g_nvmlDeviceGetTopologyCommonAncestor(static_cast<nvmlDevice_t>(devices_[a].handle),
+                                                      static_cast<nvmlDevice_t>(devices_[b].handle),
+                                                      &level) == NVML_SUCCESS) {
+                if (level <= NVML_TOPOLOGY_MULTIPLE) {
+                    peer.link = GPULink::Switch;
+                } else if (level == NVML_TOPOLOGY_HOSTBRIDGE) {
+                    peer.link = GPULink::HostBridge;
+                } else if (level == NVML_TOPOLOGY_NODE) {
+                    peer.link = GPULink::Node;
+                } else {
+                    peer.link = GPULink::System;
+                }
+                continue;
+            }
+            peer = pciPeer(sysfs_root_, device_topology_[a].pci_bus_id, device_topology_[a].numa_node,
+                           device_topology_[b].pci_bus_id, device_topology_[b].numa_node);
+        }
+    }
+    topology_ = std::move(topology);
+    sampleLinks();
+}
+
+void GPUMonitor::sampleLinks() {
+    links_sampled_at_ = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < device_topology_.size(); i++) {
+        DeviceTopology& device = device_topology_[i];
+        
+        // NVML first for NVIDIA cards; sysfs works for any PCI device
+        nvmlDevice_t handle = i < devices_.size() ? static_cast<nvmlDevice_t>(devices_[i].handle) : nullptr;
+        unsigned int gen = 0, gen_max = 0, width = 0, width_max = 0;
+        if (handle && g_nvmlDeviceGetCurrPcieLinkGeneration && g_nvmlDeviceGetMaxPcieLinkGeneration &&
+            g_nvmlDeviceGetCurrPcieLinkWidth && g_nvmlDeviceGetMaxPcieLinkWidth &&
+            g_nvmlDeviceGetCurrPcieLinkGeneration(handle, &gen) == NVML_SUCCESS &&
+            g_nvmlDeviceGetMaxPcieLinkGeneration(handle, &gen_max) == NVML_SUCCESS &&
+            g_nvmlDeviceGetCurrPcieLinkWidth(handle, &width) == NVML_SUCCESS &&
+            g_nvmlDeviceGetMaxPcieLinkWidth(handle, &width_max) == NVML_SUCCESS) {
+            device.pcie_gen = static_cast<int>(gen);
+            device.pcie_gen_max = static_cast<int>(gen_max);
+            device.pcie_width = static_cast<int>(width);
+            device.pcie_width_max = static_cast<int>(width_max);
+        } else if (!device.pci_bus_id.empty()) {
+            readPciLink(sysfs_root_, device.pci_bus_id, device.pcie_gen, device.pcie_gen_max,
+                        device.pcie_width, device.pcie_width_max);
+        }
+    }
+}
+
+void GPUMonitor::drainXidEvents() {
+    if (!xid_event_set_) {
+        return;
+    }
+    
+    // Non-blocking drain; a zero timeout returns an error once the set is empty
+    nvmlEventData_t data;
+    for (int n = 0; n < 64; n++) {
+        std::memset(&data, 0, sizeof(data));
+        if (g_nvmlEventSetWait(static_cast<nvmlEventSet_t>(xid_event_set_), &data, 0) != NVML_SUCCESS) {
+            break;
+        }
+        for (auto& device : devices_) {
+            if (device.handle == data.device) {
+                device.xid_errors++;
+                device.last_xid = static_cast<int>(data.eventData);
+                break;
+            }
+        }
+    }
+}
+
+void GPUMonitor::sampleNVMLDevice(DeviceState& device, GPUInfo& info) {
+    nvmlDevice_t handle = static_cast<nvmlDevice_t>(device.handle);
+    
+    info.name = device.name;
+    info.has_extended_metrics = true;
+    
+    // Get memory info
+    if (g_nvmlDeviceGetMemoryInfo) {
+        nvmlMemory_t memory;
+        if (g_nvmlDeviceGetMemoryInfo(handle, &memory) == NVML_SUCCESS) {
+            info.total_vram_gb = static_cast<double>(memory.total) / (1024.0 * 1024.0 * 1024.0);
+            info.used_vram_gb = static_cast<double>(memory.used) / (1024.0 * 1024.0 * 1024.0);
+            info.free_vram_gb = static_cast<double>(memory.free) / (1024.0 * 1024.0 * 1024.0);
+        }
+    }
+    
+    // Get GPU and memory-bandwidth utilization
+    if (g_nvmlDeviceGetUtilizationRates) {
+        nvmlUtilization_t utilization;
+        if (g_nvmlDeviceGetUtilizationRates(handle, &utilization) == NVML_SUCCESS) {
+            info.utilization_percent = static_cast<double>(utilization.gpu);
+            info.memory_util_percent = static_cast<double>(utilization.memory);
+        }
+    }
+    
+    // Get temperature
+    if (g_nvmlDeviceGetTemperature) {
+        unsigned int temp;
+        if (g_nvmlDeviceGetTemperature(handle, NVML_TEMPERATURE_GPU, &temp) == NVML_SUCCESS) {
+            info.temperature_c = static_cast<int>(temp);
+        }
+    }
+    
+    // Power, ECC and PCIe replay counters in a single batched call
+    bool have_power = false;
+    if (device.field_values_supported && g_nvmlDeviceGetFieldValues) {
+        nvmlFieldValue_t fields[5];
+        std::memset(fields, 0, sizeof(fields));
+        fields[0].fieldId = NVML_FI_DEV_POWER_INSTANT;
+        fields[1].fieldId = NVML_FI_DEV_ECC_CURRENT;
+        fields[2].fieldId = NVML_FI_DEV_ECC_SBE_VOL_TOTAL;
+        fields[3].fieldId = NVML_FI_DEV_ECC_DBE_VOL_TOTAL;
+        fields[4].fieldId = NVML_FI_DEV_PCIE_REPLAY_COUNTER;
+        
+        int succeeded = 0;
+        if (g_nvmlDeviceGetFieldValues(handle, 5, fields) == NVML_SUCCESS) {
+            for (const auto& field : fields) {
+                if (field.nvmlReturn != NVML_SUCCESS) {
+                    continue;
+                }
+                succeeded++;
+                uint64_t value = fieldValueAsU64(field);
+                switch (field.fieldId) {
+                    case NVML_FI_DEV_POWER_INSTANT:
+                        info.power_watts = static_cast<int>(value / 1000); // Convert from milliwatts
+                        info.power_milliwatts = static_cast<int>(value);
+                        info.power_sampled_at = std::chrono::steady_clock::now();
+                        have_power = true;
+                        break;
+                    case NVML_FI_DEV_ECC_CURRENT:
+                        info.ecc_enabled = value != 0;
+                        break;
+                    case NVML_FI_DEV_ECC_SBE_VOL_TOTAL:
+                        info.ecc_corrected = value;
+                        break;
+                    case NVML_FI_DEV_ECC_DBE_VOL_TOTAL:
+                        info.ecc_uncorrected = value;
+                        break;
+                    case NVML_FI_DEV_PCIE_REPLAY_COUNTER:
+                        info.pcie_replays = value;
+                        break;
+                }
+            }
+        }
+        
+        // Driver doesn't know any of these fields - stop asking
+        if (succeeded == 0) {
+            device.field_values_supported = false;
+        }
+    }
+    
+    // Per-call fallback for drivers without field values
+    if (!have_power && g_nvmlDeviceGetPowerUsage) {
+        unsigned int power;
+        if (g_nvmlDeviceGetPowerUsage(handle, &power) == NVML_SUCCESS) {
+            info.power_watts = static_cast<int>(power / 1000); // Convert from milliwatts
+            info.power_milliwatts = static_cast<int>(power);
+            info.power_sampled_at = std::chrono::steady_clock::now();
+        }
+    }
+    
+    // Get clocks
+    if (g_nvmlDeviceGetClockInfo) {
+        unsigned int clock;
+        if (g_nvmlDeviceGetClockInfo(handle, NVML_CLOCK_SM, &clock) == NVML_SUCCESS) {
+            info.sm_clock_mhz = static_cast<int>(clock);
+        }
+        if (g_nvmlDeviceGetClockInfo(handle, NVML_CLOCK_MEM, &clock) == NVML_SUCCESS) {
+            info.mem_clock_mhz = static_cast<int>(clock);
+        }
+    }
+    
+    // Get throttle reasons
+    if (g_nvmlDeviceGetCurrentClocksThrottleReasons) {
+        unsigned long long reasons;
+        if (g_nvmlDeviceGetCurrentClocksThrottleReasons(handle, &reasons) == NVML_SUCCESS) {
+            info.throttle_reasons = reasons;
+        }
+    }
+    
+    // PCIe throughput, as last sampled by the PCIe thread
+    if (g_nvmlDeviceGetPcieThroughput) {
+        std::lock_guard<std::mutex> lock(pcie_mutex_);
+        info.pcie_rx_mb_s = device.pcie_rx_mb_s;
+        info.pcie_tx_mb_s = device.pcie_tx_mb_s;
+    }
+    
+    info.xid_errors = device.xid_errors;
+    info.last_xid = device.last_xid;
 }
 
 std::vector<GPUInfo> GPUMonitor::getGPUInfo() {
+    PROFILE_SCOPE(GpuInfo);
     std::vector<GPUInfo> infos;
     
 #ifdef _WIN32
@@ -182,64 +705,46 @@ std::vector<GPUInfo> GPUMonitor::getGPUInfo() {
         }
         return infos;
     }
+#endif
     
-    // NVML path - enumerate all GPUs
-    for (int i = 0; i < gpu_count_; i++) {
-        GPUInfo info;
-        info.index = i;
-        
-        nvmlDevice_t device;
-        if (g_nvmlDeviceGetHandleByIndex(static_cast<unsigned int>(i), &device) != NVML_SUCCESS) {
-            continue;
-        }
-        
-        info.available = true;
-        
-        // Get GPU name
-        if (g_nvmlDeviceGetName) {
-            char name[NVML_DEVICE_NAME_BUFFER_SIZE];
-            if (g_nvmlDeviceGetName(device, name, NVML_DEVICE_NAME_BUFFER_SIZE) == NVML_SUCCESS) {
-                info.name = name;
-            }
-        }
-        
-        // Get memory info
-        if (g_nvmlDeviceGetMemoryInfo) {
-            nvmlMemory_t memory;
-            if (g_nvmlDeviceGetMemoryInfo(device, &memory) == NVML_SUCCESS) {
-                info.total_vram_gb = static_cast<double>(memory.total) / (1024.0 * 1024.0 * 1024.0);
-                info.used_vram_gb = static_cast<double>(memory.used) / (1024.0 * 1024.0 * 1024.0);
-                info.free_vram_gb = static_cast<double>(memory.free) / (1024.0 * 1024.0 * 1024.0);
-            }
-        }
-        
-        // Get GPU utilization
-        if (g_nvmlDeviceGetUtilizationRates) {
-            nvmlUtilization_t utilization;
-            if (g_nvmlDeviceGetUtilizationRates(device, &utilization) == NVML_SUCCESS) {
-                info.utilization_percent = static_cast<double>(utilization.gpu);
-            }
-        }
+    infos.reserve(gpu_count_);
+    
+    if (initialized_ && g_nvmlDll) {
+        drainXidEvents();
         
-        // Get temperature
-        if (g_nvmlDeviceGetTemperature) {
-            unsigned int temp;
-            if (g_nvmlDeviceGetTemperature(device, NVML_TEMPERATURE_GPU, &temp) == NVML_SUCCESS) {
-                info.temperature_c = static_cast<int>(temp);
+        // NVML path - enumerate all GPUs
+        for (int i = 0; i < static_cast<int>(devices_.size()); i++) {
+            if (!devices_[i].handle) {
+                continue;
             }
+            
+            GPUInfo info;
+            info.index = i;
+            info.available = true;
+            sampleNVMLDevice(devices_[i], info);
+            infos.push_back(info);
         }
-        
-        // Get power usage
-        if (g_nvmlDeviceGetPowerUsage) {
-            unsigned int power;
-            if (g_nvmlDeviceGetPowerUsage(device, &power) == NVML_SUCCESS) {
-                info.power_watts = static_cast<int>(power / 1000); // Convert from milliwatts
-            }
+    }
+    
+    // sysfs devices are numbered after the NVIDIA ones
+    if (sysfs_) {
+        sysfs_->sample(infos, static_cast<int>(devices_.size()));
+    }
+    
+    if (std::chrono::steady_clock::now() - links_sampled_at_ >= kLinkSampleInterval) {
+        sampleLinks();
+    }
+    for (auto& info : infos) {
+        if (info.index >= 0 && static_cast<size_t>(info.index) < device_topology_.size()) {
+            const DeviceTopology& device = device_topology_[static_cast<size_t>(info.index)];
+            info.pci_bus_id = device.pci_bus_id;
+            info.numa_node = device.numa_node;
+            info.pcie_gen = device.pcie_gen;
+            info.pcie_gen_max = device.pcie_gen_max;
+            info.pcie_width = device.pcie_width;
+            info.pcie_width_max = device.pcie_width_max;
         }
-        
-        infos.push_back(info);
     }
-#endif
     
     return infos;
 }
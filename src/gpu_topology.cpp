@@ -0,0 +1,224 @@
+#include "../include/gpu_topology.h"
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+#ifdef __linux__
+#include <climits>
+#endif
+
+// Utilization above which a link below its top speed is worth a warning;
+// idle GPUs drop to Gen1 on purpose
+static const double kBusyPercent = 50.0;
+
+std::string gpuLinkLabel(const GPUPeer& peer) {
+    switch (peer.link) {
+    case GPULink::Self:
+        return "X";
+    case GPULink::NVLink:
+        return "NV" + std::to_string(peer.nvlinks);
+    case GPULink::XGMI:
+        return "XGMI";
+    case GPULink::Switch:
+        return "PIX";
+    case GPULink::HostBridge:
+        return "PHB";
+    case GPULink::Node:
+        return "NODE";
+    case GPULink::System:
+        return "SYS";
+    default:
+        return "?";
+    }
+}
+
+std::string normalizeBusId(const std::string& bus_id) {
+    // NVML pads the domain to 8 digits and uses upper case
+    std::string result = bus_id;
+    size_t colon = result.find(':');
+    if (colon != std::string::npos && colon > 4 && result.find(':', colon + 1) != std::string::npos) {
+        result.erase(0, colon - 4);
+    }
+    for (char& c : result) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return result;
+}
+
+static std::string deviceDir(const std::string& root, const std::string& bus_id) {
+    return root + (root.empty() || root.back() == '/' ? "" : "/") + "sys/bus/pci/devices/" + bus_id;
+}
+
+static std::string readLine(const std::string& path) {
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+int pciNumaNode(const std::string& root, const std::string& bus_id) {
+    std::string text = readLine(deviceDir(root, bus_id) + "/numa_node");
+    return text.empty() ? -1 : std::atoi(text.c_str());
+}
+
+// "16.0 GT/s PCIe" -> 4
+static int linkGeneration(const std::string& speed) {
+    double gts = std::strtod(speed.c_str(), nullptr);
+    static const double kGenSpeeds[] = {2.5, 5.0, 8.0, 16.0, 32.0, 64.0};
+    int gen = 0;
+    for (double gen_speed : kGenSpeeds) {
+        if (gts >= gen_speed) {
+            gen++;
+        }
+    }
+    return gen;
+}
+
+bool readPciLink(const std::string& root, const std::string& bus_id,
+                 int& gen, int& gen_max, int& width, int& width_max) {
+    std::string dir = deviceDir(root, bus_id);
+    gen = linkGeneration(readLine(dir + "/current_link_speed"));
+    gen_max = linkGeneration(readLine(dir + "/max_link_speed"));
+    width = std::atoi(readLine(dir + "/current_link_width").c_str());
+    width_max = std::atoi(readLine(dir + "/max_link_width").c_str());
+    return gen > 0 || width > 0;
+}
+
+#ifdef __linux__
+
+// Components of the device's path below /sys/devices: the root complex
+// ("pci0000:00"), then each bridge, then the device itself
+static std::vector<std::string> pciPath(const std::string& root, const std::string& bus_id) {
+    std::vector<std::string> parts;
+    char resolved[PATH_MAX];
+    if (!realpath(deviceDir(root, bus_id).c_str(), resolved)) {
+        return parts;
+    }
+    std::string path = resolved;
+    size_t pos = path.find("/devices/pci");
+    if (pos == std::string::npos) {
+        return parts;
+    }
+    pos += 9;
+    while (pos < path.size()) {
+        size_t slash = path.find('/', pos);
+        parts.push_back(path.substr(pos, slash == std::string::npos ? std::string::npos : slash - pos));
+        pos = slash == std::string::npos ? path.size() : slash + 1;
+    }
+    return parts;
+}
+
+#endif
+
+GPUPeer pciPeer(const std::string& root, const std::string& bus_a, int node_a,
+                const std::string& bus_b, int node_b) {
+    GPUPeer peer;
+    if (bus_a.empty() || bus_b.empty()) {
+        return peer;
+    }
+    if (bus_a == bus_b) {
+        peer.link = GPULink::Self;
+        return peer;
+    }
+
+    // amdgpu cards in one Infinity Fabric hive share a non-zero hive id
+    std::string hive = readLine(deviceDir(root, bus_a) + "/xgmi_hive_id");
+    if (!hive.empty() && hive != "0" && hive == readLine(deviceDir(root, bus_b) + "/xgmi_hive_id")) {
+        peer.link = GPULink::XGMI;
+        return peer;
+    }
+
+    bool cross_socket = node_a >= 0 && node_b >= 0 && node_a != node_b;
+#ifdef __linux__
+    auto path_a = pciPath(root, bus_a);
+    auto path_b = pciPath(root, bus_b);
+    if (path_a.size() >= 2 && path_b.size() >= 2) {
+        if (path_a[0] != path_b[0]) {
+            peer.link = cross_socket ? GPULink::System : GPULink::Node;
+            return peer;
+        }
+        // A shared bridge below the root complex is a switch (or its root port)
+        bool shared_bridge = path_a.size() > 2 && path_b.size() > 2 && path_a[1] == path_b[1];
+        peer.link = shared_bridge ? GPULink::Switch : GPULink::HostBridge;
+        return peer;
+    }
+#endif
+    if (cross_socket) {
+        peer.link = GPULink::System;
+    }
+    return peer;
+}
+
+static std::string nodeList(uint64_t mask) {
+    std::string text;
+    for (int node = 0; node < 64; node++) {
+        if (mask & (1ULL << node)) {
+            if (!text.empty()) {
+                text += ',';
+            }
+            text += std::to_string(node);
+        }
+    }
+    return text;
+}
+
+std::vector<TopologyWarning> checkPlacement(const std::vector<GPUInfo>& gpus, const GPUTopology* topology,
+                                            const HostInfo& host) {
+    std::vector<TopologyWarning> warnings;
+    char text[192];
+
+    for (const auto& gpu : gpus) {
+        if (gpu.pcie_width > 0 && gpu.pcie_width < gpu.pcie_width_max) {
+            std::snprintf(text, sizeof(text), "GPU%d PCIe link trained at x%d of x%d (check the slot and riser)",
+                          gpu.index, gpu.pcie_width, gpu.pcie_width_max);
+            warnings.push_back({false, text});
+        } else if (gpu.pcie_gen > 0 && gpu.pcie_gen < gpu.pcie_gen_max && gpu.utilization_percent >= kBusyPercent) {
+            std::snprintf(text, sizeof(text), "GPU%d PCIe link at Gen%d of Gen%d while %.0f%% busy",
+                          gpu.index, gpu.pcie_gen, gpu.pcie_gen_max, gpu.utilization_percent);
+            warnings.push_back({false, text});
+        }
+    }
+
+    for (const auto& runner : host.runners) {
+        std::vector<const GPUInfo*> used;
+        for (const auto& gpu : gpus) {
+            for (const auto& bus_id : runner.gpus) {
+                if (!gpu.pci_bus_id.empty() && gpu.pci_bus_id == bus_id) {
+                    used.push_back(&gpu);
+                    break;
+                }
+            }
+        }
+
+        // Pinned (taskset, numactl, a cgroup cpuset) to CPUs on another socket
+        if (host.numa_nodes > 1 && runner.cpu_nodes != 0) {
+            for (const GPUInfo* gpu : used) {
+                if (gpu->numa_node >= 0 && gpu->numa_node < 64 && !(runner.cpu_nodes & (1ULL << gpu->numa_node))) {
+                    std::snprintf(text, sizeof(text), "Runner %d runs on CPUs of node %s, GPU%d is on node %d",
+                                  runner.pid, nodeList(runner.cpu_nodes).c_str(), gpu->index, gpu->numa_node);
+                    warnings.push_back({true, text});
+                }
+            }
+        }
+
+        // Split models exchange activations between GPUs on every token
+        for (size_t a = 0; topology && a < used.size(); a++) {
+            for (size_t b = a + 1; b < used.size(); b++) {
+                GPUPeer peer = topology->peer(used[a]->index, used[b]->index);
+                if (peer.link == GPULink::System) {
+                    std::snprintf(text, sizeof(text), "Runner %d splits a model across GPU%d and GPU%d over the "
+                                  "inter-socket link (SYS)", runner.pid, used[a]->index, used[b]->index);
+                    warnings.push_back({true, text});
+                } else if (peer.link == GPULink::Switch || peer.link == GPULink::HostBridge ||
+                           peer.link == GPULink::Node) {
+                    std::snprintf(text, sizeof(text), "Runner %d splits a model across GPU%d and GPU%d over "
+                                  "PCIe (%s), no NVLink", runner.pid, used[a]->index, used[b]->index,
+                                  gpuLinkLabel(peer).c_str());
+                    warnings.push_back({false, text});
+                }
+            }
+        }
+    }
+    return warnings;
+}
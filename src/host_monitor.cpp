@@ -0,0 +1,484 @@
+#include "../include/host_monitor.h"
+#include "../include/profiler.h"
+#include <algorithm>
+#include <charconv>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// How often /proc is rescanned for new runner processes
+static const std::chrono::seconds kRunnerScanInterval(5);
+
+#ifdef __linux__
+
+static int openProc(const std::string& path) {
+    return open(path.c_str(), O_RDONLY | O_CLOEXEC);
+}
+
+// Re-read a /proc file from offset 0; returns bytes read or 0
+static size_t readProc(int fd, char* buf, size_t size) {
+    if (fd < 0) {
+        return 0;
+    }
+    ssize_t n = pread(fd, buf, size - 1, 0);
+    if (n <= 0) {
+        return 0;
+    }
+    buf[n] = '\0';
+    return static_cast<size_t>(n);
+}
+
+static const char* skipSpaces(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        p++;
+    }
+    return p;
+}
+
+// Parse the next unsigned integer, advancing p past it
+static uint64_t nextU64(const char*& p, const char* end) {
+    p = skipSpaces(p, end);
+    uint64_t value = 0;
+    auto result = std::from_chars(p, end, value);
+    p = result.ptr;
+    return value;
+}
+
+// Value of a "Key:   1234 kB" line in meminfo/status style files
+static uint64_t fieldValue(std::string_view text, std::string_view key) {
+    size_t pos = 0;
+    while ((pos = text.find(key, pos)) != std::string_view::npos) {
+        if ((pos == 0 || text[pos - 1] == '\n') && pos + key.size() < text.size() &&
+            text[pos + key.size()] == ':') {
+            const char* p = text.data() + pos + key.size() + 1;
+            return nextU64(p, text.data() + text.size());
+        }
+        pos += key.size();
+    }
+    return 0;
+}
+
+// avg10 of the "some" or "full" line of a PSI file
+static double pressureAvg10(std::string_view text, std::string_view line) {
+    size_t pos = text.find(line);
+    if (pos == std::string_view::npos) {
+        return 0.0;
+    }
+    pos = text.find("avg10=", pos);
+    if (pos == std::string_view::npos) {
+        return 0.0;
+    }
+    double value = 0.0;
+    std::from_chars(text.data() + pos + 6, text.data() + text.size(), value);
+    return value;
+}
+
+// Calls fn(cpu) for each CPU in a "0-3,8,10-11" list
+template <typename Fn>
+static void forEachCpu(std::string_view list, Fn fn) {
+    const char* p = list.data();
+    const char* end = p + list.size();
+    while (p < end) {
+        unsigned first = 0;
+        auto result = std::from_chars(p, end, first);
+        if (result.ec != std::errc()) {
+            break;
+        }
+        unsigned last = first;
+        p = result.ptr;
+        if (p < end && *p == '-') {
+            result = std::from_chars(p + 1, end, last);
+            p = result.ptr;
+        }
+        for (unsigned cpu = first; cpu <= last && cpu < 65536; cpu++) {
+            fn(cpu);
+        }
+        if (p >= end || *p != ',') {
+            break;
+        }
+        p++;
+    }
+}
+
+// PCI address a /dev/dri or /dev/nvidia<minor> node belongs to, or ""
+static std::string gpuBusId(const std::string& device) {
+    char resolved[PATH_MAX];
+    if (device.compare(0, 9, "/dev/dri/") == 0) {
+        std::string link = "/sys/class/drm/" + device.substr(9) + "/device";
+        if (!realpath(link.c_str(), resolved)) {
+            return "";
+        }
+        std::string path = resolved;
+        return path.substr(path.rfind('/') + 1);
+    }
+
+    // The NVIDIA driver lists "Device Minor: <n>" per bus id
+    if (device.compare(0, 11, "/dev/nvidia") != 0) {
+        return "";
+    }
+    int minor = 0;
+    auto result = std::from_chars(device.c_str() + 11, device.c_str() + device.size(), minor);
+    if (result.ec != std::errc() || *result.ptr != '\0') {
+        return "";
+    }
+    DIR* gpus = opendir("/proc/driver/nvidia/gpus");
+    if (!gpus) {
+        return "";
+    }
+    std::string bus_id;
+    while (struct dirent* entry = readdir(gpus)) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        char buf[1024];
+        int fd = openProc(std::string("/proc/driver/nvidia/gpus/") + entry->d_name + "/information");
+        size_t n = readProc(fd, buf, sizeof(buf));
+        if (fd >= 0) {
+            close(fd);
+        }
+        std::string_view text(buf, n);
+        if (text.find("Device Minor:") != std::string_view::npos &&
+            fieldValue(text, "Device Minor") == static_cast<uint64_t>(minor)) {
+            bus_id = entry->d_name;
+            break;
+        }
+    }
+    closedir(gpus);
+    return bus_id;
+}
+
+// Bus ids of the GPU device nodes a process has open
+static std::vector<std::string> openGpus(int pid) {
+    std::vector<std::string> bus_ids;
+    std::string dir = "/proc/" + std::to_string(pid) + "/fd";
+    DIR* fds = opendir(dir.c_str());
+    if (!fds) {
+        return bus_ids;
+    }
+    while (struct dirent* entry = readdir(fds)) {
+        char target[256];
+        ssize_t n = readlink((dir + "/" + entry->d_name).c_str(), target, sizeof(target) - 1);
+        if (n <= 0 || std::strncmp(target, "/dev/", 5) != 0) {
+            continue;
+        }
+        target[n] = '\0';
+        std::string bus_id = gpuBusId(target);
+        if (!bus_id.empty() && std::find(bus_ids.begin(), bus_ids.end(), bus_id) == bus_ids.end()) {
+            bus_ids.push_back(bus_id);
+        }
+    }
+    closedir(fds);
+    std::sort(bus_ids.begin(), bus_ids.end());
+    return bus_ids;
+}
+
+#endif // __linux__
+
+HostMonitor::HostMonitor() {
+#ifdef __linux__
+    stat_fd_ = openProc("/proc/stat");
+    meminfo_fd_ = openProc("/proc/meminfo");
+    psi_cpu_fd_ = openProc("/proc/pressure/cpu");
+    psi_mem_fd_ = openProc("/proc/pressure/memory");
+    psi_io_fd_ = openProc("/proc/pressure/io");
+    clock_ticks_ = sysconf(_SC_CLK_TCK);
+
+    // CPU -> NUMA node, for telling which sockets a runner's affinity covers
+    if (DIR* nodes = opendir("/sys/devices/system/node")) {
+        while (struct dirent* entry = readdir(nodes)) {
+            int node = 0;
+            const char* name_end = entry->d_name + std::strlen(entry->d_name);
+            if (std::strncmp(entry->d_name, "node", 4) != 0 ||
+                std::from_chars(entry->d_name + 4, name_end, node).ptr != name_end || node >= 64) {
+                continue;
+            }
+            int fd = openProc(std::string("/sys/devices/system/node/") + entry->d_name + "/cpulist");
+            size_t n = readProc(fd, buf_, sizeof(buf_));
+            if (fd >= 0) {
+                close(fd);
+            }
+            bool has_cpus = false;
+            forEachCpu(std::string_view(buf_, n), [&](unsigned cpu) {
+                if (cpu >= cpu_node_.size()) {
+                    cpu_node_.resize(cpu + 1, 0);
+                }
+                cpu_node_[cpu] = static_cast<uint8_t>(node);
+                has_cpus = true;
+            });
+            numa_nodes_ += has_cpus ? 1 : 0;
+        }
+        closedir(nodes);
+    }
+#endif
+}
+
+HostMonitor::~HostMonitor() {
+#ifdef __linux__
+    for (int fd : {stat_fd_, meminfo_fd_, psi_cpu_fd_, psi_mem_fd_, psi_io_fd_}) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+    for (auto& runner : runners_) {
+        closeRunner(runner);
+    }
+#endif
+}
+
+HostInfo HostMonitor::getHostInfo() {
+    PROFILE_SCOPE(HostInfo);
+    HostInfo info;
+#ifdef __linux__
+    if (stat_fd_ < 0) {
+        return info;
+    }
+    info.available = true;
+    info.cpu_count = static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN));
+    info.numa_nodes = numa_nodes_;
+
+    sampleCpu(info);
+    sampleMemory(info);
+    samplePressure(info);
+    sampleRunners(info);
+#endif
+    return info;
+}
+
+void HostMonitor::sampleCpu(HostInfo& info) {
+#ifdef __linux__
+    // Only the aggregate "cpu" line is needed; it always fits in the buffer
+    // even though the full file can be tens of KB on large machines
+    size_t n = readProc(stat_fd_, buf_, sizeof(buf_));
+    if (n < 4 || std::memcmp(buf_, "cpu ", 4) != 0) {
+        return;
+    }
+
+    const char* p = buf_ + 4;
+    const char* end = buf_ + n;
+    uint64_t fields[8] = {};
+    for (auto& field : fields) {
+        field = nextU64(p, end);
+    }
+    // user nice system idle iowait irq softirq steal
+    uint64_t total = 0;
+    for (uint64_t field : fields) {
+        total += field;
+    }
+    uint64_t idle = fields[3] + fields[4];
+    uint64_t iowait = fields[4];
+
+    if (last_cpu_total_ > 0 && total > last_cpu_total_) {
+        double delta = static_cast<double>(total - last_cpu_total_);
+        info.cpu_percent = 100.0 * (delta - static_cast<double>(idle - last_cpu_idle_)) / delta;
+        info.iowait_percent = 100.0 * static_cast<double>(iowait - last_cpu_iowait_) / delta;
+    }
+    last_cpu_total_ = total;
+    last_cpu_idle_ = idle;
+    last_cpu_iowait_ = iowait;
+#else
+    (void)info;
+#endif
+}
+
+void HostMonitor::sampleMemory(HostInfo& info) {
+#ifdef __linux__
+    size_t n = readProc(meminfo_fd_, buf_, sizeof(buf_));
+    std::string_view text(buf_, n);
+    info.mem_total_bytes = fieldValue(text, "MemTotal") * 1024;
+    info.mem_available_bytes = fieldValue(text, "MemAvailable") * 1024;
+    info.swap_total_bytes = fieldValue(text, "SwapTotal") * 1024;
+    info.swap_free_bytes = fieldValue(text, "SwapFree") * 1024;
+#else
+    (void)info;
+#endif
+}
+
+void HostMonitor::samplePressure(HostInfo& info) {
+#ifdef __linux__
+    if (psi_cpu_fd_ < 0 && psi_mem_fd_ < 0 && psi_io_fd_ < 0) {
+        return;
+    }
+    info.has_pressure = true;
+
+    size_t n = readProc(psi_cpu_fd_, buf_, sizeof(buf_));
+    info.cpu_pressure_some = pressureAvg10(std::string_view(buf_, n), "some");
+    n = readProc(psi_mem_fd_, buf_, sizeof(buf_));
+    info.mem_pressure_some = pressureAvg10(std::string_view(buf_, n), "some");
+    info.mem_pressure_full = pressureAvg10(std::string_view(buf_, n), "full");
+    n = readProc(psi_io_fd_, buf_, sizeof(buf_));
+    info.io_pressure_some = pressureAvg10(std::string_view(buf_, n), "some");
+#else
+    (void)info;
+#endif
+}
+
+void HostMonitor::closeRunner(RunnerState& runner) {
+#ifdef __linux__
+    if (runner.stat_fd >= 0) {
+        close(runner.stat_fd);
+    }
+    if (runner.status_fd >= 0) {
+        close(runner.status_fd);
+    }
+#endif
+    runner.stat_fd = -1;
+    runner.status_fd = -1;
+}
+
+void HostMonitor::scanRunners() {
+#ifdef __linux__
+    DIR* proc = opendir("/proc");
+    if (!proc) {
+        return;
+    }
+
+    while (struct dirent* entry = readdir(proc)) {
+        int pid = 0;
+        const char* name_end = entry->d_name + std::strlen(entry->d_name);
+        auto result = std::from_chars(entry->d_name, name_end, pid);
+        if (result.ec != std::errc() || result.ptr != name_end) {
+            continue;
+        }
+
+        bool known = false;
+        for (const auto& runner : runners_) {
+            if (runner.pid == pid) {
+                known = true;
+                break;
+            }
+        }
+        if (known) {
+            continue;
+        }
+
+        // Runners are "ollama runner ..." (or ollama_llama_server on older releases)
+        std::string dir = std::string("/proc/") + entry->d_name;
+        int fd = openProc(dir + "/cmdline");
+        size_t n = readProc(fd, buf_, sizeof(buf_));
+        if (fd >= 0) {
+            close(fd);
+        }
+        if (n == 0) {
+            continue;
+        }
+
+        std::string_view argv0(buf_);
+        size_t slash = argv0.rfind('/');
+        std::string_view exe = slash == std::string_view::npos ? argv0 : argv0.substr(slash + 1);
+        bool is_runner = exe.find("ollama_llama_server") != std::string_view::npos;
+        if (!is_runner && exe.find("ollama") != std::string_view::npos) {
+            size_t arg1 = argv0.size() + 1;
+            is_runner = arg1 < n && std::string_view(buf_ + arg1) == "runner";
+        }
+        if (!is_runner) {
+            continue;
+        }
+
+        RunnerState runner;
+        runner.pid = pid;
+        runner.stat_fd = openProc(dir + "/stat");
+        runner.status_fd = openProc(dir + "/status");
+        if (runner.stat_fd < 0) {
+            closeRunner(runner);
+            continue;
+        }
+        runners_.push_back(runner);
+    }
+    closedir(proc);
+
+    // Device nodes change as runners load models onto other GPUs
+    for (auto& runner : runners_) {
+        runner.gpus = openGpus(runner.pid);
+    }
+#endif
+}
+
+void HostMonitor::sampleRunners(HostInfo& info) {
+#ifdef __linux__
+    auto now = std::chrono::steady_clock::now();
+    if (now - last_runner_scan_ >= kRunnerScanInterval) {
+        last_runner_scan_ = now;
+        scanRunners();
+    }
+
+    for (size_t i = 0; i < runners_.size();) {
+        RunnerState& runner = runners_[i];
+
+        // A read failure on an open /proc fd means the process has exited
+        size_t n = readProc(runner.stat_fd, buf_, sizeof(buf_));
+        const char* comm_end = n > 0 ? static_cast<const char*>(memrchr(buf_, ')', n)) : nullptr;
+        if (!comm_end) {
+            closeRunner(runner);
+            runners_.erase(runners_.begin() + static_cast<long>(i));
+            continue;
+        }
+
+        // Fields after "pid (comm)": state is field 3, utime 14, stime 15, num_threads 20
+        const char* p = comm_end + 2;
+        const char* end = buf_ + n;
+        int field = 3;
+        uint64_t utime = 0, stime = 0, threads = 0;
+        while (p < end && field <= 20) {
+            if (field == 14) {
+                utime = nextU64(p, end);
+            } else if (field == 15) {
+                stime = nextU64(p, end);
+            } else if (field == 20) {
+                threads = nextU64(p, end);
+            } else {
+                while (p < end && *p != ' ') {
+                    p++;
+                }
+            }
+            p = skipSpaces(p, end);
+            field++;
+        }
+
+        RunnerProcess process;
+        process.pid = runner.pid;
+        process.threads = static_cast<int>(threads);
+
+        uint64_t ticks = utime + stime;
+        if (runner.last_sample != std::chrono::steady_clock::time_point{} && ticks >= runner.last_ticks) {
+            double seconds = std::chrono::duration<double>(now - runner.last_sample).count();
+            if (seconds > 0 && clock_ticks_ > 0) {
+                process.cpu_percent = 100.0 * static_cast<double>(ticks - runner.last_ticks) /
+                                      clock_ticks_ / seconds;
+            }
+        }
+        runner.last_ticks = ticks;
+        runner.last_sample = now;
+
+        n = readProc(runner.status_fd, buf_, sizeof(buf_));
+        std::string_view status(buf_, n);
+        process.rss_bytes = fieldValue(status, "VmRSS") * 1024;
+        process.gpus = runner.gpus;
+
+        // Sockets the affinity mask reaches (taskset, numactl, cpuset cgroups)
+        size_t cpus = status.find("\nCpus_allowed_list:");
+        if (cpus != std::string_view::npos && !cpu_node_.empty()) {
+            std::string_view list = status.substr(cpus + 19);
+            list = list.substr(0, list.find('\n'));
+            size_t first = list.find_first_not_of(" \t");
+            list = first == std::string_view::npos ? std::string_view() : list.substr(first);
+            forEachCpu(list, [&](unsigned cpu) {
+                if (cpu < cpu_node_.size()) {
+                    process.cpu_nodes |= 1ULL << cpu_node_[cpu];
+                }
+            });
+        }
+
+        info.runners.push_back(process);
+        i++;
+    }
+#else
+    (void)info;
+#endif
+}
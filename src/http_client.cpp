@@ -0,0 +1,269 @@
+#include "../include/http_client.h"
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <winhttp.h>
+#pragma comment(lib, "winhttp.lib")
+#else
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <netdb.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+// Request timeout for connect, send and receive (5 seconds)
+static const int kTimeoutMs = 5000;
+
+void parseBaseUrl(const std::string& base_url, std::string& host, int& port) {
+    host = "localhost";
+    port = 11434;
+
+    // Simple URL parsing for http://host:port format
+    std::string url = base_url;
+    if (url.find("http://") == 0) {
+        url = url.substr(7);
+    } else if (url.find("https://") == 0) {
+        url = url.substr(8);
+    }
+
+    size_t colon_pos = url.find(':');
+    if (colon_pos != std::string::npos) {
+        host = url.substr(0, colon_pos);
+        std::string port_str = url.substr(colon_pos + 1);
+        // Remove trailing slash if present
+        size_t slash_pos = port_str.find('/');
+        if (slash_pos != std::string::npos) {
+            port_str = port_str.substr(0, slash_pos);
+        }
+        try {
+            port = std::stoi(port_str);
+        } catch (...) {
+            port = 11434;
+        }
+    } else {
+        size_t slash_pos = url.find('/');
+        if (slash_pos != std::string::npos) {
+            host = url.substr(0, slash_pos);
+        } else {
+            host = url;
+        }
+    }
+}
+
+#ifdef _WIN32
+
+std::string httpRequest(const std::string& base_url,
+                        const std::string& method,
+                        const std::string& endpoint,
+                        const std::string& body) {
+    std::string result;
+
+    std::string host;
+    int port;
+    parseBaseUrl(base_url, host, port);
+
+    // Convert to wide strings
+    std::wstring whost(host.begin(), host.end());
+    std::wstring wendpoint(endpoint.begin(), endpoint.end());
+    std::wstring wmethod(method.begin(), method.end());
+
+    // Initialize WinHTTP
+    HINTERNET hSession = WinHttpOpen(L"OllamaMonitor/1.0",
+                                      WINHTTP_ACCESS_TYPE_NO_PROXY,
+                                      WINHTTP_NO_PROXY_NAME,
+                                      WINHTTP_NO_PROXY_BYPASS, 0);
+    if (!hSession) {
+        return "";
+    }
+
+    WinHttpSetTimeouts(hSession, kTimeoutMs, kTimeoutMs, kTimeoutMs, kTimeoutMs);
+
+    // Connect to server
+    HINTERNET hConnect = WinHttpConnect(hSession, whost.c_str(),
+                                         static_cast<INTERNET_PORT>(port), 0);
+    if (!hConnect) {
+        WinHttpCloseHandle(hSession);
+        return "";
+    }
+
+    // Create request
+    HINTERNET hRequest = WinHttpOpenRequest(hConnect, wmethod.c_str(), wendpoint.c_str(),
+                                            NULL, WINHTTP_NO_REFERER,
+                                            WINHTTP_DEFAULT_ACCEPT_TYPES, 0);
+    if (!hRequest) {
+        WinHttpCloseHandle(hConnect);
+        WinHttpCloseHandle(hSession);
+        return "";
+    }
+
+    // Send request
+    BOOL bResults;
+    if (body.empty()) {
+        bResults = WinHttpSendRequest(hRequest,
+                                      WINHTTP_NO_ADDITIONAL_HEADERS, 0,
+                                      WINHTTP_NO_REQUEST_DATA, 0,
+                                      0, 0);
+    } else {
+        bResults = WinHttpSendRequest(hRequest,
+                                      L"Content-Type: application/json\r\n", (DWORD)-1L,
+                                      (LPVOID)body.data(), static_cast<DWORD>(body.size()),
+                                      static_cast<DWORD>(body.size()), 0);
+    }
+
+    if (bResults) {
+        bResults = WinHttpReceiveResponse(hRequest, NULL);
+    }
+
+    // Read response
+    if (bResults) {
+        DWORD dwSize = 0;
+        DWORD dwDownloaded = 0;
+
+        do {
+            dwSize = 0;
+            if (!WinHttpQueryDataAvailable(hRequest, &dwSize)) {
+                break;
+            }
+
+            if (dwSize == 0) {
+                break;
+            }
+
+            char* pszOutBuffer = new char[dwSize + 1];
+            if (!pszOutBuffer) {
+                break;
+            }
+
+            ZeroMemory(pszOutBuffer, dwSize + 1);
+
+            if (WinHttpReadData(hRequest, (LPVOID)pszOutBuffer, dwSize, &dwDownloaded)) {
+                result.append(pszOutBuffer, dwDownloaded);
+            }
+
+            delete[] pszOutBuffer;
+        } while (dwSize > 0);
+    }
+
+    // Cleanup
+    WinHttpCloseHandle(hRequest);
+    WinHttpCloseHandle(hConnect);
+    WinHttpCloseHandle(hSession);
+
+    return result;
+}
+
+#else
+
+// Connect with a timeout; returns the socket or -1
+static int connectWithTimeout(const std::string& host, int port) {
+    struct addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo* addrs = nullptr;
+    std::string port_str = std::to_string(port);
+    if (getaddrinfo(host.c_str(), port_str.c_str(), &hints, &addrs) != 0) {
+        return -1;
+    }
+
+    int fd = -1;
+    for (struct addrinfo* ai = addrs; ai; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+
+        int rc = connect(fd, ai->ai_addr, ai->ai_addrlen);
+        if (rc != 0 && errno == EINPROGRESS) {
+            struct pollfd pfd = {fd, POLLOUT, 0};
+            int err = 0;
+            socklen_t len = sizeof(err);
+            if (poll(&pfd, 1, kTimeoutMs) == 1 &&
+                getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) == 0 && err == 0) {
+                rc = 0;
+            }
+        }
+        if (rc == 0) {
+            break;
+        }
+        close(fd);
+        fd = -1;
+    }
+
+    freeaddrinfo(addrs);
+    return fd;
+}
+
+std::string httpRequest(const std::string& base_url,
+                        const std::string& method,
+                        const std::string& endpoint,
+                        const std::string& body) {
+    std::string host;
+    int port;
+    parseBaseUrl(base_url, host, port);
+
+    int fd = connectWithTimeout(host, port);
+    if (fd < 0) {
+        return "";
+    }
+
+    // HTTP/1.0 keeps the response un-chunked and lets EOF mark the end
+    std::string request = method + " " + endpoint + " HTTP/1.0\r\n"
+                          "Host: " + host + ":" + std::to_string(port) + "\r\n"
+                          "User-Agent: OllamaMonitor/1.0\r\n";
+    if (!body.empty()) {
+        request += "Content-Type: application/json\r\n"
+                   "Content-Length: " + std::to_string(body.size()) + "\r\n";
+    }
+    request += "\r\n";
+    request += body;
+
+    size_t sent = 0;
+    while (sent < request.size()) {
+        ssize_t n = send(fd, request.data() + sent, request.size() - sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            sent += static_cast<size_t>(n);
+            continue;
+        }
+        struct pollfd pfd = {fd, POLLOUT, 0};
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) && poll(&pfd, 1, kTimeoutMs) == 1) {
+            continue;
+        }
+        close(fd);
+        return "";
+    }
+
+    // Read until the server closes the connection
+    std::string response;
+    char buf[16384];
+    for (;;) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n > 0) {
+            response.append(buf, static_cast<size_t>(n));
+            continue;
+        }
+        if (n == 0) {
+            break;
+        }
+        struct pollfd pfd = {fd, POLLIN, 0};
+        if ((errno == EAGAIN || errno == EWOULDBLOCK) && poll(&pfd, 1, kTimeoutMs) == 1) {
+            continue;
+        }
+        response.clear();
+        break;
+    }
+    close(fd);
+
+    size_t header_end = response.find("\r\n\r\n");
+    if (header_end == std::string::npos) {
+        return "";
+    }
+    return response.substr(header_end + 4);
+}
+
+#endif
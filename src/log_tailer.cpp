@@ -0,0 +1,448 @@
+#include "../include/log_tailer.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Size of the reusable read buffer
+static const size_t kReadBufferSize = 64 * 1024;
+// Longer lines are dropped rather than buffered without bound
+static const size_t kMaxLineLength = 16 * 1024;
+// Distinct endpoints tracked before the rest are lumped into "other"
+static const size_t kMaxEndpoints = 32;
+
+static std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+        s.remove_prefix(1);
+    }
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r')) {
+        s.remove_suffix(1);
+    }
+    return s;
+}
+
+static bool startsWith(std::string_view s, std::string_view prefix) {
+    return s.size() >= prefix.size() && s.compare(0, prefix.size(), prefix) == 0;
+}
+
+// Go time.Duration.String() as printed by gin ("1m2.5s", "12.3ms", "850µs", "0s");
+// returns milliseconds, or -1 if the text is not a duration
+static double parseGoDuration(std::string_view s) {
+    if (s.empty()) {
+        return -1.0;
+    }
+    double total_ms = 0.0;
+    const char* p = s.data();
+    const char* end = s.data() + s.size();
+
+    while (p < end) {
+        double value = 0.0;
+        auto result = std::from_chars(p, end, value);
+        if (result.ec != std::errc() || result.ptr == p) {
+            return -1.0;
+        }
+        p = result.ptr;
+        std::string_view unit(p, static_cast<size_t>(end - p));
+
+        double scale;
+        size_t unit_len;
+        if (startsWith(unit, "ns")) {
+            scale = 1e-6; unit_len = 2;
+        } else if (startsWith(unit, "us")) {
+            scale = 1e-3; unit_len = 2;
+        } else if (startsWith(unit, "\xc2\xb5s") || startsWith(unit, "\xce\xbcs")) {
+            scale = 1e-3; unit_len = 3;  // micro sign / Greek mu
+        } else if (startsWith(unit, "ms")) {
+            scale = 1.0; unit_len = 2;
+        } else if (startsWith(unit, "s")) {
+            scale = 1e3; unit_len = 1;
+        } else if (startsWith(unit, "m")) {
+            scale = 60e3; unit_len = 1;
+        } else if (startsWith(unit, "h")) {
+            scale = 3600e3; unit_len = 1;
+        } else {
+            return -1.0;
+        }
+        total_ms += value * scale;
+        p += unit_len;
+    }
+    return total_ms;
+}
+
+// Nearest-rank percentile of the first n values (reorders them)
+static double percentile(std::vector<float>& values, size_t n, double p) {
+    if (n == 0) {
+        return 0.0;
+    }
+    size_t rank = static_cast<size_t>(std::ceil(p * static_cast<double>(n)));
+    size_t index = rank > 0 ? rank - 1 : 0;
+    std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(index),
+                     values.begin() + static_cast<std::ptrdiff_t>(n));
+    return values[index];
+}
+
+LogTailer::LogTailer(const std::string& path) : path_(path) {
+    size_t slash = path_.find_last_of('/');
+    if (slash == std::string::npos) {
+        dir_.assign(1, '.');  // Not = ".": GCC 12 -O2 reports a bogus -Wrestrict
+        file_name_ = path_;
+    } else {
+        dir_ = slash == 0 ? "/" : path_.substr(0, slash);
+        file_name_ = path_.substr(slash + 1);
+    }
+    read_buf_.resize(kReadBufferSize);
+    partial_.reserve(1024);
+    scratch_.reserve(kWindow);
+}
+
+LogTailer::~LogTailer() {
+#ifdef __linux__
+    if (file_fd_ >= 0) {
+        close(file_fd_);
+    }
+    if (inotify_fd_ >= 0) {
+        close(inotify_fd_);
+    }
+#endif
+}
+
+#ifdef __linux__
+
+bool LogTailer::openFile(bool seek_to_end) {
+    file_fd_ = open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file_fd_ < 0) {
+        return false;
+    }
+
+    offset_ = 0;
+    if (seek_to_end) {
+        struct stat st;
+        if (fstat(file_fd_, &st) == 0) {
+            offset_ = st.st_size;
+        }
+    }
+    partial_.clear();
+
+    // The directory watch catches rotation; this one catches appends
+    file_wd_ = inotify_add_watch(inotify_fd_, path_.c_str(),
+                                 IN_MODIFY | IN_MOVE_SELF | IN_DELETE_SELF);
+    return true;
+}
+
+bool LogTailer::start(EventLoop& loop) {
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd_ < 0) {
+        return false;
+    }
+
+    // A new file appearing under our name is a rotation (or the first start)
+    dir_wd_ = inotify_add_watch(inotify_fd_, dir_.c_str(), IN_CREATE | IN_MOVED_TO);
+    if (dir_wd_ < 0) {
+        return false;
+    }
+
+    // Only new traffic matters; history would skew the rates
+    openFile(true);
+
+    return loop.watchFd(inotify_fd_, true, false, [this](bool, bool) { onInotify(); });
+}
+
+void LogTailer::onInotify() {
+    alignas(struct inotify_event) char events[4096];
+    bool modified = false;
+    bool reopen = false;
+
+    ssize_t n;
+    while ((n = read(inotify_fd_, events, sizeof(events))) > 0) {
+        for (char* p = events; p < events + n;) {
+            auto* event = reinterpret_cast<struct inotify_event*>(p);
+            if (event->wd == file_wd_) {
+                if (event->mask & IN_MODIFY) {
+                    modified = true;
+                }
+                if (event->mask & IN_IGNORED) {
+                    file_wd_ = -1;
+                }
+            } else if (event->wd == dir_wd_ && event->len > 0 && file_name_ == event->name) {
+                reopen = true;
+            }
+            p += sizeof(struct inotify_event) + event->len;
+        }
+    }
+
+    // Finish the old file before switching, so no lines are lost at rotation
+    if (modified || reopen) {
+        readAppended();
+    }
+    if (reopen) {
+        if (file_fd_ >= 0) {
+            close(file_fd_);
+            file_fd_ = -1;
+        }
+        if (file_wd_ >= 0) {
+            inotify_rm_watch(inotify_fd_, file_wd_);
+            file_wd_ = -1;
+        }
+        if (openFile(false)) {
+            readAppended();
+        }
+    }
+}
+
+void LogTailer::readAppended() {
+    if (file_fd_ < 0) {
+        return;
+    }
+
+    // copytruncate-style rotation: the file shrank under us
+    struct stat st;
+    if (fstat(file_fd_, &st) == 0 && st.st_size < offset_) {
+        offset_ = 0;
+        partial_.clear();
+    }
+
+    ssize_t n;
+    while ((n = pread(file_fd_, read_buf_.data(), read_buf_.size(), offset_)) > 0) {
+        offset_ += n;
+        std::string_view chunk(read_buf_.data(), static_cast<size_t>(n));
+
+        size_t newline;
+        while ((newline = chunk.find('\n')) != std::string_view::npos) {
+            std::string_view line = chunk.substr(0, newline);
+            if (!partial_.empty()) {
+                if (partial_.size() + line.size() <= kMaxLineLength) {
+                    partial_.append(line.data(), line.size());
+                    processLine(partial_);
+                }
+                partial_.clear();
+            } else {
+                processLine(line);
+            }
+            chunk.remove_prefix(newline + 1);
+        }
+
+        if (partial_.size() + chunk.size() <= kMaxLineLength) {
+            partial_.append(chunk.data(), chunk.size());
+        } else {
+            partial_.clear();
+        }
+    }
+}
+
+#else
+
+bool LogTailer::start(EventLoop& loop) {
+    (void)loop;
+    return false;
+}
+
+#endif // __linux__
+
+void LogTailer::processLine(std::string_view line) {
+    // journald export and `journalctl` output prefix the message; searching
+    // for the markers skips "MESSAGE=" or "<date> <host> ollama[pid]: " alike
+    size_t gin = line.find("[GIN]");
+    if (gin == std::string_view::npos) {
+        if (processTimings(line)) {
+            return;
+        }
+        // "llm_load_tensors: offloaded 29/33 layers to GPU"
+        size_t off = line.find("offloaded ");
+        if (off == std::string_view::npos) {
+            return;
+        }
+        const char* p = line.data() + off + 10;
+        const char* end = line.data() + line.size();
+        int offloaded = 0;
+        int total = 0;
+        auto first = std::from_chars(p, end, offloaded);
+        if (first.ec != std::errc() || first.ptr >= end || *first.ptr != '/') {
+            return;
+        }
+        auto second = std::from_chars(first.ptr + 1, end, total);
+        if (second.ec != std::errc() || !startsWith(std::string_view(second.ptr, end - second.ptr), " layers to GPU")) {
+            return;
+        }
+        has_offload_ = true;
+        offloaded_layers_ = offloaded;
+        total_layers_ = total;
+        return;
+    }
+
+    // [GIN] 2024/05/01 - 12:34:56 | 200 |  1.234567s |  127.0.0.1 | POST     "/api/generate"
+    std::string_view fields[5];
+    size_t count = 0;
+    std::string_view rest = line.substr(gin + 5);
+    while (count < 5) {
+        size_t bar = rest.find('|');
+        if (bar == std::string_view::npos) {
+            fields[count++] = rest;
+            break;
+        }
+        fields[count++] = rest.substr(0, bar);
+        rest.remove_prefix(bar + 1);
+    }
+    if (count < 5) {
+        return;
+    }
+
+    std::string_view status_text = trim(fields[1]);
+    int status = 0;
+    auto status_result = std::from_chars(status_text.data(), status_text.data() + status_text.size(), status);
+    if (status_result.ec != std::errc()) {
+        return;
+    }
+
+    double latency_ms = parseGoDuration(trim(fields[2]));
+    if (latency_ms < 0) {
+        return;
+    }
+
+    std::string_view request = trim(fields[4]);
+    size_t space = request.find(' ');
+    size_t open_quote = request.find('"');
+    if (space == std::string_view::npos || open_quote == std::string_view::npos) {
+        return;
+    }
+    size_t close_quote = request.find('"', open_quote + 1);
+    if (close_quote == std::string_view::npos) {
+        return;
+    }
+    std::string_view method = request.substr(0, space);
+    std::string_view path = request.substr(open_quote + 1, close_quote - open_quote - 1);
+    size_t query = path.find('?');
+    if (query != std::string_view::npos) {
+        path = path.substr(0, query);
+    }
+
+    recordRequest(status, latency_ms, method, path);
+}
+
+// "llama_print_timings:        eval time =  1234.56 ms /   99 runs   (...)" or
+// "print_timings: eval time = 1234.56 ms / 99 tokens (...)"; prompt eval is
+// not generation and is skipped
+bool LogTailer::processTimings(std::string_view line) {
+    size_t eval = line.find("eval time");
+    if (eval == std::string_view::npos) {
+        return false;
+    }
+    if (eval >= 7 && line.substr(eval - 7, 7) == "prompt ") {
+        return true;
+    }
+    size_t slash = line.find('/', eval);
+    if (slash == std::string_view::npos) {
+        return true;
+    }
+    std::string_view rest = trim(line.substr(slash + 1));
+    uint64_t tokens = 0;
+    auto result = std::from_chars(rest.data(), rest.data() + rest.size(), tokens);
+    if (result.ec != std::errc()) {
+        return true;
+    }
+    std::string_view unit = trim(std::string_view(result.ptr, static_cast<size_t>(rest.data() + rest.size() - result.ptr)));
+    if (startsWith(unit, "runs") || startsWith(unit, "tokens")) {
+        has_tokens_ = true;
+        generated_tokens_ += tokens;
+    }
+    return true;
+}
+
+void LogTailer::recordRequest(int status, double latency_ms, std::string_view method, std::string_view path) {
+    // Compare piecewise so the hot path does not build a string
+    Endpoint* endpoint = nullptr;
+    for (auto& candidate : endpoints_) {
+        std::string_view name = candidate.name;
+        if (name.size() == method.size() + 1 + path.size() && startsWith(name, method) &&
+            name[method.size()] == ' ' && name.substr(method.size() + 1) == path) {
+            endpoint = &candidate;
+            break;
+        }
+    }
+    if (!endpoint) {
+        std::string name;
+        if (endpoints_.size() < kMaxEndpoints) {
+            name.reserve(method.size() + 1 + path.size());
+            name.append(method).append(1, ' ').append(path);
+        } else {
+            name = "other";
+        }
+        for (auto& candidate : endpoints_) {
+            if (candidate.name == name) {
+                endpoint = &candidate;
+            }
+        }
+        if (!endpoint) {
+            endpoints_.emplace_back();
+            endpoint = &endpoints_.back();
+            endpoint->name = std::move(name);
+        }
+    }
+
+    endpoint->latencies_ms[endpoint->next] = static_cast<float>(latency_ms);
+    endpoint->arrivals[endpoint->next] = std::chrono::steady_clock::now();
+    endpoint->next = (endpoint->next + 1) % kWindow;
+    if (endpoint->filled < kWindow) {
+        endpoint->filled++;
+    }
+    endpoint->total++;
+    if (status >= 500) {
+        endpoint->errors++;
+    }
+}
+
+LogStats LogTailer::getStats() const {
+    LogStats stats;
+    stats.active = inotify_fd_ >= 0;
+    stats.path = path_;
+    stats.has_offload = has_offload_;
+    stats.offloaded_layers = offloaded_layers_;
+    stats.total_layers = total_layers_;
+    stats.has_tokens = has_tokens_;
+    stats.generated_tokens = generated_tokens_;
+
+    auto now = std::chrono::steady_clock::now();
+    auto minute_ago = now - std::chrono::seconds(60);
+
+    for (const auto& endpoint : endpoints_) {
+        EndpointStats es;
+        es.endpoint = endpoint.name;
+        es.total = endpoint.total;
+        es.errors = endpoint.errors;
+
+        // Arrival times are when we read the line, which is close enough
+        // for a rate and avoids trusting the log's wall-clock timestamps
+        size_t recent = 0;
+        auto oldest = now;
+        for (size_t i = 0; i < endpoint.filled; i++) {
+            if (endpoint.arrivals[i] >= minute_ago) {
+                recent++;
+                oldest = std::min(oldest, endpoint.arrivals[i]);
+            }
+        }
+        if (recent == kWindow && now > oldest) {
+            // Window overflowed within the minute: extrapolate from its span
+            double span = std::chrono::duration<double>(now - oldest).count();
+            es.requests_per_min = static_cast<double>(kWindow) / span * 60.0;
+        } else {
+            es.requests_per_min = static_cast<double>(recent);
+        }
+
+        scratch_.assign(endpoint.latencies_ms.begin(),
+                        endpoint.latencies_ms.begin() + static_cast<std::ptrdiff_t>(endpoint.filled));
+        es.p50_ms = percentile(scratch_, endpoint.filled, 0.50);
+        es.p95_ms = percentile(scratch_, endpoint.filled, 0.95);
+        es.p99_ms = percentile(scratch_, endpoint.filled, 0.99);
+
+        stats.endpoints.push_back(std::move(es));
+    }
+
+    std::sort(stats.endpoints.begin(), stats.endpoints.end(),
+              [](const EndpointStats& a, const EndpointStats& b) { return a.total > b.total; });
+    return stats;
+}
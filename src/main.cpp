@@ -1,20 +1,32 @@
 #include <iostream>
-#include <thread>
+#include <functional>
 #include <chrono>
 #include <csignal>
-#include <atomic>
 
 #include "../include/ollama_client.h"
 #include "../include/gpu_monitor.h"
+#include "../include/host_monitor.h"
 #include "../include/console_ui.h"
-
-// Global flag for graceful shutdown
-std::atomic<bool> g_running(true);
-
-void signalHandler(int signum) {
-    (void)signum;
-    g_running = false;
-}
+#include "../include/event_loop.h"
+#include "../include/shm_publisher.h"
+#include "../include/model_metadata_cache.h"
+#include "../include/platform.h"
+#include "../include/log_tailer.h"
+#include "../include/model_store.h"
+#include "../include/catalog_watcher.h"
+#include "../include/fetch_worker.h"
+#include "../include/state_cache.h"
+#include "../include/profiler.h"
+#include "../include/energy_meter.h"
+#include "../include/fleet_agent.h"
+#include "../include/fleet_aggregator.h"
+#include "../include/alert_engine.h"
+#include "../include/sse_server.h"
+#include "../include/residency_index.h"
+#include "../include/placement.h"
+#include "../include/model_keeper.h"
+#include "../include/metrics_scraper.h"
+#include "../include/soak.h"
 
 void printUsage(const char* program_name) {
     std::cout << "Ollama Monitor - A top-like monitor for Ollama\n\n";
@@ -26,6 +38,28 @@ void printUsage(const char* program_name) {
     std::cout << "  -1, --once           Run once and exit (for testing)\n";
     std::cout << "  -n, --count <num>    Run N times then exit\n";
     std::cout << "  --no-clear           Don't clear screen (for piped output)\n";
+    std::cout << "  --sysfs-root <dir>   Read AMD/Intel GPU metrics from <dir>/sys (default: /)\n";
+    std::cout << "  --shm                Publish snapshots to shared memory (/ollama-monitor)\n";
+    std::cout << "  --shm-name <name>    Shared-memory segment name (implies --shm)\n";
+    std::cout << "  --models-dir <dir>   Ollama model store (default: $OLLAMA_MODELS or ~/.ollama/models)\n";
+    std::cout << "  --log <path>         Tail the Ollama server log for request latency (Linux)\n";
+    std::cout << "  --plan <models>      Show where the models would load now, then exit\n";
+    std::cout << "  --scrape <url>       Show a co-located engine's Prometheus metrics (repeatable)\n";
+    std::cout << "  --keep <file>        Keep the models listed in <file> resident (keep-alive, preload)\n";
+    std::cout << "  --alerts <file>      Evaluate alert rules from <file> and run their hooks\n";
+    std::cout << "  --sse <port>         Stream JSON snapshots and deltas to dashboards (Linux)\n";
+    std::cout << "  --sse-interval <ms>  GPU update period for --sse streams (default: 250)\n";
+    std::cout << "  --sse-max-clients <n>\n";
+    std::cout << "                       Concurrent --sse subscribers (default: 512)\n";
+    std::cout << "  --residency-socket <path>\n";
+    std::cout << "                       Answer which hosts hold a model on a Unix socket (Linux)\n";
+    std::cout << "  --agent <host:port>  Run headless and push snapshots to an aggregator (Linux)\n";
+    std::cout << "  --aggregator <port>  Accept agents on <port> and show the fleet view (Linux)\n";
+    std::cout << "  --soak <hours>       Poll a scripted server for <hours> of simulated time and\n";
+    std::cout << "                       fail if memory or CPU per refresh keeps growing (Linux)\n";
+    std::cout << "  --soak-limits <spec> Allowed growth, e.g. rss=16,allocs=25,cpu=100 (MB, %, %)\n";
+    std::cout << "  --profile            Show per-stage frame timings; write a JSON report on exit\n";
+    std::cout << "  --profile-out <file> Report path (default: ollama-monitor-profile.json)\n";
 }
 
 int main(int argc, char* argv[]) {
@@ -34,6 +68,24 @@ int main(int argc, char* argv[]) {
     std::string ollama_url = "http://localhost:11434";
     int run_count = 0;  // 0 = infinite
     bool no_clear = false;
+    std::string sysfs_root = "/";
+    std::string shm_name;  // empty = don't publish
+    std::string log_path;  // empty = don't tail
+    std::string models_dir = ollamaModelsDirectory();
+    bool profile = false;
+    std::string profile_out = "ollama-monitor-profile.json";
+    std::string agent_address;  // empty = not an agent
+    int aggregator_port = 0;    // 0 = not an aggregator
+    std::string alerts_path;    // empty = no alert rules
+    int sse_port = 0;           // 0 = no event stream
+    std::string residency_socket;  // empty = no routing queries
+    int sse_interval_ms = 250;
+    int sse_max_clients = 512;
+    std::string plan_models;    // empty = normal monitor
+    std::string keep_path;      // empty = don't manage residency
+    std::vector<std::string> scrape_urls;
+    double soak_hours = 0;      // 0 = real server, real time
+    SoakLimits soak_limits;
     
     // Parse command line arguments
     for (int i = 1; i < argc; i++) {
@@ -54,60 +106,586 @@ int main(int argc, char* argv[]) {
             if (run_count < 1) run_count = 1;
         } else if (arg == "--no-clear") {
             no_clear = true;
+        } else if (arg == "--sysfs-root" && i + 1 < argc) {
+            sysfs_root = argv[++i];
+        } else if (arg == "--shm") {
+            if (shm_name.empty()) shm_name = ollama_monitor_shm::kDefaultName;
+        } else if (arg == "--shm-name" && i + 1 < argc) {
+            shm_name = argv[++i];
+        } else if (arg == "--models-dir" && i + 1 < argc) {
+            models_dir = argv[++i];
+        } else if (arg == "--profile") {
+            profile = true;
+        } else if (arg == "--profile-out" && i + 1 < argc) {
+            profile = true;
+            profile_out = argv[++i];
+        } else if (arg == "--log" && i + 1 < argc) {
+            log_path = argv[++i];
+        } else if (arg == "--plan" && i + 1 < argc) {
+            plan_models = argv[++i];
+        } else if (arg == "--scrape" && i + 1 < argc) {
+            scrape_urls.push_back(argv[++i]);
+        } else if (arg == "--keep" && i + 1 < argc) {
+            keep_path = argv[++i];
+        } else if (arg == "--alerts" && i + 1 < argc) {
+            alerts_path = argv[++i];
+        } else if (arg == "--residency-socket" && i + 1 < argc) {
+            residency_socket = argv[++i];
+        } else if (arg == "--sse" && i + 1 < argc) {
+            sse_port = std::stoi(argv[++i]);
+        } else if (arg == "--sse-interval" && i + 1 < argc) {
+            sse_interval_ms = std::stoi(argv[++i]);
+            if (sse_interval_ms < 50) sse_interval_ms = 50;
+        } else if (arg == "--sse-max-clients" && i + 1 < argc) {
+            sse_max_clients = std::stoi(argv[++i]);
+            if (sse_max_clients < 1) sse_max_clients = 1;
+        } else if (arg == "--soak" && i + 1 < argc) {
+            soak_hours = std::stod(argv[++i]);
+        } else if (arg == "--soak-limits" && i + 1 < argc) {
+            std::string error;
+            if (!parseSoakLimits(argv[++i], soak_limits, error)) {
+                std::cerr << "\033[31mError: " << error << "\033[0m\n";
+                return 1;
+            }
+        } else if (arg == "--agent" && i + 1 < argc) {
+            agent_address = argv[++i];
+        } else if (arg == "--aggregator" && i + 1 < argc) {
+            aggregator_port = std::stoi(argv[++i]);
+        }
+    }
+    
+    // Measure only this thread: background fetches aren't frame time
+    if (profile) {
+        profiler::enable();
+    }
+    
+    // Signals go through the event loop; register before any thread starts
+    EventLoop loop;
+    loop.onSignal(SIGINT, [&loop] { loop.stop(); });
+#ifdef SIGTERM
+    loop.onSignal(SIGTERM, [&loop] { loop.stop(); });
+#endif
+    // A resize redraws at once (and may switch layouts); set once the UI exists
+    std::function<void()> on_resize;
+#ifdef SIGWINCH
+    loop.onSignal(SIGWINCH, [&on_resize] {
+        if (on_resize) {
+            on_resize();
+        }
+    });
+#endif
+    
+    // The aggregator only merges what agents send; no local collection
+    if (aggregator_port != 0) {
+        FleetAggregator aggregator(aggregator_port);
+        if (!aggregator.start(loop)) {
+            std::cerr << "\033[31mError: Cannot listen on port " << aggregator_port << "\033[0m\n";
+            return 1;
+        }
+        // Routers ask which nodes hold a model; kept current from every frame
+        std::unique_ptr<ResidencyIndex> residency;
+        if (!residency_socket.empty()) {
+            residency = std::make_unique<ResidencyIndex>(residency_socket);
+            if (!residency->start(loop)) {
+                std::cerr << "\033[31mError: Cannot serve on " << residency_socket << "\033[0m\n";
+                return 1;
+            }
+            aggregator.setOnUpdate([&residency](const FleetNode& node) {
+                residency->update(node.snapshot, node.connected);
+            });
+        }
+        ConsoleUI ui;
+        ui.refreshRate(refresh_rate);
+        ui.setNoClear(no_clear);
+        FleetView view;
+        int frames = 0;
+        loop.addTimer(std::chrono::seconds(refresh_rate), [&] {
+            ui.displayFleet(aggregator.nodes(), aggregator.port(), view);
+            if (run_count > 0 && ++frames >= run_count) {
+                loop.stop();
+            }
+        }, true);
+        if (run_count == 0) {
+            on_resize = [&] {
+                ui.updateTerminalSize();
+                ui.displayFleet(aggregator.nodes(), aggregator.port(), view);
+            };
         }
+        
+        // Keys: q quits, v switches layout, m the heatmap metric, arrows move
+        // the cursor, Enter shows the node in detail and Esc goes back
+        if (run_count == 0 && !no_clear && ui.enableKeyboardInput()) {
+            loop.watchFd(ui.keyboardFd(), true, false, [&](bool, bool) {
+                auto nodes = aggregator.nodes();
+                int key;
+                while ((key = ui.readKey()) >= 0) {
+                    size_t gpus = view.node < nodes.size() ? nodes[view.node].snapshot.gpus.size() : 0;
+                    if (key == 'q' || key == 'Q') {
+                        loop.stop();
+                        return;
+                    } else if (key == 'v' || key == 'V') {
+                        view.layout = ui.fleetHeatmapShown() ? FleetLayout::Table : FleetLayout::Heatmap;
+                    } else if (key == 'm' || key == 'M') {
+                        ui.cycleHeatMetric();
+                    } else if (key == ConsoleUI::kKeyUp || key == 'k') {
+                        view.node -= view.node > 0 ? 1 : 0;
+                    } else if (key == ConsoleUI::kKeyDown || key == 'j') {
+                        view.node += view.node + 1 < nodes.size() ? 1 : 0;
+                    } else if (key == ConsoleUI::kKeyLeft || key == 'h') {
+                        view.gpu -= view.gpu > 0 ? 1 : 0;
+                    } else if (key == ConsoleUI::kKeyRight || key == 'l') {
+                        view.gpu += view.gpu + 1 < gpus ? 1 : 0;
+                    } else if (key == '\r' || key == '\n') {
+                        view.detail = true;
+                    } else if (key == 27 || key == 127 || key == 8) {
+                        view.detail = false;
+                    }
+                }
+                ui.displayFleet(nodes, aggregator.port(), view);
+            });
+        }
+        loop.run();
+        if (run_count == 0) {
+            std::cout << "\n\033[0mExiting...\n";
+        }
+        return 0;
     }
     
-    // Set up signal handler
-    signal(SIGINT, signalHandler);
-    signal(SIGTERM, signalHandler);
+    // Soak runs: scripted server, simulated clock, frames composed but discarded,
+    // nothing read from or written to the cache directory
+    bool soak = soak_hours > 0;
+    SoakServer soak_server;
+    std::unique_ptr<DiscardOutput> discard;
+    if (soak) {
+        if (!soak_server.start()) {
+            std::cerr << "\033[31mError: Cannot start the soak server\033[0m\n";
+            return 1;
+        }
+        ollama_url = soak_server.url();
+        run_count = 0;
+        loop.simulateTime();
+        discard = std::make_unique<DiscardOutput>(std::cout);
+    }
     
     // Initialize components
     OllamaClient ollama_client(ollama_url);
-    GPUMonitor gpu_monitor;
+    GPUMonitor gpu_monitor(sysfs_root);
+    HostMonitor host_monitor;
+    ModelStore model_store(models_dir);
+    std::string cache_dir = soak ? "" : cacheDirectory();
+    ModelMetadataCache metadata_cache(ollama_client,
+                                      cache_dir.empty() ? "" : cache_dir + "/model_metadata.tsv");
     ConsoleUI ui;
     
+    // One-shot what-if: fetch current state and metadata directly, print, exit
+    if (!plan_models.empty()) {
+        if (!ollama_client.probe()) {
+            std::cerr << "\033[31mError: Cannot connect to Ollama server at " << ollama_url << "\033[0m\n";
+            return 1;
+        }
+        auto status = ollama_client.getStatus();
+        auto catalog = ollama_client.getModels();
+        std::unordered_map<std::string, std::unique_ptr<ModelMetadata>> fetched;
+        PlacementPlanner planner(gpu_monitor.getGPUInfo(), status.get());
+        ui.printPlan(planner.planQuery(plan_models, catalog, [&](const OllamaModel& model) {
+            auto [it, inserted] = fetched.try_emplace(model.digest);
+            if (inserted) {
+                it->second = ollama_client.showModel(model.name);
+            }
+            return it->second.get();
+        }));
+        return 0;
+    }
+    
+    // Local tools read the latest state from here instead of polling Ollama
+    std::unique_ptr<ShmPublisher> shm_publisher;
+    if (!shm_name.empty()) {
+        shm_publisher = std::make_unique<ShmPublisher>(shm_name);
+        if (!shm_publisher->isOpen()) {
+            std::cerr << "\033[33mWarning: Cannot create shared-memory segment " << shm_name << "\033[0m\n";
+            shm_publisher.reset();
+        }
+    }
+    
+    // Request latency from the server's own log, no extra requests
+    std::unique_ptr<LogTailer> log_tailer;
+    if (!log_path.empty()) {
+        log_tailer = std::make_unique<LogTailer>(log_path);
+        if (!log_tailer->start(loop)) {
+            std::cerr << "\033[33mWarning: Cannot watch log file " << log_path << "\033[0m\n";
+            log_tailer.reset();
+        }
+    }
+    
+    // The installed catalog changes only with its manifests, so /api/tags is
+    // fetched after manifest writes rather than every refresh (or polled
+    // slowly if the tree can't be watched, as for the soak script's catalog)
+    CatalogWatcher catalog_watcher(soak ? "" : models_dir);
+    catalog_watcher.start(loop);
+    std::vector<OllamaModel> catalog;
+    
+    // Alert rules are compiled once; hooks run on the engine's own thread
+    AlertEngine alert_engine;
+    if (!alerts_path.empty()) {
+        std::string error;
+        if (!alert_engine.load(alerts_path, error)) {
+            std::cerr << "\033[31mError: " << error << "\033[0m\n";
+            return 1;
+        }
+    }
+    
+    // vLLM, llama.cpp server and similar engines sharing the GPUs
+    std::vector<std::unique_ptr<MetricsScraper>> scrapers;
+    for (const auto& url : scrape_urls) {
+        scrapers.push_back(std::make_unique<MetricsScraper>(url));
+    }
+    
+    // Desired resident set; requests go out on the keeper's own thread
+    ModelKeeper keeper(ollama_client);
+    if (!keep_path.empty()) {
+        std::string error;
+        if (!keeper.load(keep_path, hostName(), error)) {
+            std::cerr << "\033[31mError: " << error << "\033[0m\n";
+            return 1;
+        }
+    }
+    
+    // Agents push to the aggregator instead of drawing
+    std::unique_ptr<FleetAgent> fleet_agent;
+    if (!agent_address.empty()) {
+        fleet_agent = std::make_unique<FleetAgent>(agent_address, hostName());
+        if (!fleet_agent->start(loop)) {
+            std::cerr << "\033[31mError: Invalid aggregator address " << agent_address << "\033[0m\n";
+            return 1;
+        }
+        std::cerr << "Agent " << hostName() << " reporting to " << agent_address << "\n";
+    }
+    
+    // Dashboards subscribe over HTTP instead of polling
+    std::unique_ptr<SseServer> sse_server;
+    if (sse_port != 0) {
+        sse_server = std::make_unique<SseServer>(sse_port, static_cast<size_t>(sse_max_clients));
+        if (!sse_server->start(loop)) {
+            std::cerr << "\033[31mError: Cannot listen on port " << sse_port << "\033[0m\n";
+            return 1;
+        }
+    }
+    
+    // Routers on this host ask whether a model is loaded here
+    std::unique_ptr<ResidencyIndex> residency;
+    std::string local_host = hostName();
+    if (!residency_socket.empty()) {
+        residency = std::make_unique<ResidencyIndex>(residency_socket);
+        if (!residency->start(loop)) {
+            std::cerr << "\033[31mError: Cannot serve on " << residency_socket << "\033[0m\n";
+            return 1;
+        }
+    }
+    
     ui.refreshRate(refresh_rate);
     ui.setNoClear(no_clear);
     
-    // Initial connection check
-    if (!ollama_client.isConnected()) {
+    // Last known Ollama state, shown (marked stale) until the server answers
+    StateCache state_cache(cache_dir.empty() ? "" : cache_dir + "/last_state.tsv");
+    
+    // Joules per GPU and per model; totals survive restarts
+    EnergyMeter energy_meter(cache_dir.empty() ? "" : cache_dir + "/energy.tsv", std::chrono::seconds(refresh_rate));
+    
+    // Scripted runs want live data in their few frames; one /api/version is cheap
+    if (run_count > 0 && !ollama_client.probe()) {
         std::cerr << "\033[33mWarning: Cannot connect to Ollama server at " 
                   << ollama_url << "\033[0m\n";
-        std::cerr << "Make sure Ollama is running. Will keep trying...\n";
-        std::this_thread::sleep_for(std::chrono::seconds(2));
     }
     
-    // Main loop
+    DisplayInfo info;
     int iterations = 0;
-    while (g_running) {
-        DisplayInfo info;
+    
+    // What-if load query typed after 'p'; replanned on every render
+    std::string plan_query;
+    std::string plan_input;
+    bool plan_editing = false;
+    
+    // Re-render the last collected state (metadata may have arrived since)
+    auto render = [&] {
+        // Cached /api/show metadata; misses are fetched in the background
+        if (info.ollama_status) {
+            for (const auto& model : info.ollama_status->models) {
+                if (auto metadata = metadata_cache.lookup(model.name, model.digest)) {
+                    info.model_metadata[model.digest] = metadata;
+                }
+            }
+        }
+        for (const auto& model : info.available_models) {
+            if (auto metadata = metadata_cache.lookup(model.name, model.digest)) {
+                info.model_metadata[model.digest] = metadata;
+            }
+        }
+        
+        // Catalog annotations and the what-if query against the current state
+        PlacementPlanner planner(info.gpu_infos, info.ollama_status.get());
+        auto metadata = [&info](const OllamaModel& model) -> const ModelMetadata* {
+            auto it = info.model_metadata.find(model.digest);
+            return it == info.model_metadata.end() ? nullptr : it->second.get();
+        };
+        info.placements = planner.planCatalog(info.available_models, metadata);
+        info.plan_input = plan_input;
+        info.plan_editing = plan_editing;
+        info.plan.clear();
+        if (!plan_query.empty()) {
+            info.plan = planner.planQuery(plan_query, info.available_models, metadata);
+        }
+        
+        ui.display(info);
+    };
+    
+    // Ollama and --scrape data from the last finished fetch; frames drawn
+    // while a fetch is still out reuse them
+    std::unique_ptr<OllamaStatus> last_status;
+    std::vector<EngineStats> engines;
+    FetchWorker fetcher(ollama_client, scrapers, soak || profile ? nullptr : &loop);
+    
+    auto collect = [&] {
+        info = DisplayInfo();
         
         // Gather GPU information
         info.gpu_infos = gpu_monitor.getGPUInfo();
+        info.host_info = host_monitor.getHostInfo();
+        info.gpu_topology = gpu_monitor.getTopology();
+        info.topology_warnings = checkPlacement(info.gpu_infos, info.gpu_topology.get(), info.host_info);
+        if (log_tailer) {
+            info.log_stats = log_tailer->getStats();
+        }
+        info.engines = engines;
         
-        // Gather Ollama information
-        info.ollama_status = ollama_client.getStatus();
-        info.available_models = ollama_client.getModels();
+        if (last_status) {
+            info.ollama_status = std::make_unique<OllamaStatus>(*last_status);
+            info.available_models = catalog;
+            state_cache.update(*info.ollama_status, info.available_models);
+        } else {
+            state_cache.restore(info);
+        }
+        info.model_store = model_store.analyze(info.available_models);
         
-        // Display
-        ui.display(info);
+        // Restored state may be out of date: don't charge it for this energy
+        energy_meter.addSamples(info.gpu_infos, info.stale ? nullptr : info.ollama_status.get());
+        if (info.log_stats.has_tokens) {
+            energy_meter.addTokens(info.log_stats.generated_tokens);
+        }
+        info.energy = energy_meter.getInfo();
         
-        iterations++;
+        if (keeper.targetCount() > 0) {
+            info.keeper = keeper.update(info);
+        }
+        
+        if (alert_engine.ruleCount() > 0) {
+            info.alerts = alert_engine.evaluate(info);
+        }
+    };
+    
+    // One frame from the latest data: collect local metrics, publish, draw
+    auto frame = [&] {
+        if (!fetcher.synchronous()) {
+            profiler::beginFrame();
+        }
+        collect();
+        if (shm_publisher) {
+            shm_publisher->publish(info);
+        }
+        if (sse_server) {
+            sse_server->publish(info);
+        }
+        if (residency) {
+            residency->update(fleet::fromDisplayInfo(info, local_host), true);
+        }
+        if (fleet_agent) {
+            fleet_agent->publish(info);
+        } else {
+            render();
+        }
+        profiler::endFrame();
         
         // Check if we've hit the run count limit
-        if (run_count > 0 && iterations >= run_count) {
-            break;
+        iterations++;
+        if (!soak && run_count > 0 && iterations >= run_count) {
+            loop.stop();
+        }
+    };
+    
+    // Fetch off the loop thread and draw when the data is in. If the last
+    // fetch is still out (a slow or unreachable host), draw now with what we
+    // have so GPU and host metrics keep moving.
+    auto refresh = [&] {
+        // Inline fetches (--profile, --soak) are part of the frame they feed
+        if (fetcher.synchronous()) {
+            profiler::beginFrame();
         }
         
-        // Wait for next refresh
-        for (int i = 0; i < refresh_rate * 10 && g_running; i++) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        // The catalog only after manifest changes (or a slow poll), not every
+        // tick; asked only when a fetch can start, as asking marks the request
+        bool catalog_due = !fetcher.busy() && catalog_watcher.refreshDue();
+        bool started = fetcher.request(catalog_due, [&](FetchResult& result) {
+            last_status = std::move(result.status);
+            if (result.catalog_requested) {
+                if (result.catalog_complete) {
+                    catalog = std::move(result.catalog);
+                    metadata_cache.setCatalog(catalog);
+                }
+                catalog_watcher.refreshed(result.catalog_complete);
+            }
+            engines = std::move(result.engines);
+            frame();
+        });
+        // The first fetch can take a timeout per unreachable target: show the
+        // restored state meanwhile (scripted runs wait for live data instead)
+        if (!started || (iterations == 0 && run_count == 0)) {
+            frame();
+        }
+    };
+    
+    // Soak runs sample each refresh and stop at the end or the first breach
+    auto soak_start = loop.now();
+    SoakMonitor soak_monitor(soak_limits, static_cast<int64_t>(soak_hours * 3600));
+    auto soak_seconds = [&] {
+        return std::chrono::duration_cast<std::chrono::seconds>(loop.now() - soak_start).count();
+    };
+    
+    // Refresh on a drift-free schedule, first frame immediately
+    loop.addTimer(std::chrono::seconds(refresh_rate), [&] {
+        if (soak) {
+            soak_server.setTime(soak_seconds());
+            soak_monitor.begin();
+            refresh();
+            if (!soak_monitor.end(soak_seconds(), soak_server)) {
+                loop.stop();
+            }
+            return;
         }
+        refresh();
+    }, true);
+    
+    // GPU counters move faster than the refresh; only sample them for subscribers
+    if (sse_server && sse_interval_ms < refresh_rate * 1000) {
+        loop.addTimer(std::chrono::milliseconds(sse_interval_ms), [&] {
+            if (sse_server->subscriberCount() > 0) {
+                sse_server->publishGpus(gpu_monitor.getGPUInfo());
+            }
+        });
     }
     
-    // Clean exit
+    // Keeper actions: logged when headless, shown at once otherwise. The
+    // panel is built in collect() and a preload shows in /api/ps, so this
+    // takes a refresh rather than a redraw.
+    if (fleet_agent) {
+        keeper.setOnAction([](const KeeperAction& action) {
+            std::cerr << "Keeper: " << action.model << ": " << action.text << "\n";
+        });
+    } else if (run_count == 0 && !soak) {
+        keeper.setOnAction([&loop, &refresh](const KeeperAction&) { loop.post(refresh); });
+    }
+    
+    // Fetched metadata shows up without waiting for the next refresh
+    if (run_count == 0 && !fleet_agent) {
+        metadata_cache.setOnUpdate([&loop, &render] { loop.post(render); });
+    }
+    
+    // Liveness from /api/version in the background; reconnects redraw at once.
+    // A probe thread would run on wall-clock time, so soak runs probe inline.
+    std::function<void(bool)> on_connection_change;
     if (run_count == 0) {
+        // A restarted server may have been pointed at another models directory
+        on_connection_change = [&loop, &refresh, &catalog_watcher](bool connected) {
+            loop.post([&refresh, &catalog_watcher, connected] {
+                if (connected) {
+                    catalog_watcher.invalidate();
+                }
+                refresh();
+            });
+        };
+    }
+    if (soak) {
+        loop.addTimer(std::chrono::seconds(2), [&] {
+            soak_server.setTime(soak_seconds());
+            ollama_client.probe();
+        }, true);
+    } else {
+        ollama_client.startProbing(std::chrono::seconds(2), on_connection_change);
+    }
+    
+    // Keys: q quits, p edits the load plan, m switches the heatmap metric,
+    // t shows the GPU topology, anything else redraws immediately
+    if (run_count == 0 && !no_clear && !fleet_agent && !soak && ui.enableKeyboardInput()) {
+        loop.watchFd(ui.keyboardFd(), true, false, [&](bool, bool) {
+            int key;
+            bool redraw = false;
+            while ((key = ui.readKey()) >= 0) {
+                redraw = true;
+                if (plan_editing) {
+                    if (key == '\r' || key == '\n') {
+                        plan_query = plan_input;  // Empty closes the panel
+                        plan_editing = false;
+                    } else if (key == 27) {
+                        plan_editing = false;
+                    } else if (key == 127 || key == 8) {
+                        if (!plan_input.empty()) {
+                            plan_input.pop_back();
+                        }
+                    } else if (key >= 32 && key < 127) {
+                        plan_input += static_cast<char>(key);
+                    }
+                    continue;
+                }
+                if (key == 'p' || key == 'P') {
+                    plan_input = plan_query;
+                    plan_editing = true;
+                } else if (key == 'm' || key == 'M') {
+                    ui.cycleHeatMetric();
+                } else if (key == 't' || key == 'T') {
+                    ui.toggleTopology();
+                } else if (key == 'q' || key == 'Q') {
+                    loop.stop();
+                    return;
+                }
+            }
+            if (redraw) {
+                render();
+            }
+        });
+    }
+    if (run_count == 0 && !fleet_agent) {
+        on_resize = [&ui, &render] {
+            ui.updateTerminalSize();
+            render();
+        };
+    }
+    
+    loop.run();
+    on_resize = nullptr;
+    ollama_client.stopProbing();
+    metadata_cache.setOnUpdate(nullptr);
+    keeper.setOnAction(nullptr);
+    
+    // Clean exit
+    if (soak) {
+        if (!soak_monitor.passed()) {
+            std::cerr << "\033[31mSoak failed: " << soak_monitor.failure() << "\033[0m\n";
+            return 1;
+        }
+        if (soak_seconds() < static_cast<int64_t>(soak_hours * 3600)) {
+            std::cerr << "\033[33mSoak interrupted after " << soak_seconds() / 3600 << "h\033[0m\n";
+            return 1;
+        }
+        std::cerr << "Soak passed: " << soak_hours << "h simulated\n";
+        return 0;
+    }
+    if (run_count == 0 && !fleet_agent) {
         std::cout << "\n\033[0mExiting...\n";
     }
+    if (profile) {
+        if (profiler::writeReport(profile_out)) {
+            std::cerr << "Profile written to " << profile_out << "\n";
+        } else {
+            std::cerr << "\033[33mWarning: Cannot write profile to " << profile_out << "\033[0m\n";
+        }
+    }
     return 0;
 }
@@ -0,0 +1,272 @@
+#include "../include/metrics_scraper.h"
+#include "../include/http_client.h"
+#include "../include/profiler.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+// Backoff after a failed scrape: doubles per consecutive failure up to kRetryMax
+static const std::chrono::seconds kRetry(5);
+static const std::chrono::seconds kRetryMax(60);
+
+struct KnownMetric {
+    std::string_view name;
+    EngineMetric metric;
+    bool counter;
+    double scale;               // Ratios to percent
+};
+
+// The whitelist; everything else in an exposition is skipped unparsed
+static const KnownMetric kKnown[] = {
+    {"vllm:num_requests_running", EngineMetric::Running, false, 1},
+    {"vllm:num_requests_waiting", EngineMetric::Waiting, false, 1},
+    {"vllm:gpu_cache_usage_perc", EngineMetric::KvCache, false, 100},
+    {"vllm:kv_cache_usage_perc", EngineMetric::KvCache, false, 100},
+    {"vllm:generation_tokens_total", EngineMetric::GenTokens, true, 1},
+    {"vllm:prompt_tokens_total", EngineMetric::PromptTokens, true, 1},
+    {"llamacpp:requests_processing", EngineMetric::Running, false, 1},
+    {"llamacpp:requests_deferred", EngineMetric::Waiting, false, 1},
+    {"llamacpp:kv_cache_usage_ratio", EngineMetric::KvCache, false, 100},
+    {"llamacpp:tokens_predicted_total", EngineMetric::GenTokens, true, 1},
+    {"llamacpp:prompt_tokens_total", EngineMetric::PromptTokens, true, 1},
+    {"sglang:num_running_reqs", EngineMetric::Running, false, 1},
+    {"sglang:num_queue_reqs", EngineMetric::Waiting, false, 1},
+    {"sglang:token_usage", EngineMetric::KvCache, false, 100},
+    {"sglang:generation_tokens_total", EngineMetric::GenTokens, true, 1},
+    {"sglang:prompt_tokens_total", EngineMetric::PromptTokens, true, 1},
+    {"tgi_batch_current_size", EngineMetric::Running, false, 1},
+    {"tgi_queue_size", EngineMetric::Waiting, false, 1},
+};
+
+static constexpr bool isNameChar(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == ':';
+}
+
+static const KnownMetric* lookup(std::string_view name) {
+    // Every whitelisted name starts with one of these; most lines stop here
+    switch (name.empty() ? '\0' : name[0]) {
+    case 'v': case 'l': case 's': case 't':
+        break;
+    default:
+        return nullptr;
+    }
+    for (const auto& known : kKnown) {
+        if (known.name.size() == name.size() && std::memcmp(known.name.data(), name.data(), name.size()) == 0) {
+            return &known;
+        }
+    }
+    return nullptr;
+}
+
+static const char* nextLine(const char* p, const char* end) {
+    const void* newline = std::memchr(p, '\n', static_cast<size_t>(end - p));
+    return newline ? static_cast<const char*>(newline) + 1 : end;
+}
+
+static uint64_t fnv1a(uint64_t hash, const char* p, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        hash ^= static_cast<unsigned char>(p[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+MetricsScraper::MetricsScraper(const std::string& url) : url_(url), backoff_(kRetry) {
+    size_t scheme = url.find("://");
+    size_t host = scheme == std::string::npos ? 0 : scheme + 3;
+    size_t slash = url.find('/', host);
+    base_ = url.substr(0, slash);
+    path_ = slash == std::string::npos ? "/metrics" : url.substr(slash);
+    name_ = url.substr(host, slash == std::string::npos ? std::string::npos : slash - host);
+}
+
+bool MetricsScraper::scrape() {
+    auto now = std::chrono::steady_clock::now();
+    if (now < retry_at_) {
+        return false;
+    }
+
+    std::string body;
+    {
+        PROFILE_SCOPE(HttpRequest);
+        body = httpRequest(base_, "GET", path_);
+    }
+    if (body.empty()) {
+        up_ = false;
+        // From when the request gave up, not when it started: a timeout would eat the delay
+        retry_at_ = std::chrono::steady_clock::now() + backoff_;
+        backoff_ = std::min(backoff_ * 2, std::chrono::steady_clock::duration(kRetryMax));
+        return false;
+    }
+
+    up_ = true;
+    backoff_ = kRetry;
+    bytes_ = body.size();
+    auto start = std::chrono::steady_clock::now();
+    {
+        PROFILE_SCOPE(ParseMetrics);
+        parse(body, now);
+    }
+    parse_ms_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+MetricsScraper::Slot* MetricsScraper::find(uint64_t hash) {
+    size_t index = static_cast<size_t>(hash) & (kSlots - 1);
+    for (size_t probe = 0; probe < kSlots; probe++) {
+        Slot& slot = slots_[(index + probe) & (kSlots - 1)];
+        if (slot.hash == hash || slot.hash == 0) {
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+void MetricsScraper::parse(std::string_view text, std::chrono::steady_clock::time_point now) {
+    generation_++;
+    const char* p = text.data();
+    const char* end = p + text.size();
+
+    while (p < end) {
+        // Comments (# HELP, # TYPE) and blank lines
+        if (*p == '#' || *p == '\n' || *p == '\r' || *p == ' ') {
+            p = nextLine(p, end);
+            continue;
+        }
+
+        const char* name_start = p;
+        while (p < end && isNameChar(static_cast<unsigned char>(*p))) {
+            p++;
+        }
+        const KnownMetric* known = lookup(std::string_view(name_start, static_cast<size_t>(p - name_start)));
+        if (!known) {
+            p = nextLine(p, end);
+            continue;
+        }
+
+        // Labels: {key="value",...}; values may hold escaped quotes
+        uint64_t hash = fnv1a(14695981039346656037ULL, name_start, static_cast<size_t>(p - name_start));
+        std::string_view model;
+        if (p < end && *p == '{') {
+            const char* labels_start = ++p;
+            while (p < end && *p != '}' && *p != '\n') {
+                const char* key_start = p;
+                while (p < end && *p != '=' && *p != '}' && *p != '\n') {
+                    p++;
+                }
+                std::string_view key(key_start, static_cast<size_t>(p - key_start));
+                if (p + 1 >= end || *p != '=' || p[1] != '"') {
+                    break;
+                }
+                p += 2;
+                const char* value_start = p;
+                while (p < end && *p != '"' && *p != '\n') {
+                    p += (*p == '\\' && p + 1 < end) ? 2 : 1;
+                }
+                if (key == "model_name" || key == "model") {
+                    model = std::string_view(value_start, static_cast<size_t>(p - value_start));
+                }
+                if (p < end && *p == '"') {
+                    p++;
+                }
+                if (p < end && *p == ',') {
+                    p++;
+                }
+            }
+            hash = fnv1a(hash, labels_start, static_cast<size_t>(p - labels_start));
+            if (p < end && *p == '}') {
+                p++;
+            }
+        }
+
+        while (p < end && (*p == ' ' || *p == '\t')) {
+            p++;
+        }
+        if (p < end && *p == '+') {
+            p++;  // "+Inf"
+        }
+        double value = 0.0;
+        auto result = std::from_chars(p, end, value);
+        p = nextLine(p, end);
+        if (result.ec != std::errc() || value != value) {
+            continue;
+        }
+
+        hash = hash ? hash : 1;
+        Slot* slot = find(hash);
+        if (!slot || (slot->hash == 0 && used_ >= kSlots * 3 / 4)) {
+            // Full of series that came and went: start over rather than grow
+            slots_.fill(Slot());
+            used_ = 0;
+            slot = find(hash);
+        }
+        if (slot->hash == 0) {
+            slot->hash = hash;
+            slot->metric = static_cast<uint8_t>(known->metric);
+            slot->counter = known->counter;
+            slot->model_len = static_cast<uint8_t>(model.size() < kModelChars ? model.size() : kModelChars - 1);
+            std::memcpy(slot->model, model.data(), slot->model_len);
+            used_++;
+        }
+
+        if (slot->counter) {
+            double seconds = std::chrono::duration<double>(now - slot->raw_at).count();
+            bool continuous = slot->raw_at != std::chrono::steady_clock::time_point{} &&
+                              slot->seen + 1 == generation_ && value >= slot->raw && seconds > 0;
+            slot->value = continuous ? (value - slot->raw) / seconds : 0.0;
+            slot->ready = continuous;
+            slot->raw = value;
+            slot->raw_at = now;
+        } else {
+            slot->value = value * known->scale;
+            slot->ready = true;
+        }
+        slot->seen = generation_;
+    }
+}
+
+EngineStats MetricsScraper::getStats() const {
+    EngineStats stats;
+    stats.name = name_;
+    stats.up = up_;
+    stats.bytes = bytes_;
+    stats.parse_ms = parse_ms_;
+    if (!up_) {
+        return stats;
+    }
+
+    for (const auto& slot : slots_) {
+        if (slot.hash == 0 || slot.seen != generation_) {
+            continue;
+        }
+        stats.series++;
+        if (!slot.ready) {
+            continue;
+        }
+        std::string_view name = slot.model_len ? std::string_view(slot.model, slot.model_len)
+                                               : std::string_view(name_);
+        EngineModel* model = nullptr;
+        for (auto& existing : stats.models) {
+            if (existing.name == name) {
+                model = &existing;
+            }
+        }
+        if (!model) {
+            stats.models.emplace_back();
+            model = &stats.models.back();
+            model->name = std::string(name);
+        }
+
+        // Several series per model (data-parallel ranks): queues and rates
+        // add up, cache usage is the fullest
+        size_t metric = slot.metric;
+        if (metric == static_cast<size_t>(EngineMetric::KvCache)) {
+            model->values[metric] = model->has[metric] && model->values[metric] > slot.value
+                ? model->values[metric] : slot.value;
+        } else {
+            model->values[metric] += slot.value;
+        }
+        model->has[metric] = true;
+    }
+    return stats;
+}
@@ -0,0 +1,386 @@
+#include "../include/model_keeper.h"
+#include "../include/console_ui.h"
+#include "../include/placement.h"
+#include "../include/platform.h"
+#include <algorithm>
+#include <charconv>
+#include <ctime>
+#include <fstream>
+
+// Keep-alive goes out this long before expiry (or a quarter of a short keep)
+static const int64_t kRefreshAhead = 60;
+// Keep-alives for one model are at least this far apart
+static const std::chrono::seconds kRefreshGap(30);
+// Minimum gap between preloads, so a node never loads models back to back
+static const std::chrono::seconds kPreloadSpacing(30);
+// A preload that hasn't shown up in /api/ps by then counts as failed
+static const std::chrono::minutes kConfirmTimeout(2);
+// Evicted this soon after our preload means something else needs the VRAM
+static const std::chrono::minutes kEvictionWindow(10);
+static const std::chrono::seconds kBackoffBase(60);
+static const std::chrono::seconds kBackoffMax(30 * 60);
+static const size_t kRecentActions = 8;
+// "Forever" expiries are centuries out; anything closer needs one refresh
+static const int64_t kForeverThreshold = 365LL * 24 * 3600;
+
+static std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+        s.remove_prefix(1);
+    }
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r')) {
+        s.remove_suffix(1);
+    }
+    return s;
+}
+
+static std::string_view nextToken(std::string_view& s) {
+    s = trim(s);
+    size_t end = s.find_first_of(" \t");
+    std::string_view token = s.substr(0, end);
+    s.remove_prefix(end == std::string_view::npos ? s.size() : end);
+    return token;
+}
+
+// "90s", "30m", "2h"; plain numbers are seconds
+static bool parseDuration(std::string_view text, int64_t& seconds) {
+    auto result = std::from_chars(text.data(), text.data() + text.size(), seconds);
+    if (result.ec != std::errc() || result.ptr == text.data() || seconds <= 0) {
+        return false;
+    }
+    std::string_view unit(result.ptr, static_cast<size_t>(text.data() + text.size() - result.ptr));
+    if (unit == "m") {
+        seconds *= 60;
+    } else if (unit == "h") {
+        seconds *= 3600;
+    } else if (!unit.empty() && unit != "s") {
+        return false;
+    }
+    return true;
+}
+
+// "HH:MM" as minutes after midnight
+static bool parseClock(std::string_view text, int& minutes) {
+    int hours = 0;
+    int mins = 0;
+    auto h = std::from_chars(text.data(), text.data() + text.size(), hours);
+    if (h.ec != std::errc() || h.ptr == text.data() || h.ptr == text.data() + text.size() || *h.ptr != ':') {
+        return false;
+    }
+    auto m = std::from_chars(h.ptr + 1, text.data() + text.size(), mins);
+    if (m.ec != std::errc() || m.ptr != text.data() + text.size() || hours > 23 || mins > 59 || hours < 0 || mins < 0) {
+        return false;
+    }
+    minutes = hours * 60 + mins;
+    return true;
+}
+
+static std::string formatSeconds(int64_t seconds) {
+    if (seconds >= 3600) {
+        return std::to_string(seconds / 3600) + "h" + std::to_string((seconds % 3600) / 60) + "m";
+    }
+    if (seconds >= 60) {
+        return std::to_string(seconds / 60) + "m";
+    }
+    return std::to_string(seconds) + "s";
+}
+
+const char* keepStateName(KeepState state) {
+    switch (state) {
+    case KeepState::Idle: return "off-hours";
+    case KeepState::Resident: return "resident";
+    case KeepState::Refreshing: return "keep-alive";
+    case KeepState::Loading: return "loading";
+    case KeepState::NoRoom: return "no room";
+    case KeepState::Backoff: return "waiting";
+    case KeepState::Missing: return "not installed";
+    }
+    return "?";
+}
+
+ModelKeeper::ModelKeeper(OllamaClient& client) : client_(client) {
+    worker_ = std::thread(&ModelKeeper::workerLoop, this);
+}
+
+ModelKeeper::~ModelKeeper() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    worker_.join();
+}
+
+void ModelKeeper::setOnAction(std::function<void(const KeeperAction&)> on_action) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    on_action_ = std::move(on_action);
+}
+
+bool ModelKeeper::load(const std::string& path, const std::string& hostname, std::string& error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot read " + path;
+        return false;
+    }
+    std::string line;
+    int number = 0;
+    bool this_host = true;
+    while (std::getline(in, line)) {
+        number++;
+        std::string_view text = trim(line);
+        if (text.empty() || text[0] == '#') {
+            continue;
+        }
+        if (text.front() == '[') {
+            if (text.back() != ']' || text.size() < 3) {
+                error = path + ":" + std::to_string(number) + ": expected [hostname]";
+                return false;
+            }
+            this_host = text.substr(1, text.size() - 2) == hostname;
+            continue;
+        }
+        Target target;
+        if (!parseTarget(text, target, error)) {
+            error = path + ":" + std::to_string(number) + ": " + error;
+            return false;
+        }
+        if (this_host) {
+            targets_.push_back(std::move(target));
+        }
+    }
+    return true;
+}
+
+bool ModelKeeper::parseTarget(std::string_view line, Target& target, std::string& error) {
+    target.model = std::string(nextToken(line));
+    // /api/ps reports full names
+    if (target.model.find(':') == std::string::npos) {
+        target.model += ":latest";
+    }
+    for (std::string_view word = nextToken(line); !word.empty(); word = nextToken(line)) {
+        if (word == "keep") {
+            std::string_view value = nextToken(line);
+            if (value == "forever") {
+                target.keep_seconds = -1;
+            } else if (!parseDuration(value, target.keep_seconds)) {
+                error = "bad keep duration '" + std::string(value) + "'";
+                return false;
+            }
+        } else if (word == "at") {
+            std::string_view value = nextToken(line);
+            size_t dash = value.find('-');
+            if (dash == std::string_view::npos ||
+                !parseClock(value.substr(0, dash), target.window_start) ||
+                !parseClock(value.substr(dash + 1), target.window_end)) {
+                error = "bad time window '" + std::string(value) + "', expected HH:MM-HH:MM";
+                return false;
+            }
+        } else {
+            error = "unexpected '" + std::string(word) + "'";
+            return false;
+        }
+    }
+    return true;
+}
+
+void ModelKeeper::backoff(Tracking& tracking, std::chrono::steady_clock::time_point now) {
+    tracking.failures++;
+    auto delay = kBackoffBase * (int64_t(1) << std::min(tracking.failures - 1, 10));
+    tracking.retry_at = now + std::min<std::chrono::seconds>(delay, kBackoffMax);
+}
+
+void ModelKeeper::record(const std::string& model, std::string text, bool ok) {
+    recent_.push_back({static_cast<int64_t>(time(nullptr)), model, std::move(text), ok});
+    if (recent_.size() > kRecentActions) {
+        recent_.pop_front();
+    }
+    unreported_.push_back(recent_.back());
+}
+
+KeeperInfo ModelKeeper::update(const DisplayInfo& info) {
+    KeeperInfo result;
+    result.active = true;
+
+    auto now = std::chrono::steady_clock::now();
+    time_t unix_now = time(nullptr);
+    std::tm* local = std::localtime(&unix_now);
+    int minute = local ? local->tm_hour * 60 + local->tm_min : 0;
+
+    // Restored state may be out of date: decide nothing until the server answers
+    const OllamaStatus* status = info.stale ? nullptr : info.ollama_status.get();
+    PlacementPlanner planner(info.gpu_infos, status);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    bool can_queue = status && !has_job_ && in_flight_.empty();
+
+    for (const auto& target : targets_) {
+        KeeperModel model;
+        model.name = target.model;
+        Tracking& tracking = tracking_[target.model];
+
+        const OllamaRunningModel* resident = nullptr;
+        if (status) {
+            for (const auto& running : status->models) {
+                if (running.name == target.model) {
+                    resident = &running;
+                }
+            }
+        }
+
+        if (status && in_flight_ != target.model) {
+            if (resident && tracking.awaiting) {
+                tracking.awaiting = false;
+            } else if (!resident && tracking.awaiting && now - tracking.preloaded_at > kConfirmTimeout) {
+                tracking.awaiting = false;
+                tracking.preloaded = false;
+                backoff(tracking, now);
+                record(target.model, "not loaded within 2m, retry in " +
+                       formatSeconds(std::chrono::duration_cast<std::chrono::seconds>(tracking.retry_at - now).count()),
+                       false);
+            } else if (!resident && tracking.preloaded && !tracking.awaiting) {
+                // Unloaded again soon after we loaded it: stop competing for the VRAM
+                tracking.preloaded = false;
+                if (now - tracking.preloaded_at < kEvictionWindow) {
+                    backoff(tracking, now);
+                    record(target.model, "evicted after preload, retry in " +
+                           formatSeconds(std::chrono::duration_cast<std::chrono::seconds>(tracking.retry_at - now).count()),
+                           false);
+                }
+            }
+        }
+
+        bool in_window = target.window_start < 0 ||
+            (target.window_start <= target.window_end
+                ? minute >= target.window_start && minute < target.window_end
+                : minute >= target.window_start || minute < target.window_end);  // Past midnight
+
+        if (!in_window) {
+            model.state = KeepState::Idle;
+        } else if (in_flight_ == target.model) {
+            model.state = resident ? KeepState::Refreshing : KeepState::Loading;
+        } else if (tracking.awaiting) {
+            model.state = KeepState::Loading;
+        } else if (now < tracking.retry_at) {
+            model.state = KeepState::Backoff;
+            model.retry_in = std::chrono::duration_cast<std::chrono::seconds>(tracking.retry_at - now).count();
+        } else if (resident) {
+            model.state = KeepState::Resident;
+            model.expires_in = parseTimestamp(resident->expires_at) - static_cast<int64_t>(unix_now);
+            bool due = target.keep_seconds < 0
+                ? model.expires_in < kForeverThreshold
+                : model.expires_in <= std::min(kRefreshAhead, target.keep_seconds / 4);
+            if (due && can_queue && now - tracking.refreshed_at >= kRefreshGap) {
+                tracking.refreshed_at = now;
+                job_ = {target.model, target.keep_seconds, resident->context_length, false};
+                has_job_ = true;
+                can_queue = false;
+                model.state = KeepState::Refreshing;
+            }
+        } else if (status) {
+            const OllamaModel* entry = nullptr;
+            for (const auto& available : info.available_models) {
+                if (available.name == target.model) {
+                    entry = &available;
+                }
+            }
+            if (!entry) {
+                model.state = KeepState::Missing;
+            } else {
+                auto meta = info.model_metadata.find(entry->digest);
+                int64_t bytes = PlacementPlanner::estimateBytes(
+                    entry->size, meta == info.model_metadata.end() ? nullptr : meta->second.get(),
+                    PlacementPlanner::defaultContext());
+                Placement placement = planner.plan(entry->name, bytes);
+                bool fits = (placement.kind == PlacementKind::Fits || placement.kind == PlacementKind::Split) &&
+                            placement.evicts.empty();
+                if (!fits) {
+                    model.state = KeepState::NoRoom;
+                } else if (can_queue && now - last_preload_ >= kPreloadSpacing) {
+                    job_ = {target.model, target.keep_seconds, 0, true};
+                    has_job_ = true;
+                    can_queue = false;
+                    last_preload_ = now;
+                    // Later targets in this pass see it loaded
+                    planner.place(entry->name, bytes);
+                    model.state = KeepState::Loading;
+                } else {
+                    model.state = KeepState::Backoff;
+                    auto wait = last_preload_ + kPreloadSpacing - now;
+                    model.retry_in = wait.count() > 0 ? std::chrono::duration_cast<std::chrono::seconds>(wait).count() : 0;
+                }
+            }
+        } else {
+            model.state = KeepState::Idle;
+        }
+        result.models.push_back(std::move(model));
+    }
+
+    result.recent.assign(recent_.begin(), recent_.end());
+    bool queued = has_job_;
+    lock.unlock();
+
+    if (queued) {
+        cv_.notify_all();
+    }
+    report();
+    return result;
+}
+
+void ModelKeeper::report() {
+    std::vector<KeeperAction> actions;
+    std::function<void(const KeeperAction&)> on_action;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        actions.swap(unreported_);
+        on_action = on_action_;
+    }
+    if (on_action) {
+        for (const auto& action : actions) {
+            on_action(action);
+        }
+    }
+}
+
+void ModelKeeper::workerLoop() {
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return stopping_ || has_job_; });
+            if (stopping_) {
+                return;
+            }
+            job = std::move(job_);
+            has_job_ = false;
+            in_flight_ = job.model;
+        }
+
+        std::string error;
+        bool ok = client_.keepAlive(job.model, job.keep_seconds, job.num_ctx, error);
+        std::string keep = job.keep_seconds < 0 ? "forever" : formatSeconds(job.keep_seconds);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto now = std::chrono::steady_clock::now();
+            Tracking& tracking = tracking_[job.model];
+            if (!error.empty()) {
+                backoff(tracking, now);
+                record(job.model, (job.preload ? "preload failed: " : "keep-alive failed: ") + error, false);
+            } else if (job.preload) {
+                // A timeout usually means a large load still in progress: confirm via /api/ps
+                tracking.preloaded = true;
+                tracking.awaiting = !ok;
+                tracking.preloaded_at = now;
+                tracking.failures = 0;
+                record(job.model, ok ? "preloaded, keep " + keep : "preload sent, loading", true);
+            } else if (ok) {
+                tracking.failures = 0;
+                record(job.model, "keep-alive " + keep, true);
+            } else {
+                backoff(tracking, now);
+                record(job.model, "keep-alive timed out", false);
+            }
+            in_flight_.clear();
+        }
+        report();
+    }
+}
@@ -0,0 +1,183 @@
+#include "../include/model_metadata_cache.h"
+#include "../include/platform.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+// Failed /api/show calls are retried no more often than this
+static const std::chrono::seconds kRetryInterval(60);
+
+ModelMetadataCache::ModelMetadataCache(OllamaClient& client, const std::string& cache_file)
+    : client_(client), cache_file_(cache_file) {
+    load();
+    worker_ = std::thread(&ModelMetadataCache::workerLoop, this);
+}
+
+ModelMetadataCache::~ModelMetadataCache() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+std::shared_ptr<const ModelMetadata> ModelMetadataCache::lookup(const std::string& name,
+                                                                const std::string& digest) {
+    if (digest.empty()) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // A new digest under a known name means the model was re-pulled
+    auto known = digest_by_name_.find(name);
+    if (known == digest_by_name_.end()) {
+        digest_by_name_[name] = digest;
+    } else if (known->second != digest) {
+        std::string old = std::move(known->second);
+        known->second = digest;
+        // Other tags of the same model (llama3:latest and llama3:8b) may still use it
+        bool shared = std::any_of(digest_by_name_.begin(), digest_by_name_.end(),
+                                  [&old](const auto& entry) { return entry.second == old; });
+        if (!shared) {
+            by_digest_.erase(old);
+        }
+    }
+
+    auto it = by_digest_.find(digest);
+    if (it != by_digest_.end()) {
+        return it->second;
+    }
+
+    auto failed = failed_at_.find(digest);
+    if (failed != failed_at_.end() && std::chrono::steady_clock::now() - failed->second < kRetryInterval) {
+        return nullptr;
+    }
+
+    if (queued_.insert(digest).second) {
+        queue_.push_back({name, digest});
+        cv_.notify_one();
+    }
+    return nullptr;
+}
+
+void ModelMetadataCache::setCatalog(const std::vector<OllamaModel>& models) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    catalog_known_ = true;
+    catalog_digests_.clear();
+    for (const auto& model : models) {
+        catalog_digests_.insert(model.digest);
+    }
+}
+
+void ModelMetadataCache::setOnUpdate(std::function<void()> on_update) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    on_update_ = std::move(on_update);
+}
+
+void ModelMetadataCache::workerLoop() {
+    for (;;) {
+        PendingFetch fetch;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (stopping_) {
+                return;
+            }
+            fetch = queue_.front();
+            queue_.pop_front();
+        }
+
+        // Network call happens without the lock held
+        auto metadata = client_.showModel(fetch.name);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queued_.erase(fetch.digest);
+            if (!metadata) {
+                failed_at_[fetch.digest] = std::chrono::steady_clock::now();
+                continue;
+            }
+            failed_at_.erase(fetch.digest);
+            metadata->digest = fetch.digest;
+            by_digest_[fetch.digest] = std::move(metadata);
+        }
+        save();
+        
+        std::function<void()> on_update;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            on_update = on_update_;
+        }
+        if (on_update) {
+            on_update();
+        }
+    }
+}
+
+// One entry per line: digest, architecture, numeric fields, comma-separated capabilities
+void ModelMetadataCache::load() {
+    if (cache_file_.empty()) {
+        return;
+    }
+    std::ifstream in(cache_file_);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        auto metadata = std::make_shared<ModelMetadata>();
+        std::string capabilities;
+        if (!std::getline(fields, metadata->digest, '\t') ||
+            !std::getline(fields, metadata->architecture, '\t')) {
+            continue;
+        }
+        fields >> metadata->parameter_count >> metadata->block_count >> metadata->context_length
+               >> metadata->embedding_length >> metadata->head_count >> metadata->head_count_kv
+               >> metadata->key_length >> metadata->value_length;
+        if (!fields) {
+            continue;
+        }
+        fields >> capabilities;
+        std::istringstream caps(capabilities);
+        std::string capability;
+        while (std::getline(caps, capability, ',')) {
+            if (!capability.empty()) {
+                metadata->capabilities.push_back(capability);
+            }
+        }
+        by_digest_[metadata->digest] = metadata;
+    }
+}
+
+void ModelMetadataCache::save() {
+    if (cache_file_.empty()) {
+        return;
+    }
+
+    std::ostringstream out;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& [digest, metadata] : by_digest_) {
+            // Drop digests no installed model points at any more; until a whole
+            // catalog has been seen, entries not looked up yet may still be in use
+            if (catalog_known_ && !catalog_digests_.count(digest) &&
+                std::none_of(digest_by_name_.begin(), digest_by_name_.end(),
+                             [&digest](const auto& entry) { return entry.second == digest; })) {
+                continue;
+            }
+            out << digest << '\t' << metadata->architecture << '\t'
+                << metadata->parameter_count << ' ' << metadata->block_count << ' '
+                << metadata->context_length << ' ' << metadata->embedding_length << ' '
+                << metadata->head_count << ' ' << metadata->head_count_kv << ' '
+                << metadata->key_length << ' ' << metadata->value_length << ' ';
+            for (size_t i = 0; i < metadata->capabilities.size(); i++) {
+                out << (i > 0 ? "," : "") << metadata->capabilities[i];
+            }
+            out << '\n';
+        }
+    }
+
+    writeFileAtomically(cache_file_, out.str());
+}
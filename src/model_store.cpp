@@ -0,0 +1,305 @@
+#include "../include/model_store.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <system_error>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Residency is re-sampled this often; the catalog itself only on change
+static const std::chrono::seconds kSampleInterval(10);
+// Pages checked per blob: 64 evenly spaced runs of 64 pages (1 MB each at 4K)
+static const size_t kSampleRuns = 64;
+static const size_t kRunPages = 64;
+// Page cache to GPU upload is bounded by memcpy/PCIe, not the disk
+static const double kCachedLoadMBs = 4000.0;
+// Used when the device behind the models directory can't be identified
+static const double kDefaultDiskMBs = 500.0;
+
+#ifdef __linux__
+
+static std::string readSysfsText(const std::string& path) {
+    std::ifstream file(path);
+    std::string text;
+    std::getline(file, text);
+    return text;
+}
+
+#endif
+
+ModelStore::ModelStore(const std::string& models_dir) : dir_(models_dir) {
+    detectDisk();
+}
+
+ModelStore::~ModelStore() {
+    releaseBlobs();
+}
+
+void ModelStore::releaseBlobs() {
+#ifdef __linux__
+    for (auto& [digest, blob] : blobs_) {
+        if (blob.map) {
+            munmap(blob.map, static_cast<size_t>(blob.size));
+        }
+    }
+#endif
+    blobs_.clear();
+    model_blobs_.clear();
+}
+
+void ModelStore::detectDisk() {
+    disk_mb_s_ = kDefaultDiskMBs;
+#ifdef __linux__
+    struct stat st;
+    if (dir_.empty() || stat(dir_.c_str(), &st) != 0) {
+        return;
+    }
+
+    // /sys/dev/block/M:m is the partition; its queue/ lives on the parent disk
+    std::error_code ec;
+    std::string dev = "/sys/dev/block/" + std::to_string(major(st.st_dev)) + ":" +
+                      std::to_string(minor(st.st_dev));
+    std::filesystem::path device = std::filesystem::canonical(dev, ec);
+    if (ec) {
+        return;
+    }
+    if (!std::filesystem::exists(device / "queue", ec)) {
+        device = device.parent_path();
+    }
+    std::string rotational = readSysfsText((device / "queue" / "rotational").string());
+    if (rotational.empty()) {
+        return;
+    }
+
+    // Conservative sequential read speeds per class
+    std::string name = device.filename().string();
+    if (rotational == "1") {
+        disk_kind_ = "HDD";
+        disk_mb_s_ = 150.0;
+    } else if (name.rfind("nvme", 0) == 0) {
+        disk_kind_ = "NVMe";
+        disk_mb_s_ = 2000.0;
+    } else {
+        disk_kind_ = "SSD";
+        disk_mb_s_ = 500.0;
+    }
+#endif
+}
+
+// registry.ollama.ai/library/llama3/8b for "llama3:8b", as the server resolves it
+std::string ModelStore::manifestPath(const std::string& name) const {
+    std::string repo = name;
+    std::string tag = "latest";
+    size_t colon = name.find_last_of(':');
+    if (colon != std::string::npos && name.find('/', colon) == std::string::npos) {
+        repo = name.substr(0, colon);
+        tag = name.substr(colon + 1);
+    }
+
+    std::vector<std::string> parts;
+    std::stringstream ss(repo);
+    std::string part;
+    while (std::getline(ss, part, '/')) {
+        parts.push_back(part);
+    }
+    if (parts.size() == 1) {
+        parts.insert(parts.begin(), {"registry.ollama.ai", "library"});
+    } else if (parts.size() == 2) {
+        parts.insert(parts.begin(), "registry.ollama.ai");
+    }
+
+    std::filesystem::path path = std::filesystem::path(dir_) / "manifests";
+    for (const auto& p : parts) {
+        path /= p;
+    }
+    path /= tag;
+    return path.string();
+}
+
+void ModelStore::loadManifests(const std::vector<OllamaModel>& models) {
+    releaseBlobs();
+
+    for (const auto& model : models) {
+        std::ifstream file(manifestPath(model.name));
+        if (!file) {
+            continue;
+        }
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        std::string manifest = buffer.str();
+
+        // Config and layers are all "sha256:<64 hex>" blob references
+        std::vector<std::string> digests;
+        size_t pos = 0;
+        while ((pos = manifest.find("sha256:", pos)) != std::string::npos) {
+            pos += 7;
+            std::string hex = manifest.substr(pos, 64);
+            if (hex.size() != 64) {
+                break;
+            }
+            bool seen = false;
+            for (const auto& d : digests) {
+                seen = seen || d == hex;
+            }
+            if (!seen) {
+                digests.push_back(hex);
+            }
+        }
+
+        std::vector<std::string> found;
+        for (const auto& hex : digests) {
+            auto it = blobs_.find(hex);
+            if (it == blobs_.end()) {
+                Blob blob;
+                blob.path = (std::filesystem::path(dir_) / "blobs" / ("sha256-" + hex)).string();
+                std::error_code ec;
+                auto size = std::filesystem::file_size(blob.path, ec);
+                if (ec) {
+                    continue;
+                }
+                blob.size = static_cast<int64_t>(size);
+                it = blobs_.emplace(hex, std::move(blob)).first;
+            }
+            it->second.refs++;
+            found.push_back(hex);
+        }
+        model_blobs_[model.name] = std::move(found);
+    }
+}
+
+void ModelStore::sampleResidency(Blob& blob) {
+#ifdef __linux__
+    if (blob.size <= 0) {
+        return;
+    }
+    if (!blob.map) {
+        // Mapping only reserves address space; mincore() never faults pages in
+        int fd = open(blob.path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        void* map = mmap(nullptr, static_cast<size_t>(blob.size), PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED) {
+            return;
+        }
+        blob.map = map;
+    }
+
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t total_pages = (static_cast<size_t>(blob.size) + page - 1) / page;
+    unsigned char vec[kRunPages];
+    size_t sampled = 0;
+    size_t resident = 0;
+
+    // Small blobs are checked in full, large ones in evenly spaced runs
+    size_t runs = total_pages <= kSampleRuns * kRunPages ? (total_pages + kRunPages - 1) / kRunPages : kSampleRuns;
+    size_t stride = total_pages <= kSampleRuns * kRunPages ? kRunPages : total_pages / kSampleRuns;
+    for (size_t run = 0; run < runs; run++) {
+        size_t first = run * stride;
+        size_t count = std::min(kRunPages, total_pages - first);
+        char* addr = static_cast<char*>(blob.map) + first * page;
+        if (mincore(addr, count * page, vec) != 0) {
+            return;
+        }
+        for (size_t i = 0; i < count; i++) {
+            resident += vec[i] & 1;
+        }
+        sampled += count;
+    }
+    blob.resident = sampled > 0 ? static_cast<double>(resident) / static_cast<double>(sampled) : -1.0;
+#else
+    (void)blob;
+#endif
+}
+
+ModelStoreInfo ModelStore::analyze(const std::vector<OllamaModel>& models) {
+    ModelStoreInfo info;
+    if (dir_.empty()) {
+        return info;
+    }
+    info.available = true;
+    info.models_dir = dir_;
+    info.disk_kind = disk_kind_;
+    info.disk_mb_s = disk_mb_s_;
+
+    // Re-read manifests only when the installed set changes (FNV-1a of name+digest)
+    uint64_t hash = 1469598103934665603ULL;
+    auto mix = [&hash](const std::string& s) {
+        for (unsigned char c : s) {
+            hash = (hash ^ c) * 1099511628211ULL;
+        }
+        hash = (hash ^ 0xff) * 1099511628211ULL;
+    };
+    for (const auto& model : models) {
+        mix(model.name);
+        mix(model.digest);
+    }
+    bool reloaded = false;
+    if (hash != catalog_hash_) {
+        catalog_hash_ = hash;
+        loadManifests(models);
+        reloaded = true;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (reloaded || now - last_sample_ >= kSampleInterval) {
+        last_sample_ = now;
+        for (auto& [digest, blob] : blobs_) {
+            sampleResidency(blob);
+        }
+    }
+
+    for (const auto& [digest, blob] : blobs_) {
+        info.store_bytes += blob.size;
+        if (blob.resident >= 0) {
+            info.cached_bytes += static_cast<int64_t>(blob.resident * static_cast<double>(blob.size));
+        }
+    }
+
+    int64_t referenced = 0;
+    for (const auto& model : models) {
+        auto it = model_blobs_.find(model.name);
+        if (it == model_blobs_.end() || it->second.empty()) {
+            continue;
+        }
+
+        ModelStoreEntry entry;
+        entry.found = true;
+        double cached = 0.0;
+        bool known = true;
+        for (const auto& hex : it->second) {
+            const Blob& blob = blobs_[hex];
+            entry.disk_bytes += blob.size;
+            if (blob.refs > 1) {
+                entry.shared_bytes += blob.size;
+            }
+            if (blob.resident < 0) {
+                known = false;
+            } else {
+                cached += blob.resident * static_cast<double>(blob.size);
+            }
+        }
+        referenced += entry.disk_bytes;
+
+        double total_mb = static_cast<double>(entry.disk_bytes) / (1024.0 * 1024.0);
+        double cached_mb = known ? cached / (1024.0 * 1024.0) : 0.0;
+        if (known && entry.disk_bytes > 0) {
+            entry.cached_percent = 100.0 * cached / static_cast<double>(entry.disk_bytes);
+        }
+        entry.est_load_seconds = (total_mb - cached_mb) / disk_mb_s_ + total_mb / kCachedLoadMBs;
+        info.models[model.name] = entry;
+    }
+    info.dedup_saved_bytes = referenced - info.store_bytes;
+    if (info.dedup_saved_bytes < 0) {
+        info.dedup_saved_bytes = 0;
+    }
+    return info;
+}
@@ -1,159 +1,69 @@
 #include "../include/ollama_client.h"
+#include "../include/http_client.h"
+#include "../include/profiler.h"
 #include <sstream>
 #include <algorithm>
 #include <cctype>
 #include <vector>
 
-#ifdef _WIN32
-#include <windows.h>
-#include <winhttp.h>
-#pragma comment(lib, "winhttp.lib")
-#endif
-
 OllamaClient::OllamaClient(const std::string& base_url) 
     : base_url_(base_url), connected_(false) {
-    connected_ = testConnection();
 }
 
 OllamaClient::~OllamaClient() {
+    stopProbing();
 }
 
 bool OllamaClient::isConnected() const {
     return connected_;
 }
 
-bool OllamaClient::testConnection() {
-    try {
-        std::string response = makeRequest("/api/tags");
-        bool ok = !response.empty() && response.find("\"models\"") != std::string::npos;
-        return ok;
-    } catch (...) {
-        return false;
-    }
+bool OllamaClient::probe() {
+    // A few bytes, unlike /api/tags which lists the whole catalog
+    std::string response = makeRequest("/api/version");
+    bool ok = response.find("\"version\"") != std::string::npos;
+    connected_ = ok;
+    return ok;
 }
 
-std::string OllamaClient::makeRequest(const std::string& endpoint) {
-#ifdef _WIN32
-    std::string result;
-    
-    // Parse the base URL to extract host and port
-    std::string host = "localhost";
-    int port = 11434;
-    
-    // Simple URL parsing for http://host:port format
-    std::string url = base_url_;
-    if (url.find("http://") == 0) {
-        url = url.substr(7);
-    } else if (url.find("https://") == 0) {
-        url = url.substr(8);
-    }
-    
-    size_t colon_pos = url.find(':');
-    if (colon_pos != std::string::npos) {
-        host = url.substr(0, colon_pos);
-        std::string port_str = url.substr(colon_pos + 1);
-        // Remove trailing slash if present
-        size_t slash_pos = port_str.find('/');
-        if (slash_pos != std::string::npos) {
-            port_str = port_str.substr(0, slash_pos);
-        }
-        try {
-            port = std::stoi(port_str);
-        } catch (...) {
-            port = 11434;
-        }
-    } else {
-        size_t slash_pos = url.find('/');
-        if (slash_pos != std::string::npos) {
-            host = url.substr(0, slash_pos);
-        } else {
-            host = url;
+void OllamaClient::startProbing(std::chrono::milliseconds interval, std::function<void(bool)> on_change) {
+    stopProbing();
+    probe_stop_ = false;
+    probe_thread_ = std::thread([this, interval, on_change] {
+        bool last = connected_;
+        std::unique_lock<std::mutex> lock(probe_mutex_);
+        while (!probe_stop_) {
+            lock.unlock();
+            bool now = probe();
+            lock.lock();
+            if (now != last && !probe_stop_ && on_change) {
+                on_change(now);
+            }
+            last = now;
+            probe_cv_.wait_for(lock, interval, [this] { return probe_stop_; });
         }
+    });
+}
+
+void OllamaClient::stopProbing() {
+    {
+        std::lock_guard<std::mutex> lock(probe_mutex_);
+        probe_stop_ = true;
     }
-    
-    // Convert host to wide string
-    std::wstring whost(host.begin(), host.end());
-    std::wstring wendpoint(endpoint.begin(), endpoint.end());
-    
-    // Initialize WinHTTP
-    HINTERNET hSession = WinHttpOpen(L"OllamaMonitor/1.0",
-                                      WINHTTP_ACCESS_TYPE_NO_PROXY,
-                                      WINHTTP_NO_PROXY_NAME,
-                                      WINHTTP_NO_PROXY_BYPASS, 0);
-    if (!hSession) {
-        return "";
-    }
-    
-    // Set timeouts (5 seconds)
-    WinHttpSetTimeouts(hSession, 5000, 5000, 5000, 5000);
-    
-    // Connect to server
-    HINTERNET hConnect = WinHttpConnect(hSession, whost.c_str(), 
-                                         static_cast<INTERNET_PORT>(port), 0);
-    if (!hConnect) {
-        WinHttpCloseHandle(hSession);
-        return "";
-    }
-    
-    // Create request
-    HINTERNET hRequest = WinHttpOpenRequest(hConnect, L"GET", wendpoint.c_str(),
-                                            NULL, WINHTTP_NO_REFERER,
-                                            WINHTTP_DEFAULT_ACCEPT_TYPES, 0);
-    if (!hRequest) {
-        WinHttpCloseHandle(hConnect);
-        WinHttpCloseHandle(hSession);
-        return "";
-    }
-    
-    // Send request
-    BOOL bResults = WinHttpSendRequest(hRequest,
-                                       WINHTTP_NO_ADDITIONAL_HEADERS, 0,
-                                       WINHTTP_NO_REQUEST_DATA, 0,
-                                       0, 0);
-    
-    if (bResults) {
-        bResults = WinHttpReceiveResponse(hRequest, NULL);
-    }
-    
-    // Read response
-    if (bResults) {
-        DWORD dwSize = 0;
-        DWORD dwDownloaded = 0;
-        
-        do {
-            dwSize = 0;
-            if (!WinHttpQueryDataAvailable(hRequest, &dwSize)) {
-                break;
-            }
-            
-            if (dwSize == 0) {
-                break;
-            }
-            
-            char* pszOutBuffer = new char[dwSize + 1];
-            if (!pszOutBuffer) {
-                break;
-            }
-            
-            ZeroMemory(pszOutBuffer, dwSize + 1);
-            
-            if (WinHttpReadData(hRequest, (LPVOID)pszOutBuffer, dwSize, &dwDownloaded)) {
-                result.append(pszOutBuffer, dwDownloaded);
-            }
-            
-            delete[] pszOutBuffer;
-        } while (dwSize > 0);
+    probe_cv_.notify_all();
+    if (probe_thread_.joinable()) {
+        probe_thread_.join();
     }
-    
-    // Cleanup
-    WinHttpCloseHandle(hRequest);
-    WinHttpCloseHandle(hConnect);
-    WinHttpCloseHandle(hSession);
-    
-    return result;
-#else
-    return "";
-#endif
+}
+
+std::string OllamaClient::makeRequest(const std::string& endpoint) {
+    PROFILE_SCOPE(HttpRequest);
+    return httpRequest(base_url_, "GET", endpoint);
+}
+
+std::string OllamaClient::makePostRequest(const std::string& endpoint, const std::string& body) {
+    PROFILE_SCOPE(HttpRequest);
+    return httpRequest(base_url_, "POST", endpoint, body);
 }
 
 std::vector<std::string> OllamaClient::split(const std::string& s, char delimiter) {
@@ -242,6 +152,9 @@ OllamaRunningModel OllamaClient::parseRunningModel(const std::string& json_str)
     model.size = extractIntValue(json_str, "size");
     model.expires_at = extractStringValue(json_str, "expires_at");
     model.digest = extractStringValue(json_str, "digest");
+    model.has_size_vram = json_str.find("\"size_vram\"") != std::string::npos;
+    model.size_vram = extractIntValue(json_str, "size_vram");
+    model.context_length = extractIntValue(json_str, "context_length");
     
     // Parse details object
     model.details.parent_model = extractStringValue(json_str, "parent_model");
@@ -266,11 +179,80 @@ OllamaModel OllamaClient::parseModel(const std::string& json_str) {
     return model;
 }
 
+ModelMetadata OllamaClient::parseModelMetadata(const std::string& json_str) {
+    ModelMetadata metadata;
+    
+    // model_info keys are prefixed with the architecture name
+    metadata.architecture = extractStringValue(json_str, "general.architecture");
+    metadata.parameter_count = extractIntValue(json_str, "general.parameter_count");
+    if (!metadata.architecture.empty()) {
+        const std::string& arch = metadata.architecture;
+        metadata.block_count = extractIntValue(json_str, arch + ".block_count");
+        metadata.context_length = extractIntValue(json_str, arch + ".context_length");
+        metadata.embedding_length = extractIntValue(json_str, arch + ".embedding_length");
+        metadata.head_count = extractIntValue(json_str, arch + ".attention.head_count");
+        metadata.head_count_kv = extractIntValue(json_str, arch + ".attention.head_count_kv");
+        metadata.key_length = extractIntValue(json_str, arch + ".attention.key_length");
+        metadata.value_length = extractIntValue(json_str, arch + ".attention.value_length");
+    }
+    metadata.capabilities = extractArrayValues(json_str, "capabilities");
+    
+    return metadata;
+}
+
+// Model names as a JSON string value
+static std::string quoteName(const std::string& name) {
+    std::string quoted = "\"";
+    for (char c : name) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+        }
+        quoted += c;
+    }
+    return quoted + '"';
+}
+
+std::unique_ptr<ModelMetadata> OllamaClient::showModel(const std::string& name) {
+    std::string response = makePostRequest("/api/show", "{\"model\":" + quoteName(name) + "}");
+    if (response.empty() || response.find("\"model_info\"") == std::string::npos) {
+        return nullptr;
+    }
+    
+    return std::make_unique<ModelMetadata>(parseModelMetadata(response));
+}
+
+bool OllamaClient::keepAlive(const std::string& name, int64_t keep_alive_seconds, int64_t num_ctx,
+                             std::string& error) {
+    std::string body = "{\"model\":" + quoteName(name) +
+                       ",\"keep_alive\":" + std::to_string(keep_alive_seconds < 0 ? -1 : keep_alive_seconds);
+    if (num_ctx > 0) {
+        body += ",\"options\":{\"num_ctx\":" + std::to_string(num_ctx) + "}";
+    }
+    body += "}";
+    
+    error.clear();
+    std::string response = makePostRequest("/api/generate", body);
+    if (response.empty()) {
+        return false;
+    }
+    if (response.find("\"error\"") != std::string::npos) {
+        error = extractStringValue(response, "error");
+        if (error.empty()) {
+            error = "request failed";
+        }
+        return false;
+    }
+    return response.find("\"done\":true") != std::string::npos;
+}
+
 std::unique_ptr<OllamaStatus> OllamaClient::getStatus() {
     std::string response = makeRequest("/api/ps");
     if (response.empty()) {
+        // Skip further requests until the next probe succeeds
+        connected_ = false;
         return nullptr;
     }
+    PROFILE_SCOPE(ParseStatus);
 
     auto status = std::make_unique<OllamaStatus>();
     
@@ -317,11 +299,15 @@ std::unique_ptr<OllamaStatus> OllamaClient::getStatus() {
     return status;
 }
 
-std::vector<OllamaModel> OllamaClient::getModels() {
+std::vector<OllamaModel> OllamaClient::getModels(bool* complete) {
+    if (complete) {
+        *complete = false;
+    }
     std::string response = makeRequest("/api/tags");
     if (response.empty()) {
         return {};
     }
+    PROFILE_SCOPE(ParseModels);
 
     std::vector<OllamaModel> models;
     
@@ -340,6 +326,9 @@ std::vector<OllamaModel> OllamaClient::getModels() {
         }
         
         if (bracket_count == 0) {
+            if (complete) {
+                *complete = true;
+            }
             std::string models_array = response.substr(pos, end - pos - 1);
             
             // Parse individual model objects
@@ -0,0 +1,251 @@
+#include "../include/placement.h"
+#include "../include/platform.h"
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+// Runtime context and compute graph Ollama reserves on every device it uses
+static const int64_t kDeviceOverhead = 512LL * 1024 * 1024;
+static const int64_t kDefaultContext = 4096;
+// OLLAMA_MAX_LOADED_MODELS default, per GPU
+static const size_t kLoadedPerGpu = 3;
+
+static int64_t envInt(const char* name, int64_t fallback) {
+    if (const char* value = std::getenv(name); value && *value) {
+        char* end = nullptr;
+        long long parsed = std::strtoll(value, &end, 10);
+        if (end && *end == '\0' && parsed > 0) {
+            return parsed;
+        }
+    }
+    return fallback;
+}
+
+static int64_t gibToBytes(double gib) {
+    return static_cast<int64_t>(gib * 1024.0 * 1024.0 * 1024.0);
+}
+
+PlacementPlanner::PlacementPlanner(const std::vector<GPUInfo>& gpus, const OllamaStatus* status) {
+    for (const auto& gpu : gpus) {
+        if (gpu.available && !gpu.shared_memory && gpu.total_vram_gb > 0) {
+            devices_.push_back({gpu.index, gibToBytes(gpu.free_vram_gb), gibToBytes(gpu.used_vram_gb)});
+        }
+    }
+    if (status) {
+        for (const auto& model : status->models) {
+            residents_.push_back({model.name, model.has_size_vram ? model.size_vram : model.size,
+                                  parseTimestamp(model.expires_at)});
+        }
+        std::stable_sort(residents_.begin(), residents_.end(),
+                         [](const Resident& a, const Resident& b) { return a.expires < b.expires; });
+    }
+    size_t gpu_count = devices_.empty() ? 1 : devices_.size();
+    max_loaded_ = static_cast<size_t>(envInt("OLLAMA_MAX_LOADED_MODELS",
+                                             static_cast<int64_t>(kLoadedPerGpu * gpu_count)));
+}
+
+int64_t PlacementPlanner::defaultContext() {
+    return envInt("OLLAMA_CONTEXT_LENGTH", kDefaultContext);
+}
+
+int64_t PlacementPlanner::estimateBytes(int64_t weights, const ModelMetadata* metadata, int64_t context) {
+    if (!metadata) {
+        return weights;
+    }
+    // Ollama clamps the requested context to what the model was trained on
+    if (metadata->context_length > 0 && context > metadata->context_length) {
+        context = metadata->context_length;
+    }
+    return weights + metadata->estimateKVCacheBytes(context);
+}
+
+Placement PlacementPlanner::plan(const std::string& name, int64_t bytes) const {
+    std::vector<Device> devices = devices_;
+    size_t evicted = 0;
+    int64_t placed = 0;
+    return simulate(name, bytes, devices, evicted, placed);
+}
+
+Placement PlacementPlanner::place(const std::string& name, int64_t bytes) {
+    size_t evicted = 0;
+    int64_t placed = 0;
+    Placement placement = simulate(name, bytes, devices_, evicted, placed);
+    if (placement.kind != PlacementKind::Loaded) {
+        residents_.erase(residents_.begin(), residents_.begin() + static_cast<std::ptrdiff_t>(evicted));
+        // Just loaded, so it expires after everything already resident
+        residents_.push_back({name, placed, std::numeric_limits<int64_t>::max()});
+    }
+    return placement;
+}
+
+Placement PlacementPlanner::simulate(const std::string& name, int64_t bytes, std::vector<Device>& devices,
+                                     size_t& evicted, int64_t& placed) const {
+    Placement result;
+    result.required_bytes = bytes + kDeviceOverhead;
+
+    for (const auto& resident : residents_) {
+        if (resident.name == name) {
+            result.kind = PlacementKind::Loaded;
+            result.required_bytes = resident.vram;
+            return result;
+        }
+    }
+    if (devices.empty()) {
+        result.kind = PlacementKind::CpuOnly;
+        return result;
+    }
+
+    // Which GPU held an unloaded model isn't known; credit by used VRAM
+    auto evictNext = [&] {
+        const Resident& resident = residents_[evicted++];
+        result.evicts.push_back(resident.name);
+        int64_t total_used = 0;
+        for (const auto& device : devices) {
+            total_used += device.used;
+        }
+        for (auto& device : devices) {
+            int64_t share = total_used > 0
+                ? static_cast<int64_t>(static_cast<double>(resident.vram) * static_cast<double>(device.used) /
+                                       static_cast<double>(total_used))
+                : resident.vram / static_cast<int64_t>(devices.size());
+            share = std::min(share, device.used);
+            device.free += share;
+            device.used -= share;
+        }
+    };
+
+    std::vector<Device*> order;
+    order.reserve(devices.size());
+    for (;;) {
+        if (evicted < residents_.size() && residents_.size() - evicted >= max_loaded_) {
+            evictNext();
+            continue;
+        }
+
+        order.clear();
+        for (auto& device : devices) {
+            order.push_back(&device);
+        }
+        std::stable_sort(order.begin(), order.end(),
+                         [](const Device* a, const Device* b) { return a->free > b->free; });
+
+        // Whole model on the emptiest GPU
+        if (order[0]->free >= bytes + kDeviceOverhead) {
+            order[0]->free -= bytes + kDeviceOverhead;
+            order[0]->used += bytes + kDeviceOverhead;
+            placed = bytes + kDeviceOverhead;
+            result.kind = PlacementKind::Fits;
+            result.gpu = order[0]->index;
+            return result;
+        }
+
+        // Layers across GPUs, each paying its own overhead
+        int64_t usable = 0;
+        int count = 0;
+        for (const Device* device : order) {
+            if (device->free > kDeviceOverhead) {
+                usable += device->free - kDeviceOverhead;
+                count++;
+                if (usable >= bytes) {
+                    break;
+                }
+            }
+        }
+        bool split = devices.size() > 1 && count > 1 && usable >= bytes;
+
+        if (!split && evicted < residents_.size()) {
+            evictNext();
+            continue;
+        }
+
+        // Split, or with nothing left to unload, as much as fits and the rest on the CPU
+        int64_t remaining = bytes;
+        int used_devices = 0;
+        placed = 0;
+        for (Device* device : order) {
+            if (remaining <= 0 || device->free <= kDeviceOverhead) {
+                continue;
+            }
+            int64_t take = std::min(remaining, device->free - kDeviceOverhead);
+            device->free -= take + kDeviceOverhead;
+            device->used += take + kDeviceOverhead;
+            placed += take + kDeviceOverhead;
+            remaining -= take;
+            used_devices++;
+        }
+        if (split) {
+            result.kind = PlacementKind::Split;
+            result.gpu_count = used_devices;
+        } else if (used_devices == 0) {
+            result.kind = PlacementKind::CpuOnly;
+        } else {
+            result.kind = PlacementKind::Offload;
+            result.gpu_percent = bytes > 0 ? 100.0 * static_cast<double>(bytes - remaining) / static_cast<double>(bytes) : 0.0;
+        }
+        return result;
+    }
+}
+
+std::vector<Placement> PlacementPlanner::planCatalog(const std::vector<OllamaModel>& catalog,
+                                                     const MetadataLookup& metadata) const {
+    std::vector<Placement> result;
+    if (devices_.empty()) {
+        return result;
+    }
+    int64_t context = defaultContext();
+    result.reserve(catalog.size());
+    for (const auto& model : catalog) {
+        const ModelMetadata* meta = metadata(model);
+        result.push_back(plan(model.name, estimateBytes(model.size, meta, context)));
+        result.back().kv_known = meta != nullptr;
+    }
+    return result;
+}
+
+std::vector<PlannedModel> PlacementPlanner::planQuery(const std::string& query,
+                                                      const std::vector<OllamaModel>& catalog,
+                                                      const MetadataLookup& metadata) {
+    std::vector<PlannedModel> result;
+    size_t pos = 0;
+    while (pos < query.size()) {
+        size_t start = query.find_first_not_of(" ,\t", pos);
+        if (start == std::string::npos) {
+            break;
+        }
+        size_t end = query.find_first_of(" ,\t", start);
+        if (end == std::string::npos) {
+            end = query.size();
+        }
+        pos = end;
+
+        std::string name = query.substr(start, end - start);
+        int64_t context = defaultContext();
+        if (size_t at = name.find('@'); at != std::string::npos) {
+            char* parsed_end = nullptr;
+            long long parsed = std::strtoll(name.c_str() + at + 1, &parsed_end, 10);
+            if (parsed > 0 && parsed_end && *parsed_end == '\0') {
+                context = parsed;
+            }
+            name.resize(at);
+        }
+
+        // Ollama resolves a bare name to its :latest tag
+        const OllamaModel* model = nullptr;
+        for (const auto& entry : catalog) {
+            if (entry.name == name || entry.name == name + ":latest") {
+                model = &entry;
+                break;
+            }
+        }
+
+        PlannedModel planned;
+        planned.name = model ? model->name : name;
+        if (model) {
+            const ModelMetadata* meta = metadata(*model);
+            planned.placement = place(model->name, estimateBytes(model->size, meta, context));
+            planned.placement.kv_known = meta != nullptr;
+        }
+        result.push_back(std::move(planned));
+    }
+    return result;
+}
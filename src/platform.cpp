@@ -0,0 +1,190 @@
+#include "../include/platform.h"
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <netinet/in.h>
+#endif
+
+std::string cacheDirectory() {
+    std::filesystem::path dir;
+#ifdef _WIN32
+    if (const char* local = std::getenv("LOCALAPPDATA")) {
+        dir = std::filesystem::path(local) / "ollama-monitor";
+    }
+#else
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+        dir = std::filesystem::path(xdg) / "ollama-monitor";
+    } else if (const char* home = std::getenv("HOME")) {
+        dir = std::filesystem::path(home) / ".cache" / "ollama-monitor";
+    }
+#endif
+    if (dir.empty()) {
+        return "";
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    if (ec) {
+        return "";
+    }
+    return dir.string();
+}
+
+std::string ollamaModelsDirectory() {
+    if (const char* env = std::getenv("OLLAMA_MODELS"); env && *env) {
+        return env;
+    }
+
+    std::error_code ec;
+#ifdef _WIN32
+    const char* home = std::getenv("USERPROFILE");
+#else
+    const char* home = std::getenv("HOME");
+#endif
+    if (home) {
+        std::filesystem::path dir = std::filesystem::path(home) / ".ollama" / "models";
+        if (std::filesystem::is_directory(dir, ec)) {
+            return dir.string();
+        }
+    }
+#ifndef _WIN32
+    // Linux install script runs the server as the ollama user
+    if (std::filesystem::is_directory("/usr/share/ollama/.ollama/models", ec)) {
+        return "/usr/share/ollama/.ollama/models";
+    }
+#endif
+    return "";
+}
+
+bool writeFileAtomically(const std::string& path, std::string_view contents) {
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+        file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+        file.flush();
+        if (!file) {
+            std::remove(tmp.c_str());
+            return false;
+        }
+    }
+#ifdef _WIN32
+    // rename() refuses to replace an existing file on Windows
+    return MoveFileExA(tmp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return std::rename(tmp.c_str(), path.c_str()) == 0;
+#endif
+}
+
+std::string hostName() {
+#ifdef _WIN32
+    char name[MAX_COMPUTERNAME_LENGTH + 1];
+    DWORD size = sizeof(name);
+    if (GetComputerNameA(name, &size)) {
+        return std::string(name, size);
+    }
+#else
+    char name[256];
+    if (gethostname(name, sizeof(name)) == 0) {
+        name[sizeof(name) - 1] = '\0';
+        return name;
+    }
+#endif
+    return "unknown";
+}
+
+int listenTcp(int port) {
+#ifdef __linux__
+    if (port <= 0 || port > 65535) {
+        return -1;
+    }
+
+    int one = 1;
+    int zero = 0;
+    int fd = socket(AF_INET6, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd >= 0) {
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &zero, sizeof(zero));
+        struct sockaddr_in6 addr = {};
+        addr.sin6_family = AF_INET6;
+        addr.sin6_addr = in6addr_any;
+        addr.sin6_port = htons(static_cast<uint16_t>(port));
+        if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    if (fd < 0) {
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            return -1;
+        }
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        struct sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons(static_cast<uint16_t>(port));
+        if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0) {
+            close(fd);
+            return -1;
+        }
+    }
+    if (listen(fd, 128) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+#else
+    (void)port;
+    return -1;
+#endif
+}
+
+int64_t parseTimestamp(const std::string& text) {
+    int year, month, day, hour, min, sec;
+    int consumed = 0;
+    if (sscanf(text.c_str(), "%d-%d-%dT%d:%d:%d%n",
+               &year, &month, &day, &hour, &min, &sec, &consumed) != 6) {
+        return 0;
+    }
+
+    std::tm tm = {};
+    tm.tm_year = year - 1900;
+    tm.tm_mon = month - 1;
+    tm.tm_mday = day;
+    tm.tm_hour = hour;
+    tm.tm_min = min;
+    tm.tm_sec = sec;
+#ifdef _WIN32
+    int64_t epoch = _mkgmtime(&tm);
+#else
+    int64_t epoch = timegm(&tm);
+#endif
+
+    // Skip fractional seconds, then apply the zone offset
+    size_t pos = static_cast<size_t>(consumed);
+    if (pos < text.size() && text[pos] == '.') {
+        pos++;
+        while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') {
+            pos++;
+        }
+    }
+    int off_hour = 0, off_min = 0;
+    if (pos < text.size() && (text[pos] == '+' || text[pos] == '-') &&
+        sscanf(text.c_str() + pos + 1, "%d:%d", &off_hour, &off_min) == 2) {
+        int64_t offset = off_hour * 3600 + off_min * 60;
+        epoch += text[pos] == '+' ? -offset : offset;
+    }
+    return epoch;
+}
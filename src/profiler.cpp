@@ -0,0 +1,248 @@
+#include "../include/profiler.h"
+#include "../include/frame_buffer.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <new>
+#include <vector>
+
+namespace profiler {
+
+// Frames kept for the report (about 11 days at one frame per second)
+static const size_t kMaxFrames = 1000000;
+
+static const char* const kStageNames[] = {
+    "frame", "gpu_info", "host_info", "http_request", "parse_status", "parse_models", "parse_metrics", "compose", "terminal_write"
+};
+static_assert(sizeof(kStageNames) / sizeof(kStageNames[0]) == static_cast<size_t>(Stage::Count),
+              "stage names out of sync");
+
+struct StageTotals {
+    int64_t ns = 0;
+    uint32_t count = 0;
+    uint64_t allocations = 0;
+};
+
+// Allocation counters of the calling thread; trivially initialized so
+// operator new can use them at any time, including during static init
+static thread_local uint64_t t_alloc_count = 0;
+static thread_local uint64_t t_alloc_bytes = 0;
+static thread_local bool t_measured = false;
+static bool g_enabled = false;
+
+// Only touched from the measured thread
+static StageTotals g_current[static_cast<size_t>(Stage::Count)];
+static StageTotals g_last[static_cast<size_t>(Stage::Count)];
+static std::chrono::steady_clock::time_point g_frame_start;
+static uint64_t g_frame_alloc_count = 0;
+static uint64_t g_frame_alloc_bytes = 0;
+static uint64_t g_last_alloc_count = 0;
+static uint64_t g_last_alloc_bytes = 0;
+static bool g_have_last = false;
+
+static std::vector<int64_t> g_samples[static_cast<size_t>(Stage::Count)];
+static std::vector<uint64_t> g_stage_alloc_samples[static_cast<size_t>(Stage::Count)];
+static std::vector<uint64_t> g_alloc_samples;
+static std::vector<uint64_t> g_alloc_byte_samples;
+
+const char* stageName(Stage stage) {
+    return kStageNames[static_cast<size_t>(stage)];
+}
+
+void enable() {
+    g_enabled = true;
+    t_measured = true;
+}
+
+bool enabled() {
+    return g_enabled && t_measured;
+}
+
+uint64_t allocationCount() {
+    return t_alloc_count;
+}
+
+void record(Stage stage, std::chrono::steady_clock::duration elapsed, uint64_t allocations) {
+    if (!enabled()) {
+        return;
+    }
+    StageTotals& totals = g_current[static_cast<size_t>(stage)];
+    totals.ns += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    totals.count++;
+    totals.allocations += allocations;
+}
+
+void beginFrame() {
+    if (!enabled()) {
+        return;
+    }
+    for (auto& totals : g_current) {
+        totals = StageTotals();
+    }
+    g_frame_alloc_count = t_alloc_count;
+    g_frame_alloc_bytes = t_alloc_bytes;
+    g_frame_start = std::chrono::steady_clock::now();
+}
+
+void endFrame() {
+    if (!enabled()) {
+        return;
+    }
+    record(Stage::Frame, std::chrono::steady_clock::now() - g_frame_start);
+
+    // Snapshot before the bookkeeping below allocates
+    g_last_alloc_count = t_alloc_count - g_frame_alloc_count;
+    g_last_alloc_bytes = t_alloc_bytes - g_frame_alloc_bytes;
+    std::copy(std::begin(g_current), std::end(g_current), std::begin(g_last));
+    g_have_last = true;
+
+    if (g_alloc_samples.size() >= kMaxFrames) {
+        return;
+    }
+    for (size_t i = 0; i < static_cast<size_t>(Stage::Count); i++) {
+        if (g_current[i].count > 0) {
+            g_samples[i].push_back(g_current[i].ns);
+            g_stage_alloc_samples[i].push_back(g_current[i].allocations);
+        }
+    }
+    g_alloc_samples.push_back(g_last_alloc_count);
+    g_alloc_byte_samples.push_back(g_last_alloc_bytes);
+}
+
+void appendOverlay(FrameBuffer& out) {
+    if (!enabled() || !g_have_last) {
+        out << "profile: waiting for the first frame";
+        return;
+    }
+    auto ms = [&out](const char* label, Stage stage) {
+        out << label;
+        out.fixed(static_cast<double>(g_last[static_cast<size_t>(stage)].ns) / 1e6, 2);
+    };
+
+    ms("profile: frame ", Stage::Frame);
+    ms("ms | gpu ", Stage::GpuInfo);
+    ms(" host ", Stage::HostInfo);
+    ms(" http ", Stage::HttpRequest);
+    out << " (" << g_last[static_cast<size_t>(Stage::HttpRequest)].count << ")";
+    ms(" ps ", Stage::ParseStatus);
+    ms(" tags ", Stage::ParseModels);
+    ms(" metrics ", Stage::ParseMetrics);
+    ms(" compose ", Stage::Compose);
+    ms(" write ", Stage::TerminalWrite);
+    out << " | allocs " << g_last_alloc_count << " (" << g_last_alloc_bytes / 1024 << " KB), compose "
+        << g_last[static_cast<size_t>(Stage::Compose)].allocations << ", metrics "
+        << g_last[static_cast<size_t>(Stage::ParseMetrics)].allocations;
+}
+
+// Percentiles of a sorted sample set
+template <typename T>
+static T percentileOf(const std::vector<T>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+template <typename T>
+static void writeDistribution(std::ostream& out, std::vector<T> samples, double scale) {
+    std::sort(samples.begin(), samples.end());
+    double sum = 0;
+    for (T v : samples) {
+        sum += static_cast<double>(v);
+    }
+    out << "\"count\": " << samples.size()
+        << ", \"mean\": " << (samples.empty() ? 0.0 : sum / static_cast<double>(samples.size()) / scale)
+        << ", \"p50\": " << static_cast<double>(percentileOf(samples, 0.50)) / scale
+        << ", \"p95\": " << static_cast<double>(percentileOf(samples, 0.95)) / scale
+        << ", \"p99\": " << static_cast<double>(percentileOf(samples, 0.99)) / scale
+        << ", \"max\": " << (samples.empty() ? 0.0 : static_cast<double>(samples.back()) / scale);
+
+    // Power-of-two buckets: [upper bound, count], empty buckets omitted
+    out << ", \"histogram\": [";
+    bool first = true;
+    size_t i = 0;
+    for (double upper = 1; i < samples.size(); upper *= 2) {
+        size_t count = 0;
+        while (i < samples.size() && static_cast<double>(samples[i]) / scale <= upper) {
+            count++;
+            i++;
+        }
+        if (count > 0) {
+            out << (first ? "" : ", ") << "[" << upper << ", " << count << "]";
+            first = false;
+        }
+    }
+    out << "]";
+}
+
+bool writeReport(const std::string& path) {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) {
+        return false;
+    }
+
+    out << std::fixed << std::setprecision(3);
+    out << "{\n  \"frames\": " << g_alloc_samples.size() << ",\n";
+    out << "  \"stages_us\": {\n";
+    for (size_t i = 0; i < static_cast<size_t>(Stage::Count); i++) {
+        out << "    \"" << kStageNames[i] << "\": {";
+        writeDistribution(out, g_samples[i], 1e3);
+        out << ", \"allocations\": {";
+        writeDistribution(out, g_stage_alloc_samples[i], 1.0);
+        out << "}}" << (i + 1 < static_cast<size_t>(Stage::Count) ? "," : "") << "\n";
+    }
+    out << "  },\n";
+    out << "  \"allocations_per_frame\": {";
+    writeDistribution(out, g_alloc_samples, 1.0);
+    out << "},\n";
+    out << "  \"allocated_bytes_per_frame\": {";
+    writeDistribution(out, g_alloc_byte_samples, 1.0);
+    out << "}\n}\n";
+    return static_cast<bool>(out);
+}
+
+} // namespace profiler
+
+// Counting global allocator. Always installed; the per-thread increments are
+// the only cost when profiling is off.
+void* operator new(std::size_t size) {
+    profiler::t_alloc_count++;
+    profiler::t_alloc_bytes += size;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    profiler::t_alloc_count++;
+    profiler::t_alloc_bytes += size;
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept {
+    return operator new(size, tag);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
@@ -0,0 +1,367 @@
+#include "../include/residency_index.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+static const size_t kMaxClients = 64;
+static const size_t kMaxRequest = 512;
+// Longer answers are cut here and end in "...\n"
+static const size_t kMaxResponse = 60 * 1024;
+
+static void appendInt(std::string& out, int64_t value) {
+    char tmp[24];
+    auto result = std::to_chars(tmp, tmp + sizeof(tmp), value);
+    out.append(tmp, static_cast<size_t>(result.ptr - tmp));
+}
+
+static bool sameModel(const fleet::ModelSample& a, const fleet::ModelSample& b) {
+    return a.name == b.name && a.digest == b.digest;
+}
+
+ResidencyIndex::ResidencyIndex(std::string socket_path) : socket_path_(std::move(socket_path)) {}
+
+void ResidencyIndex::update(const fleet::NodeSnapshot& snapshot, bool online) {
+    auto [it, inserted] = host_ids_.try_emplace(snapshot.hostname, static_cast<uint32_t>(hosts_.size()));
+    if (inserted) {
+        hosts_.emplace_back();
+        hosts_.back().name = snapshot.hostname;
+    }
+    uint32_t id = it->second;
+    Host& host = hosts_[id];
+    host.online = online;
+    host.free_mb = 0;
+    host.total_mb = 0;
+    for (const auto& gpu : snapshot.gpus) {
+        host.total_mb += gpu.total_vram_mb;
+        host.free_mb += gpu.total_vram_mb > gpu.used_vram_mb ? gpu.total_vram_mb - gpu.used_vram_mb : 0;
+    }
+    updates_++;
+
+    // Only the difference to the previous snapshot touches the index; a
+    // model reloaded under the same name with a new digest counts as new
+    static const std::vector<fleet::ModelSample> kNone;
+    const auto& next = online ? snapshot.models : kNone;
+    for (const auto& old : host.models) {
+        auto match = [&old](const fleet::ModelSample& model) { return sameModel(model, old); };
+        if (std::none_of(next.begin(), next.end(), match)) {
+            remove(by_name_, old.name, id);
+            if (!old.digest.empty()) {
+                remove(by_digest_, old.digest, id);
+            }
+        }
+    }
+    for (const auto& model : next) {
+        auto match = [&model](const fleet::ModelSample& old) { return sameModel(model, old); };
+        auto old = std::find_if(host.models.begin(), host.models.end(), match);
+        if (old != host.models.end() && old->vram_mb == model.vram_mb && old->expires_at == model.expires_at) {
+            continue;
+        }
+        Residence residence{id, model.vram_mb, model.expires_at};
+        add(by_name_, model.name, residence);
+        if (!model.digest.empty()) {
+            add(by_digest_, model.digest, residence);
+        }
+    }
+    host.models = next;
+}
+
+// Inserts, or updates the host's entry in place
+void ResidencyIndex::add(Index& index, const std::string& key, const Residence& residence) {
+    auto& residences = index[key];
+    for (auto& existing : residences) {
+        if (existing.host == residence.host) {
+            existing = residence;
+            return;
+        }
+    }
+    residences.push_back(residence);
+}
+
+void ResidencyIndex::remove(Index& index, const std::string& key, uint32_t host) {
+    auto it = index.find(key);
+    if (it == index.end()) {
+        return;
+    }
+    auto& residences = it->second;
+    for (size_t i = 0; i < residences.size(); i++) {
+        if (residences[i].host == host) {
+            residences[i] = residences.back();
+            residences.pop_back();
+            break;
+        }
+    }
+    // Names of models nobody runs any more don't accumulate
+    if (residences.empty()) {
+        index.erase(it);
+    }
+}
+
+const std::vector<ResidencyIndex::Residence>* ResidencyIndex::find(std::string_view model) const {
+    auto it = by_name_.find(model);
+    if (it != by_name_.end()) {
+        return &it->second;
+    }
+
+    // "llama3" means "llama3:latest", as on the ollama command line
+    static const std::string_view kLatest = ":latest";
+    char name[kMaxRequest + 8];
+    if (model.find(':') == std::string_view::npos && model.size() + kLatest.size() <= sizeof(name)) {
+        std::memcpy(name, model.data(), model.size());
+        std::memcpy(name + model.size(), kLatest.data(), kLatest.size());
+        it = by_name_.find(std::string_view(name, model.size() + kLatest.size()));
+        if (it != by_name_.end()) {
+            return &it->second;
+        }
+    }
+
+    if (model.substr(0, 7) == "sha256:") {
+        model.remove_prefix(7);
+    }
+    it = by_digest_.find(model);
+    return it != by_digest_.end() ? &it->second : nullptr;
+}
+
+const ResidencyIndex::Host* ResidencyIndex::host(std::string_view name) const {
+    auto it = host_ids_.find(name);
+    return it != host_ids_.end() ? &hosts_[it->second] : nullptr;
+}
+
+void ResidencyIndex::query(std::string_view request, std::string& response) {
+    response.clear();
+    while (!request.empty() && (request.back() == '\n' || request.back() == '\r' || request.back() == ' ')) {
+        request.remove_suffix(1);
+    }
+    char verb = request.empty() ? '\0' : request[0];
+    std::string_view arg = request.size() > 2 && request[1] == ' ' ? request.substr(2) : std::string_view();
+
+    auto full = [&response] {
+        if (response.size() < kMaxResponse) {
+            return false;
+        }
+        response += "...\n";
+        return true;
+    };
+
+    switch (verb) {
+    case 'm': {
+        if (arg.empty()) {
+            response = "err usage: m <model>\n";
+            return;
+        }
+        const auto* residences = find(arg);
+        response += "ok ";
+        appendInt(response, residences ? static_cast<int64_t>(residences->size()) : 0);
+        response += '\n';
+        if (!residences) {
+            return;
+        }
+        for (const auto& residence : *residences) {
+            const Host& host = hosts_[residence.host];
+            response += host.name;
+            response += '\t';
+            appendInt(response, residence.vram_mb);
+            response += '\t';
+            appendInt(response, residence.expires_at);
+            response += '\t';
+            appendInt(response, host.free_mb);
+            response += '\n';
+            if (full()) {
+                return;
+            }
+        }
+        return;
+    }
+    case 'f': {
+        int64_t needed = 0;
+        auto result = std::from_chars(arg.data(), arg.data() + arg.size(), needed);
+        if (arg.empty() || result.ec != std::errc()) {
+            response = "err usage: f <mb>\n";
+            return;
+        }
+        ranked_.clear();
+        for (uint32_t id = 0; id < hosts_.size(); id++) {
+            if (hosts_[id].online && hosts_[id].free_mb >= needed) {
+                ranked_.emplace_back(hosts_[id].free_mb, id);
+            }
+        }
+        std::sort(ranked_.begin(), ranked_.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+        response += "ok ";
+        appendInt(response, static_cast<int64_t>(ranked_.size()));
+        response += '\n';
+        for (const auto& [free_mb, id] : ranked_) {
+            response += hosts_[id].name;
+            response += '\t';
+            appendInt(response, free_mb);
+            response += '\t';
+            appendInt(response, hosts_[id].total_mb);
+            response += '\n';
+            if (full()) {
+                return;
+            }
+        }
+        return;
+    }
+    case 'h': {
+        const Host* found = arg.empty() ? nullptr : host(arg);
+        if (!found) {
+            response = "err unknown host\n";
+            return;
+        }
+        response += "ok ";
+        appendInt(response, static_cast<int64_t>(found->models.size()) + 1);
+        response += '\n';
+        response += found->name;
+        response += '\t';
+        appendInt(response, found->free_mb);
+        response += '\t';
+        appendInt(response, found->total_mb);
+        response += found->online ? "\tup\n" : "\toffline\n";
+        for (const auto& model : found->models) {
+            response += model.name;
+            response += '\t';
+            response += model.digest.empty() ? "-" : model.digest;
+            response += '\t';
+            appendInt(response, model.vram_mb);
+            response += '\t';
+            appendInt(response, model.expires_at);
+            response += '\n';
+            if (full()) {
+                return;
+            }
+        }
+        return;
+    }
+    case 's': {
+        int64_t online = std::count_if(hosts_.begin(), hosts_.end(), [](const Host& h) { return h.online; });
+        response += "ok 1\n";
+        appendInt(response, static_cast<int64_t>(hosts_.size()));
+        response += '\t';
+        appendInt(response, online);
+        response += '\t';
+        appendInt(response, static_cast<int64_t>(by_name_.size()));
+        response += '\t';
+        appendInt(response, static_cast<int64_t>(updates_));
+        response += '\n';
+        return;
+    }
+    default:
+        response = "err unknown request\n";
+        return;
+    }
+}
+
+#ifdef __linux__
+
+ResidencyIndex::~ResidencyIndex() {
+    for (int fd : clients_) {
+        ::close(fd);
+    }
+    if (listen_fd_ >= 0) {
+        ::close(listen_fd_);
+        unlink(socket_path_.c_str());
+    }
+}
+
+bool ResidencyIndex::start(EventLoop& loop) {
+    struct sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    if (socket_path_.empty() || socket_path_.size() >= sizeof(addr.sun_path)) {
+        return false;
+    }
+    std::memcpy(addr.sun_path, socket_path_.c_str(), socket_path_.size() + 1);
+
+    // A socket left by an earlier run is replaced, unless something still
+    // answers on it; any other kind of file is left alone
+    struct stat st;
+    if (lstat(socket_path_.c_str(), &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            return false;
+        }
+        int probe = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+        bool live = probe >= 0 && connect(probe, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == 0;
+        if (probe >= 0) {
+            ::close(probe);
+        }
+        if (live) {
+            return false;
+        }
+        unlink(socket_path_.c_str());
+    }
+
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+    if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0 || listen(fd, 64) != 0) {
+        ::close(fd);
+        return false;
+    }
+    listen_fd_ = fd;
+    loop_ = &loop;
+    return loop.watchFd(listen_fd_, true, false, [this](bool, bool) { accept(); });
+}
+
+void ResidencyIndex::accept() {
+    for (;;) {
+        int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        if (clients_.size() >= kMaxClients) {
+            ::close(fd);
+            continue;
+        }
+        clients_.push_back(fd);
+        loop_->watchFd(fd, true, false, [this, fd](bool, bool) { onReadable(fd); });
+    }
+}
+
+// One request per message; routers keep the connection open between them
+void ResidencyIndex::onReadable(int fd) {
+    char buf[kMaxRequest];
+    for (;;) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            close(fd);
+            return;
+        }
+        if (n < 0) {
+            return;
+        }
+        query(std::string_view(buf, static_cast<size_t>(n)), response_);
+        // A client that doesn't read its answers is dropped, never queued for
+        if (send(fd, response_.data(), response_.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(response_.size())) {
+            close(fd);
+            return;
+        }
+    }
+}
+
+void ResidencyIndex::close(int fd) {
+    clients_.erase(std::remove(clients_.begin(), clients_.end(), fd), clients_.end());
+    loop_->unwatchFd(fd);
+    ::close(fd);
+}
+
+#else
+
+ResidencyIndex::~ResidencyIndex() {}
+
+bool ResidencyIndex::start(EventLoop& loop) {
+    (void)loop;
+    return false;
+}
+
+void ResidencyIndex::accept() {}
+void ResidencyIndex::onReadable(int) {}
+void ResidencyIndex::close(int) {}
+
+#endif // __linux__
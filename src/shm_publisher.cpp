@@ -0,0 +1,152 @@
+#include "../include/shm_publisher.h"
+#include "../include/platform.h"
+#include <algorithm>
+#include <chrono>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace ollama_monitor_shm;
+
+static void copyName(char* dest, size_t size, const std::string& src) {
+    size_t n = std::min(size - 1, src.size());
+    std::memcpy(dest, src.data(), n);
+    dest[n] = '\0';
+}
+
+// FNV-1a over every (name, digest) pair
+static uint64_t hashCatalog(const std::vector<OllamaModel>& models) {
+    uint64_t hash = 1469598103934665603ULL;
+    auto mix = [&hash](const std::string& s) {
+        for (unsigned char c : s) {
+            hash = (hash ^ c) * 1099511628211ULL;
+        }
+        hash = (hash ^ 0xff) * 1099511628211ULL;
+    };
+    for (const auto& model : models) {
+        mix(model.name);
+        mix(model.digest);
+    }
+    return hash;
+}
+
+ShmPublisher::ShmPublisher(const std::string& name) : name_(name) {
+#if defined(__unix__) || defined(__APPLE__)
+    int fd = shm_open(name_.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        return;
+    }
+    if (ftruncate(fd, sizeof(Segment)) != 0) {
+        close(fd);
+        return;
+    }
+    void* addr = mmap(nullptr, sizeof(Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return;
+    }
+
+    segment_ = static_cast<Segment*>(addr);
+    segment_->magic = kMagic;
+    segment_->version = kVersion;
+    segment_->size = sizeof(Segment);
+
+    // Keep the sequence even across restarts so readers never see a stale odd value
+    uint64_t seq = segment_->sequence.load(std::memory_order_relaxed);
+    segment_->sequence.store(seq & ~1ULL, std::memory_order_release);
+#endif
+}
+
+ShmPublisher::~ShmPublisher() {
+#if defined(__unix__) || defined(__APPLE__)
+    if (!segment_) {
+        return;
+    }
+
+    // Tell attached readers the data is no longer live, then remove the name
+    beginWrite();
+    segment_->snapshot.publisher_alive = 0;
+    endWrite();
+
+    munmap(segment_, sizeof(Segment));
+    shm_unlink(name_.c_str());
+#endif
+}
+
+void ShmPublisher::beginWrite() {
+    uint64_t seq = segment_->sequence.load(std::memory_order_relaxed);
+    segment_->sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void ShmPublisher::endWrite() {
+    uint64_t seq = segment_->sequence.load(std::memory_order_relaxed);
+    segment_->sequence.store(seq + 1, std::memory_order_release);
+}
+
+void ShmPublisher::publish(const DisplayInfo& info) {
+    if (!segment_) {
+        return;
+    }
+
+    uint64_t catalog_hash = hashCatalog(info.available_models);
+    if (catalog_hash != catalog_hash_) {
+        catalog_hash_ = catalog_hash;
+        catalog_version_++;
+    }
+
+    beginWrite();
+    Snapshot& snap = segment_->snapshot;
+
+    snap.collected_at_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+#if defined(__unix__) || defined(__APPLE__)
+    snap.publisher_pid = static_cast<int32_t>(getpid());
+#endif
+    snap.publisher_alive = 1;
+    snap.ollama_connected = info.ollama_status && !info.stale ? 1 : 0;
+    snap.catalog_model_count = static_cast<uint32_t>(info.available_models.size());
+    snap.catalog_version = catalog_version_;
+
+    const double gib = 1024.0 * 1024.0 * 1024.0;
+    uint32_t gpu_count = 0;
+    for (const auto& gpu : info.gpu_infos) {
+        if (!gpu.available || gpu_count >= static_cast<uint32_t>(kMaxGpus)) {
+            continue;
+        }
+        GpuRecord& rec = snap.gpus[gpu_count++];
+        copyName(rec.name, sizeof(rec.name), gpu.name);
+        rec.index = gpu.index;
+        rec.temperature_c = gpu.temperature_c;
+        rec.power_watts = gpu.power_watts;
+        rec.sm_clock_mhz = gpu.sm_clock_mhz;
+        rec.total_vram_bytes = static_cast<uint64_t>(gpu.total_vram_gb * gib);
+        rec.used_vram_bytes = static_cast<uint64_t>(gpu.used_vram_gb * gib);
+        rec.utilization_percent = static_cast<float>(gpu.utilization_percent);
+        rec.memory_util_percent = static_cast<float>(gpu.memory_util_percent);
+        rec.throttle_reasons = gpu.throttle_reasons;
+    }
+    snap.gpu_count = gpu_count;
+
+    uint32_t model_count = 0;
+    if (info.ollama_status) {
+        for (const auto& model : info.ollama_status->models) {
+            if (model_count >= static_cast<uint32_t>(kMaxModels)) {
+                break;
+            }
+            ModelRecord& rec = snap.models[model_count++];
+            copyName(rec.name, sizeof(rec.name), model.name);
+            copyName(rec.digest, sizeof(rec.digest), model.digest);
+            rec.size = model.size;
+            rec.size_vram = model.has_size_vram ? model.size_vram : model.size;
+            rec.context_length = model.context_length;
+            rec.expires_at = parseTimestamp(model.expires_at);
+        }
+    }
+    snap.model_count = model_count;
+
+    endWrite();
+}
@@ -0,0 +1,474 @@
+#include "../include/soak.h"
+#include "../include/profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+// Script periods in simulated seconds
+static const int64_t kCatalogPeriod = 1200;     // One model in, one out
+static const int64_t kLoadPeriod = 600;         // New loaded set
+static const int64_t kRestartPeriod = 6 * 3600;
+static const int64_t kRestartDown = 600;        // Connections reset
+static const int64_t kRestartCold = 300;        // Nothing loaded after
+static const int kChurnModels = 4;
+static const int64_t kWindow = kRestartPeriod;  // One full script cycle
+static const int kMalformedPercent = 3;
+
+#ifdef __linux__
+
+static const char* const kFamilies[] = {"llama", "qwen2", "gemma2", "mistral", "phi3"};
+
+// splitmix64: deterministic "randomness" from the simulated time
+static uint64_t mix(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+struct ScriptModel {
+    std::string name;
+    std::string family;
+    std::string digest;
+    int64_t size = 0;
+};
+
+static std::vector<ScriptModel> catalogAt(int64_t t) {
+    std::vector<ScriptModel> models = {
+        {"llama3.1:8b", "llama", std::string(64, 'a'), 4920753328},
+        {"qwen2.5:14b", "qwen2", std::string(64, 'b'), 8988124069},
+        {"nomic-embed-text:latest", "nomic-bert", std::string(64, 'c'), 274302450},
+    };
+    int64_t generation = t / kCatalogPeriod;
+    for (int64_t k = generation - kChurnModels + 1; k <= generation; k++) {
+        if (k < 0) {
+            continue;
+        }
+        uint64_t h = mix(static_cast<uint64_t>(k));
+        char digest[65];
+        std::snprintf(digest, sizeof(digest), "%016llx%016llx%016llx%016llx",
+                      static_cast<unsigned long long>(h), static_cast<unsigned long long>(mix(h)),
+                      static_cast<unsigned long long>(mix(h + 1)), static_cast<unsigned long long>(mix(h + 2)));
+        ScriptModel model;
+        model.family = kFamilies[k % 5];
+        model.name = model.family + ":soak-" + std::to_string(k);
+        model.digest = digest;
+        model.size = 500000000 + static_cast<int64_t>(h % 12000000000ULL);
+        models.push_back(std::move(model));
+    }
+    return models;
+}
+
+static std::string rfc3339(time_t when) {
+    struct tm utc;
+    gmtime_r(&when, &utc);
+    char buf[40];
+    std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S.000000Z", &utc);
+    return buf;
+}
+
+static std::string tagsJson(int64_t t) {
+    std::string out = "{\"models\":[";
+    bool first = true;
+    for (const auto& model : catalogAt(t)) {
+        out += first ? "" : ",";
+        first = false;
+        out += "{\"name\":\"" + model.name + "\",\"model\":\"" + model.name +
+               "\",\"modified_at\":\"2024-05-01T12:00:00Z\",\"size\":" + std::to_string(model.size) +
+               ",\"digest\":\"" + model.digest + "\",\"details\":{\"format\":\"gguf\",\"family\":\"" +
+               model.family + "\",\"parameter_size\":\"" + std::to_string(model.size / 600000000 + 1) +
+               "B\",\"quantization_level\":\"Q4_K_M\"}}";
+    }
+    return out + "]}";
+}
+
+static std::string psJson(int64_t t) {
+    std::string out = "{\"models\":[";
+    int64_t phase = t % kRestartPeriod;
+    if (t >= kRestartPeriod && phase < kRestartCold) {
+        return out + "]}";
+    }
+
+    // Expiry in wall-clock time so the UI shows sensible countdowns
+    auto catalog = catalogAt(t);
+    uint64_t h = mix(static_cast<uint64_t>(t / kLoadPeriod) ^ 0x10ad);
+    size_t count = 1 + static_cast<size_t>(t / kLoadPeriod % 3);
+    time_t expires = std::time(nullptr) + (kLoadPeriod - t % kLoadPeriod);
+    std::vector<size_t> picked;
+    for (size_t i = 0; i < count; i++) {
+        size_t index = mix(h + i) % catalog.size();
+        if (std::find(picked.begin(), picked.end(), index) != picked.end()) {
+            continue;
+        }
+        picked.push_back(index);
+        const auto& model = catalog[index];
+        int64_t context = 4096LL << (mix(h ^ index) % 4);
+        out += picked.size() > 1 ? "," : "";
+        out += "{\"name\":\"" + model.name + "\",\"model\":\"" + model.name +
+               "\",\"size\":" + std::to_string(model.size + model.size / 4) +
+               ",\"digest\":\"" + model.digest + "\",\"details\":{\"format\":\"gguf\",\"family\":\"" +
+               model.family + "\",\"quantization_level\":\"Q4_K_M\"},\"expires_at\":\"" +
+               rfc3339(expires) + "\",\"size_vram\":" + std::to_string(model.size) +
+               ",\"context_length\":" + std::to_string(context) + "}";
+    }
+    return out + "]}";
+}
+
+static std::string showJson(const std::string& request) {
+    // Family from the requested name, so metadata differs per model
+    std::string family = "llama";
+    size_t name = request.find("\"model\":\"");
+    if (name != std::string::npos) {
+        size_t start = name + 9;
+        size_t colon = request.find_first_of(":\"", start);
+        if (colon != std::string::npos) {
+            family = request.substr(start, colon - start);
+        }
+    }
+    uint64_t h = mix(std::hash<std::string>()(request));
+    std::string prefix = "\"" + family + ".";
+    return "{\"modelfile\":\"FROM x\",\"parameters\":\"stop x\",\"template\":\"{{ .Prompt }}\","
+           "\"details\":{\"format\":\"gguf\",\"family\":\"" + family + "\",\"parameter_size\":\"8.0B\","
+           "\"quantization_level\":\"Q4_K_M\"},\"model_info\":{\"general.architecture\":\"" + family + "\","
+           "\"general.parameter_count\":" + std::to_string(1000000000 + h % 30000000000ULL) + "," +
+           prefix + "attention.head_count\":32," + prefix + "attention.head_count_kv\":" +
+           std::to_string(4 << (h % 3)) + "," + prefix + "block_count\":" + std::to_string(24 + h % 40) + "," +
+           prefix + "context_length\":131072," + prefix + "embedding_length\":4096},"
+           "\"capabilities\":[\"completion\",\"tools\"],\"modified_at\":\"2024-05-01T12:00:00Z\"}";
+}
+
+// A well-formed body broken one of six ways
+static std::string malformedBody(const std::string& body, uint64_t h, int& status) {
+    switch (h % 6) {
+    case 0:
+        return body.substr(0, body.empty() ? 0 : h % body.size());
+    case 1:
+        status = 502;
+        return "<html><head><title>502 Bad Gateway</title></head><body>nginx</body></html>";
+    case 2:
+        return "";
+    case 3:
+        return "{\"models\":[{\"name\":42,\"model\":null,\"size\":\"big\",\"digest\":{\"a\":[1,2]},"
+               "\"expires_at\":\"yesterday\",\"size_vram\":-1,\"context_length\":1e400,\"details\":[]}],"
+               "\"version\":[],\"model_info\":\"\"}";
+    case 4:
+        return "{\"models\":[{\"name\":\"" + std::string(20000, 'x') + "\",\"digest\":\"" +
+               std::string(5000, '\\') + "\",\"size\":99999999999999999999999,\"details\":{\"family\":\"";
+    default: {
+        std::string garbage(4096, '\0');
+        for (size_t i = 0; i < garbage.size(); i++) {
+            garbage[i] = static_cast<char>(mix(h + i));
+        }
+        return std::string(512, '[') + garbage + "\"models\":\"\xff\xfe\"";
+    }
+    }
+}
+
+SoakServer::~SoakServer() {
+    stop_ = true;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (listen_fd_ >= 0) {
+        close(listen_fd_);
+    }
+}
+
+bool SoakServer::start() {
+    listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+        return false;
+    }
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    if (bind(listen_fd_, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        listen(listen_fd_, 16) != 0 ||
+        getsockname(listen_fd_, reinterpret_cast<struct sockaddr*>(&addr), &len) != 0) {
+        return false;
+    }
+    port_ = ntohs(addr.sin_port);
+    thread_ = std::thread([this] { serve(); });
+    return true;
+}
+
+std::string SoakServer::url() const {
+    return "http://127.0.0.1:" + std::to_string(port_);
+}
+
+void SoakServer::serve() {
+    while (!stop_) {
+        struct pollfd pfd = {listen_fd_, POLLIN, 0};
+        if (poll(&pfd, 1, 100) != 1) {
+            continue;
+        }
+        int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+
+        // "Restarting": reset instead of answering, like a closed port
+        if (now_ % kRestartPeriod >= kRestartPeriod - kRestartDown) {
+            struct linger reset = {1, 0};
+            setsockopt(fd, SOL_SOCKET, SO_LINGER, &reset, sizeof(reset));
+            close(fd);
+            refused_++;
+            continue;
+        }
+        handle(fd);
+        close(fd);
+    }
+}
+
+void SoakServer::handle(int fd) {
+    struct timeval timeout = {1, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    // Headers, then Content-Length bytes of body
+    std::string request;
+    char buf[4096];
+    size_t header_end = std::string::npos;
+    size_t want = 0;
+    for (;;) {
+        if (header_end == std::string::npos) {
+            header_end = request.find("\r\n\r\n");
+            if (header_end != std::string::npos) {
+                size_t length = request.find("Content-Length: ");
+                want = header_end + 4 +
+                       (length < header_end ? std::strtoul(request.c_str() + length + 16, nullptr, 10) : 0);
+            }
+        }
+        if (header_end != std::string::npos && request.size() >= want) {
+            break;
+        }
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) {
+            return;
+        }
+        request.append(buf, static_cast<size_t>(n));
+    }
+
+    size_t method_end = request.find(' ');
+    size_t path_end = request.find(' ', method_end + 1);
+    if (method_end == std::string::npos || path_end == std::string::npos) {
+        return;
+    }
+    int status = 200;
+    std::string body = respond(request.substr(0, method_end),
+                               request.substr(method_end + 1, path_end - method_end - 1),
+                               request.substr(header_end + 4), status);
+
+    std::string response = "HTTP/1.0 " + std::to_string(status) + (status == 200 ? " OK" : " Error") +
+                           "\r\nContent-Type: application/json\r\nContent-Length: " +
+                           std::to_string(body.size()) + "\r\n\r\n" + body;
+    size_t sent = 0;
+    while (sent < response.size()) {
+        ssize_t n = send(fd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return;
+        }
+        sent += static_cast<size_t>(n);
+    }
+}
+
+std::string SoakServer::respond(const std::string& method, const std::string& path, const std::string& body,
+                                int& status) {
+    int64_t t = now_;
+    uint64_t n = requests_++;
+
+    std::string out;
+    if (method == "GET" && path == "/api/version") {
+        out = "{\"version\":\"0.5." + std::to_string(t / kRestartPeriod) + "\"}";
+    } else if (method == "GET" && path == "/api/ps") {
+        out = psJson(t);
+    } else if (method == "GET" && path == "/api/tags") {
+        out = tagsJson(t);
+    } else if (method == "POST" && path == "/api/show") {
+        out = showJson(body);
+    } else if (method == "POST" && path == "/api/generate") {
+        out = "{\"model\":\"x\",\"done\":true,\"done_reason\":\"load\"}";
+    } else {
+        status = 404;
+        return "404 page not found";
+    }
+
+    uint64_t h = mix(n ^ 0x5eed);
+    if (h % 100 < static_cast<uint64_t>(kMalformedPercent)) {
+        malformed_++;
+        return malformedBody(out, mix(h), status);
+    }
+    return out;
+}
+
+#else
+
+SoakServer::~SoakServer() = default;
+
+bool SoakServer::start() {
+    return false;
+}
+
+std::string SoakServer::url() const {
+    return "";
+}
+
+void SoakServer::serve() {
+}
+
+void SoakServer::handle(int fd) {
+    (void)fd;
+}
+
+std::string SoakServer::respond(const std::string& method, const std::string& path, const std::string& body,
+                                int& status) {
+    (void)method;
+    (void)path;
+    (void)body;
+    (void)status;
+    return "";
+}
+
+#endif
+
+bool parseSoakLimits(const std::string& text, SoakLimits& limits, std::string& error) {
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t comma = text.find(',', pos);
+        std::string item = text.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+        pos = comma == std::string::npos ? text.size() : comma + 1;
+
+        size_t eq = item.find('=');
+        char* end = nullptr;
+        double value = eq == std::string::npos ? 0 : std::strtod(item.c_str() + eq + 1, &end);
+        if (eq == std::string::npos || end == item.c_str() + eq + 1 || *end != '\0' || value < 0) {
+            error = "Invalid soak limit '" + item + "' (expected rss=<mb>, allocs=<pct> or cpu=<pct>)";
+            return false;
+        }
+        std::string key = item.substr(0, eq);
+        if (key == "rss") {
+            limits.rss_mb = value;
+        } else if (key == "allocs") {
+            limits.allocs_pct = value;
+        } else if (key == "cpu") {
+            limits.cpu_pct = value;
+        } else {
+            error = "Unknown soak limit '" + key + "'";
+            return false;
+        }
+    }
+    return true;
+}
+
+static double rssMegabytes() {
+#ifdef __linux__
+    long pages = 0;
+    long resident = 0;
+    if (FILE* statm = std::fopen("/proc/self/statm", "r")) {
+        if (std::fscanf(statm, "%ld %ld", &pages, &resident) != 2) {
+            resident = 0;
+        }
+        std::fclose(statm);
+    }
+    return static_cast<double>(resident) * static_cast<double>(sysconf(_SC_PAGESIZE)) / (1024.0 * 1024.0);
+#else
+    return 0;
+#endif
+}
+
+static int64_t threadCpuNanoseconds() {
+#ifdef __linux__
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#else
+    return 0;
+#endif
+}
+
+static double growthPercent(double value, double baseline) {
+    return baseline > 0 ? (value - baseline) * 100.0 / baseline : 0;
+}
+
+SoakMonitor::SoakMonitor(const SoakLimits& limits, int64_t duration_seconds)
+    : limits_(limits), duration_(duration_seconds), next_window_(kWindow) {
+    window_cpu_ns_.reserve(4096);
+}
+
+void SoakMonitor::begin() {
+    start_allocs_ = profiler::allocationCount();
+    start_cpu_ns_ = threadCpuNanoseconds();
+}
+
+bool SoakMonitor::end(int64_t simulated_seconds, const SoakServer& server) {
+    window_cpu_ns_.push_back(threadCpuNanoseconds() - start_cpu_ns_);
+    window_allocs_ += profiler::allocationCount() - start_allocs_;
+
+    if (simulated_seconds >= next_window_) {
+        closeWindow(simulated_seconds, server);
+        next_window_ += kWindow;
+    }
+    return passed() && simulated_seconds < duration_;
+}
+
+void SoakMonitor::closeWindow(int64_t simulated_seconds, const SoakServer& server) {
+    Window window;
+    window.rss_mb = rssMegabytes();
+    if (!window_cpu_ns_.empty()) {
+        window.allocs = static_cast<double>(window_allocs_) / static_cast<double>(window_cpu_ns_.size());
+        auto middle = window_cpu_ns_.begin() + static_cast<std::ptrdiff_t>(window_cpu_ns_.size() / 2);
+        std::nth_element(window_cpu_ns_.begin(), middle, window_cpu_ns_.end());
+        window.cpu_us = static_cast<double>(*middle) / 1000.0;
+    }
+    window_allocs_ = 0;
+    window_cpu_ns_.clear();
+
+    // The first cycle fills caches; the second is the baseline
+    windows_++;
+    if (windows_ == 2) {
+        baseline_ = window;
+        have_baseline_ = true;
+    }
+
+    char line[256];
+    std::snprintf(line, sizeof(line),
+                  "%5lldh  rss %6.1f MB (%+.1f)  allocs/refresh %7.0f (%+.1f%%)  cpu/refresh %6.0f us (%+.0f%%)"
+                  "  requests %llu, %llu malformed, %llu reset\n",
+                  static_cast<long long>(simulated_seconds / 3600), window.rss_mb,
+                  have_baseline_ ? window.rss_mb - baseline_.rss_mb : 0.0, window.allocs,
+                  have_baseline_ ? growthPercent(window.allocs, baseline_.allocs) : 0.0, window.cpu_us,
+                  have_baseline_ ? growthPercent(window.cpu_us, baseline_.cpu_us) : 0.0,
+                  static_cast<unsigned long long>(server.requests()),
+                  static_cast<unsigned long long>(server.malformed()),
+                  static_cast<unsigned long long>(server.refused()));
+    std::cerr << line;
+
+    if (!have_baseline_ || windows_ == 2) {
+        return;
+    }
+    if (window.rss_mb - baseline_.rss_mb > limits_.rss_mb) {
+        std::snprintf(line, sizeof(line), "RSS grew %.1f MB over the baseline (limit %.1f)",
+                      window.rss_mb - baseline_.rss_mb, limits_.rss_mb);
+        failure_ = line;
+    } else if (growthPercent(window.allocs, baseline_.allocs) > limits_.allocs_pct) {
+        std::snprintf(line, sizeof(line), "allocations per refresh grew %.1f%% (limit %.1f%%)",
+                      growthPercent(window.allocs, baseline_.allocs), limits_.allocs_pct);
+        failure_ = line;
+    } else if (growthPercent(window.cpu_us, baseline_.cpu_us) > limits_.cpu_pct) {
+        std::snprintf(line, sizeof(line), "CPU time per refresh grew %.0f%% (limit %.0f%%)",
+                      growthPercent(window.cpu_us, baseline_.cpu_us), limits_.cpu_pct);
+        failure_ = line;
+    }
+}
@@ -0,0 +1,521 @@
+#include "../include/sse_server.h"
+#include "../include/console_ui.h"
+#include "../include/platform.h"
+#include <cstdio>
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+// Events a subscriber may lag before its backlog collapses into a snapshot
+static const size_t kMaxQueued = 8;
+// Idle streams get a comment line so proxies don't time them out
+static const std::chrono::seconds kHeartbeat(15);
+static const size_t kMaxRequest = 8192;
+
+// Flat keys are group, entity id and field joined by this separator
+static const char kSep = '\x1f';
+
+static std::string key(std::string_view group, std::string_view id, std::string_view field) {
+    std::string result;
+    result.reserve(group.size() + id.size() + field.size() + 2);
+    result.append(group);
+    result += kSep;
+    result.append(id);
+    result += kSep;
+    result.append(field);
+    return result;
+}
+
+static void appendJsonString(std::string& out, std::string_view text) {
+    static const char kHex[] = "0123456789abcdef";
+    out += '"';
+    for (char c : text) {
+        unsigned char u = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (u < 0x20) {
+            out += "\\u00";
+            out += kHex[u >> 4];
+            out += kHex[u & 0xf];
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+static std::string jsonString(std::string_view text) {
+    std::string out;
+    appendJsonString(out, text);
+    return out;
+}
+
+// Rounded so sensor noise below display precision doesn't produce deltas
+static std::string jsonNumber(double value, int decimals) {
+    char buf[32];
+    int n = snprintf(buf, sizeof(buf), "%.*f", decimals, value);
+    if (n <= 0 || static_cast<size_t>(n) >= sizeof(buf)) {
+        return "0";
+    }
+    std::string_view text(buf, static_cast<size_t>(n));
+    if (text.find('.') != std::string_view::npos) {
+        while (text.back() == '0') {
+            text.remove_suffix(1);
+        }
+        if (text.back() == '.') {
+            text.remove_suffix(1);
+        }
+    }
+    return text == "-0" ? "0" : std::string(text);
+}
+
+static const char* jsonBool(bool value) {
+    return value ? "true" : "false";
+}
+
+static void flattenGpus(const std::vector<GPUInfo>& gpus, std::map<std::string, std::string>& fields) {
+    for (const auto& gpu : gpus) {
+        if (!gpu.available) {
+            continue;
+        }
+        std::string id = std::to_string(gpu.index);
+        auto set = [&](std::string_view field, std::string value) {
+            fields.emplace(key("gpus", id, field), std::move(value));
+        };
+        set("name", jsonString(gpu.name));
+        set("total_vram_gb", jsonNumber(gpu.total_vram_gb, 2));
+        set("used_vram_gb", jsonNumber(gpu.used_vram_gb, 2));
+        set("utilization_percent", jsonNumber(gpu.utilization_percent, 0));
+        set("temperature_c", std::to_string(gpu.temperature_c));
+        set("power_watts", std::to_string(gpu.power_watts));
+        if (gpu.has_extended_metrics) {
+            set("memory_util_percent", jsonNumber(gpu.memory_util_percent, 0));
+            set("sm_clock_mhz", std::to_string(gpu.sm_clock_mhz));
+            set("mem_clock_mhz", std::to_string(gpu.mem_clock_mhz));
+            set("throttle_reasons", std::to_string(gpu.throttle_reasons));
+            set("pcie_rx_mb_s", jsonNumber(gpu.pcie_rx_mb_s, 1));
+            set("pcie_tx_mb_s", jsonNumber(gpu.pcie_tx_mb_s, 1));
+            set("ecc_corrected", std::to_string(gpu.ecc_corrected));
+            set("ecc_uncorrected", std::to_string(gpu.ecc_uncorrected));
+            set("xid_errors", std::to_string(gpu.xid_errors));
+        }
+    }
+}
+
+// Writes ,"group":{"id":{"field":value,...},...},... for sorted flat keys.
+// A field with an empty id sits directly in its group.
+static void appendGrouped(std::string& out, const std::map<std::string, std::string>& fields) {
+    std::string_view group;
+    std::string_view id;
+    bool in_group = false;
+    bool in_id = false;
+    bool first = true;  // First member of the innermost open object
+
+    for (const auto& [flat, value] : fields) {
+        std::string_view rest = flat;
+        size_t a = rest.find(kSep);
+        size_t b = rest.find(kSep, a + 1);
+        std::string_view g = rest.substr(0, a);
+        std::string_view i = rest.substr(a + 1, b - a - 1);
+        std::string_view f = rest.substr(b + 1);
+
+        if (!in_group || g != group) {
+            if (in_id) {
+                out += '}';
+            }
+            if (in_group) {
+                out += '}';
+            }
+            out += ',';
+            appendJsonString(out, g);
+            out += ":{";
+            group = g;
+            in_group = true;
+            in_id = false;
+            first = true;
+        }
+        if (!i.empty() && (!in_id || i != id)) {
+            if (in_id) {
+                out += '}';
+                first = false;
+            }
+            if (!first) {
+                out += ',';
+            }
+            appendJsonString(out, i);
+            out += ":{";
+            id = i;
+            in_id = true;
+            first = true;
+        }
+        if (!first) {
+            out += ',';
+        }
+        appendJsonString(out, f);
+        out += ':';
+        out += value;
+        first = false;
+    }
+    if (in_id) {
+        out += '}';
+    }
+    if (in_group) {
+        out += '}';
+    }
+}
+
+SseServer::SseServer(int port, size_t max_clients)
+    : port_(port), max_clients_(max_clients), last_event_(std::chrono::steady_clock::now()) {}
+
+void SseServer::publish(const DisplayInfo& info) {
+    Fields next;
+    flattenGpus(info.gpu_infos, next);
+
+    if (info.ollama_status) {
+        for (const auto& model : info.ollama_status->models) {
+            auto set = [&](std::string_view field, std::string value) {
+                next.emplace(key("models", model.name, field), std::move(value));
+            };
+            set("model", jsonString(model.model));
+            set("digest", jsonString(model.digest));
+            set("size", std::to_string(model.size));
+            if (model.has_size_vram) {
+                set("size_vram", std::to_string(model.size_vram));
+            }
+            set("gpu_percent", jsonNumber(model.getGPUPercent(), 0));
+            set("context_length", std::to_string(model.context_length));
+            set("expires_at", jsonString(model.expires_at));
+            set("parameter_size", jsonString(model.details.parameter_size));
+            set("quantization_level", jsonString(model.details.quantization_level));
+        }
+    }
+
+    // Keeper decisions and the latest action per model (--keep)
+    for (const auto& model : info.keeper.models) {
+        next.emplace(key("keeper", model.name, "state"), jsonString(keepStateName(model.state)));
+    }
+    for (const auto& action : info.keeper.recent) {
+        next.insert_or_assign(key("keeper", action.model, "last_action"), jsonString(action.text));
+        next.insert_or_assign(key("keeper", action.model, "last_action_ok"), jsonBool(action.ok));
+        next.insert_or_assign(key("keeper", action.model, "last_action_at"), std::to_string(action.time));
+    }
+
+    next.emplace(key("ollama", "", "connected"), jsonBool(info.ollama_status && !info.stale));
+    next.emplace(key("ollama", "", "stale"), jsonBool(info.stale));
+    next.emplace(key("ollama", "", "installed_models"), std::to_string(info.available_models.size()));
+
+    update(next, {"gpus", "keeper", "models", "ollama"});
+}
+
+void SseServer::publishGpus(const std::vector<GPUInfo>& gpus) {
+    Fields next;
+    flattenGpus(gpus, next);
+    update(next, {"gpus"});
+}
+
+void SseServer::update(Fields& next, std::initializer_list<std::string_view> groups) {
+    Fields changed;
+    std::map<std::string, std::vector<std::string>> removed;  // Group -> entity ids
+
+    for (const auto& [flat, value] : next) {
+        auto it = state_.find(flat);
+        if (it == state_.end() || it->second != value) {
+            changed.emplace(flat, value);
+        }
+    }
+    for (std::string_view group : groups) {
+        std::string prefix = std::string(group) + kSep;
+        auto begin = state_.lower_bound(prefix);
+        auto end = begin;
+        while (end != state_.end() && end->first.compare(0, prefix.size(), prefix) == 0) {
+            if (!next.count(end->first)) {
+                // Whole entity gone, or just one field of a live one
+                std::string_view rest = std::string_view(end->first).substr(prefix.size());
+                std::string id(rest.substr(0, rest.find(kSep)));
+                auto live = next.lower_bound(prefix + id + kSep);
+                if (live != next.end() && live->first.compare(0, prefix.size() + id.size() + 1,
+                                                              prefix + id + kSep) == 0) {
+                    changed.emplace(end->first, "null");
+                } else if (removed[std::string(group)].empty() || removed[std::string(group)].back() != id) {
+                    removed[std::string(group)].push_back(std::move(id));
+                }
+            }
+            ++end;
+        }
+        state_.erase(begin, end);
+    }
+    state_.merge(next);
+
+    auto now = std::chrono::steady_clock::now();
+    if (changed.empty() && removed.empty()) {
+        if (now - last_event_ >= kHeartbeat) {
+            static const Buffer kPing = std::make_shared<const std::string>(":\n\n");
+            last_event_ = now;
+            broadcast(kPing);
+        }
+        return;
+    }
+
+    seq_++;
+    snapshot_.reset();
+    last_event_ = now;
+    if (clients_.empty()) {
+        return;
+    }
+
+    std::string event = "event: delta\nid: " + std::to_string(seq_) + "\ndata: {\"seq\":" + std::to_string(seq_);
+    appendGrouped(event, changed);
+    if (!removed.empty()) {
+        event += ",\"removed\":{";
+        bool first_group = true;
+        for (const auto& [group, ids] : removed) {
+            if (!first_group) {
+                event += ',';
+            }
+            first_group = false;
+            appendJsonString(event, group);
+            event += ":[";
+            for (size_t i = 0; i < ids.size(); i++) {
+                if (i > 0) {
+                    event += ',';
+                }
+                appendJsonString(event, ids[i]);
+            }
+            event += ']';
+        }
+        event += '}';
+    }
+    event += "}\n\n";
+    broadcast(std::make_shared<const std::string>(std::move(event)));
+}
+
+std::string SseServer::snapshotJson() const {
+    std::string json = "{\"seq\":" + std::to_string(seq_);
+    appendGrouped(json, state_);
+    json += '}';
+    return json;
+}
+
+SseServer::Buffer SseServer::snapshotEvent() {
+    if (!snapshot_) {
+        snapshot_ = std::make_shared<const std::string>(
+            "event: snapshot\nid: " + std::to_string(seq_) + "\ndata: " + snapshotJson() + "\n\n");
+    }
+    return snapshot_;
+}
+
+size_t SseServer::subscriberCount() const {
+    size_t count = 0;
+    for (const auto& [fd, client] : clients_) {
+        if (client.streaming) {
+            count++;
+        }
+    }
+    return count;
+}
+
+#ifdef __linux__
+
+SseServer::~SseServer() {
+    for (auto& [fd, client] : clients_) {
+        ::close(fd);
+    }
+    if (listen_fd_ >= 0) {
+        ::close(listen_fd_);
+    }
+}
+
+bool SseServer::start(EventLoop& loop) {
+    listen_fd_ = listenTcp(port_);
+    if (listen_fd_ < 0) {
+        return false;
+    }
+
+    loop_ = &loop;
+    return loop.watchFd(listen_fd_, true, false, [this](bool, bool) { accept(); });
+}
+
+void SseServer::accept() {
+    for (;;) {
+        int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        if (clients_.size() >= max_clients_) {
+            ::close(fd);
+            continue;
+        }
+        clients_[fd];
+        loop_->watchFd(fd, true, false, [this, fd](bool readable, bool writable) {
+            onEvent(fd, readable, writable);
+        });
+    }
+}
+
+void SseServer::onEvent(int fd, bool readable, bool writable) {
+    auto it = clients_.find(fd);
+    if (it == clients_.end()) {
+        return;
+    }
+    Client& client = it->second;
+
+    if (readable) {
+        char buf[4096];
+        for (;;) {
+            ssize_t n = recv(fd, buf, sizeof(buf), 0);
+            if (n > 0) {
+                // Streams don't read anything after the request
+                if (!client.streaming && !client.close_after) {
+                    client.request.append(buf, static_cast<size_t>(n));
+                }
+                continue;
+            }
+            if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                close(fd);
+                return;
+            }
+            break;
+        }
+        if (!client.streaming && !client.close_after) {
+            if (client.request.find("\r\n\r\n") != std::string::npos) {
+                handleRequest(fd, client);
+                return;
+            }
+            if (client.request.size() > kMaxRequest) {
+                close(fd);
+                return;
+            }
+        }
+    }
+    if (writable) {
+        flush(fd, client);
+    }
+}
+
+void SseServer::handleRequest(int fd, Client& client) {
+    std::string_view line = std::string_view(client.request).substr(0, client.request.find("\r\n"));
+    std::string_view method = line.substr(0, line.find(' '));
+    std::string_view path;
+    if (method.size() < line.size()) {
+        path = line.substr(method.size() + 1);
+        path = path.substr(0, path.find(' '));
+        path = path.substr(0, path.find('?'));
+    }
+
+    auto respond = [&](const char* status, const char* type, const std::string& body) {
+        client.close_after = true;
+        enqueue(fd, client, std::make_shared<const std::string>(
+            std::string("HTTP/1.1 ") + status + "\r\nContent-Type: " + type +
+            "\r\nContent-Length: " + std::to_string(body.size()) +
+            "\r\nAccess-Control-Allow-Origin: *\r\nConnection: close\r\n\r\n" + body));
+    };
+
+    if (method != "GET") {
+        respond("405 Method Not Allowed", "text/plain", "GET only\n");
+    } else if (path == "/events") {
+        static const Buffer kHeaders = std::make_shared<const std::string>(
+            "HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\nCache-Control: no-cache\r\n"
+            "Access-Control-Allow-Origin: *\r\nConnection: keep-alive\r\n\r\nretry: 2000\n\n");
+        client.streaming = true;
+        client.request.clear();
+        client.request.shrink_to_fit();
+        client.queue.push_back(kHeaders);
+        client.queue.push_back(snapshotEvent());
+        flush(fd, client);
+    } else if (path == "/snapshot") {
+        respond("200 OK", "application/json", snapshotJson() + "\n");
+    } else {
+        respond("404 Not Found", "text/plain", "Try /events or /snapshot\n");
+    }
+}
+
+void SseServer::broadcast(const Buffer& buffer) {
+    // flush() may close clients; collect the fds first
+    std::vector<int> fds;
+    fds.reserve(clients_.size());
+    for (const auto& [fd, client] : clients_) {
+        if (client.streaming) {
+            fds.push_back(fd);
+        }
+    }
+    for (int fd : fds) {
+        auto it = clients_.find(fd);
+        if (it == clients_.end()) {
+            continue;
+        }
+        Client& client = it->second;
+        if (client.queue.size() >= kMaxQueued) {
+            // Coalesce: the snapshot already includes this event. A partly
+            // sent event has to finish first or the stream would be corrupt.
+            Buffer partial = client.offset > 0 ? client.queue.front() : nullptr;
+            client.queue.clear();
+            if (partial) {
+                client.queue.push_back(std::move(partial));
+            }
+            enqueue(fd, client, snapshotEvent());
+        } else {
+            enqueue(fd, client, buffer);
+        }
+    }
+}
+
+void SseServer::enqueue(int fd, Client& client, const Buffer& buffer) {
+    client.queue.push_back(buffer);
+    if (client.queue.size() == 1) {
+        flush(fd, client);
+    }
+}
+
+void SseServer::flush(int fd, Client& client) {
+    while (!client.queue.empty()) {
+        const std::string& front = *client.queue.front();
+        ssize_t n = send(fd, front.data() + client.offset, front.size() - client.offset, MSG_NOSIGNAL);
+        if (n > 0) {
+            client.offset += static_cast<size_t>(n);
+            if (client.offset == front.size()) {
+                client.queue.pop_front();
+                client.offset = 0;
+            }
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        close(fd);
+        return;
+    }
+    if (client.queue.empty() && client.close_after) {
+        close(fd);
+        return;
+    }
+    loop_->updateFd(fd, true, !client.queue.empty());
+}
+
+void SseServer::close(int fd) {
+    clients_.erase(fd);
+    loop_->unwatchFd(fd);
+    ::close(fd);
+}
+
+#else
+
+SseServer::~SseServer() {}
+
+bool SseServer::start(EventLoop& loop) {
+    (void)loop;
+    return false;
+}
+
+void SseServer::accept() {}
+void SseServer::onEvent(int, bool, bool) {}
+void SseServer::handleRequest(int, Client&) {}
+void SseServer::broadcast(const Buffer&) {}
+void SseServer::enqueue(int, Client&, const Buffer&) {}
+void SseServer::flush(int, Client&) {}
+void SseServer::close(int) {}
+
+#endif // __linux__
@@ -0,0 +1,116 @@
+#include "../include/state_cache.h"
+#include "../include/platform.h"
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+// Refresh the saved timestamp at least this often while the state is unchanged
+static const int64_t kResaveSeconds = 60;
+
+static int64_t unixNow() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+StateCache::StateCache(const std::string& path) : path_(path) {
+    load();
+}
+
+// saved\t<unix time>
+// running\tname\tmodel\tdigest\texpires_at\tparameter_size\tquantization\tsize size_vram has_size_vram context
+// model\tname\tmodel\tdigest\tmodified_at\tsize
+std::string StateCache::serialize() const {
+    std::ostringstream out;
+    for (const auto& m : status_.models) {
+        out << "running\t" << m.name << '\t' << m.model << '\t' << m.digest << '\t' << m.expires_at << '\t'
+            << m.details.parameter_size << '\t' << m.details.quantization_level << '\t'
+            << m.size << ' ' << m.size_vram << ' ' << (m.has_size_vram ? 1 : 0) << ' ' << m.context_length << '\n';
+    }
+    for (const auto& m : models_) {
+        out << "model\t" << m.name << '\t' << m.model << '\t' << m.digest << '\t' << m.modified_at << '\t'
+            << m.size << '\n';
+    }
+    return out.str();
+}
+
+void StateCache::load() {
+    if (path_.empty()) {
+        return;
+    }
+    std::ifstream in(path_);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string kind;
+        if (!std::getline(fields, kind, '\t')) {
+            continue;
+        }
+
+        if (kind == "saved") {
+            fields >> saved_at_;
+        } else if (kind == "running") {
+            OllamaRunningModel m;
+            int has_size_vram = 0;
+            if (!std::getline(fields, m.name, '\t') || !std::getline(fields, m.model, '\t') ||
+                !std::getline(fields, m.digest, '\t') || !std::getline(fields, m.expires_at, '\t') ||
+                !std::getline(fields, m.details.parameter_size, '\t') ||
+                !std::getline(fields, m.details.quantization_level, '\t')) {
+                continue;
+            }
+            fields >> m.size >> m.size_vram >> has_size_vram >> m.context_length;
+            if (!fields) {
+                continue;
+            }
+            m.has_size_vram = has_size_vram != 0;
+            status_.models.push_back(m);
+        } else if (kind == "model") {
+            OllamaModel m;
+            if (!std::getline(fields, m.name, '\t') || !std::getline(fields, m.model, '\t') ||
+                !std::getline(fields, m.digest, '\t') || !std::getline(fields, m.modified_at, '\t')) {
+                continue;
+            }
+            fields >> m.size;
+            if (!fields) {
+                continue;
+            }
+            models_.push_back(m);
+        }
+    }
+
+    updated_at_ = saved_at_;
+    has_state_ = saved_at_ > 0;
+    if (has_state_) {
+        serialized_ = serialize();
+    }
+}
+
+void StateCache::update(const OllamaStatus& status, const std::vector<OllamaModel>& models) {
+    status_ = status;
+    models_ = models;
+    has_state_ = true;
+
+    int64_t now = unixNow();
+    updated_at_ = now;
+    std::string body = serialize();
+    bool changed = body != serialized_;
+    if (!changed && now - saved_at_ < kResaveSeconds) {
+        return;
+    }
+    saved_at_ = now;
+    serialized_ = std::move(body);
+    if (path_.empty()) {
+        return;
+    }
+
+    writeFileAtomically(path_, "saved\t" + std::to_string(saved_at_) + '\n' + serialized_);
+}
+
+void StateCache::restore(DisplayInfo& info) const {
+    if (!has_state_) {
+        return;
+    }
+    info.ollama_status = std::make_unique<OllamaStatus>(status_);
+    info.available_models = models_;
+    info.stale = true;
+    info.stale_since = updated_at_;
+}
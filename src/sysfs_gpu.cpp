@@ -0,0 +1,238 @@
+#include "../include/sysfs_gpu.h"
+#include <algorithm>
+#include <charconv>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+
+static int openMetric(const std::string& path) {
+    return open(path.c_str(), O_RDONLY | O_CLOEXEC);
+}
+
+// Re-read a sysfs attribute from offset 0 into a stack buffer
+static bool readMetric(int fd, uint64_t& value) {
+    if (fd < 0) {
+        return false;
+    }
+    char buf[64];
+    ssize_t n = pread(fd, buf, sizeof(buf), 0);
+    if (n <= 0) {
+        return false;
+    }
+    const char* begin = buf;
+    const char* end = buf + n;
+    while (begin < end && (*begin == ' ' || *begin == '\t')) {
+        begin++;
+    }
+    auto result = std::from_chars(begin, end, value);
+    return result.ec == std::errc();
+}
+
+// Read a small text file once (used only during discovery)
+static std::string readText(const std::string& path) {
+    int fd = openMetric(path);
+    if (fd < 0) {
+        return "";
+    }
+    std::string text;
+    char buf[512];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+        text.append(buf, static_cast<size_t>(n));
+    }
+    close(fd);
+    while (!text.empty() && (text.back() == '\n' || text.back() == ' ')) {
+        text.pop_back();
+    }
+    return text;
+}
+
+static std::vector<std::string> listDirectory(const std::string& path) {
+    std::vector<std::string> entries;
+    DIR* dir = opendir(path.c_str());
+    if (!dir) {
+        return entries;
+    }
+    while (struct dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name != "." && name != "..") {
+            entries.push_back(name);
+        }
+    }
+    closedir(dir);
+    std::sort(entries.begin(), entries.end());
+    return entries;
+}
+
+// Look up KEY=value in a uevent file
+static std::string ueventValue(const std::string& uevent, const std::string& key) {
+    std::string search = key + "=";
+    size_t pos = 0;
+    while (pos < uevent.size()) {
+        size_t end = uevent.find('\n', pos);
+        if (end == std::string::npos) {
+            end = uevent.size();
+        }
+        if (uevent.compare(pos, search.size(), search) == 0) {
+            return uevent.substr(pos + search.size(), end - pos - search.size());
+        }
+        pos = end + 1;
+    }
+    return "";
+}
+
+#endif // __linux__
+
+SysfsGPUBackend::SysfsGPUBackend(const std::string& root) : root_(root) {
+    // Normalize so paths can be built as root_ + "sys/..."
+    if (root_.empty() || root_.back() != '/') {
+        root_ += '/';
+    }
+}
+
+SysfsGPUBackend::~SysfsGPUBackend() {
+    for (auto& device : devices_) {
+        closeDevice(device);
+    }
+}
+
+void SysfsGPUBackend::closeDevice(Device& device) {
+#ifdef __linux__
+    for (int* fd : {&device.vram_total_fd, &device.vram_used_fd, &device.busy_fd,
+                    &device.mem_busy_fd, &device.temp_fd, &device.power_fd, &device.energy_fd}) {
+        if (*fd >= 0) {
+            close(*fd);
+            *fd = -1;
+        }
+    }
+#else
+    (void)device;
+#endif
+}
+
+bool SysfsGPUBackend::discover() {
+#ifdef __linux__
+    for (auto& device : devices_) {
+        closeDevice(device);
+    }
+    devices_.clear();
+
+    std::string drm_dir = root_ + "sys/class/drm";
+    for (const auto& card : listDirectory(drm_dir)) {
+        // Only primary nodes (card0, card1...) - skip connectors like card0-DP-1
+        if (card.compare(0, 4, "card") != 0 || card.find('-') != std::string::npos) {
+            continue;
+        }
+
+        std::string device_dir = drm_dir + "/" + card + "/device";
+        std::string uevent = readText(device_dir + "/uevent");
+        std::string driver = ueventValue(uevent, "DRIVER");
+        if (driver != "amdgpu" && driver != "i915" && driver != "xe") {
+            continue;
+        }
+
+        Device device;
+        device.driver = driver;
+        device.pci_slot = ueventValue(uevent, "PCI_SLOT_NAME");
+
+        device.name = readText(device_dir + "/product_name");
+        if (device.name.empty()) {
+            std::string pci_id = ueventValue(uevent, "PCI_ID");
+            device.name = std::string(driver == "amdgpu" ? "AMD Radeon GPU" : "Intel GPU") +
+                          (pci_id.empty() ? "" : " (" + pci_id + ")");
+        }
+
+        // amdgpu exposes VRAM and busy counters directly on the PCI device
+        device.vram_total_fd = openMetric(device_dir + "/mem_info_vram_total");
+        device.vram_used_fd = openMetric(device_dir + "/mem_info_vram_used");
+        device.busy_fd = openMetric(device_dir + "/gpu_busy_percent");
+        device.mem_busy_fd = openMetric(device_dir + "/mem_busy_percent");
+
+        // Temperature and power live under the first hwmon instance
+        auto hwmons = listDirectory(device_dir + "/hwmon");
+        if (!hwmons.empty()) {
+            std::string hwmon_dir = device_dir + "/hwmon/" + hwmons.front();
+            device.temp_fd = openMetric(hwmon_dir + "/temp1_input");
+            device.power_fd = openMetric(hwmon_dir + "/power1_average");
+            if (device.power_fd < 0) {
+                device.power_fd = openMetric(hwmon_dir + "/power1_input");
+            }
+            if (device.power_fd < 0) {
+                // i915/xe discrete cards only publish a cumulative energy counter
+                device.energy_fd = openMetric(hwmon_dir + "/energy1_input");
+            }
+        }
+
+        devices_.push_back(std::move(device));
+    }
+
+    return !devices_.empty();
+#else
+    return false;
+#endif
+}
+
+void SysfsGPUBackend::sample(std::vector<GPUInfo>& infos, int first_index) {
+#ifdef __linux__
+    int index = first_index;
+    for (auto& device : devices_) {
+        GPUInfo info;
+        info.available = true;
+        info.index = index++;
+        info.name = device.name;
+
+        uint64_t value = 0;
+        if (readMetric(device.vram_total_fd, value)) {
+            info.total_vram_gb = static_cast<double>(value) / (1024.0 * 1024.0 * 1024.0);
+        }
+        if (readMetric(device.vram_used_fd, value)) {
+            info.used_vram_gb = static_cast<double>(value) / (1024.0 * 1024.0 * 1024.0);
+        }
+        info.free_vram_gb = std::max(0.0, info.total_vram_gb - info.used_vram_gb);
+        // i915/xe iGPUs have no mem_info_vram_* files: they borrow system RAM
+        info.shared_memory = device.vram_total_fd < 0;
+
+        if (readMetric(device.busy_fd, value)) {
+            info.utilization_percent = static_cast<double>(value);
+        }
+        if (readMetric(device.mem_busy_fd, value)) {
+            info.memory_util_percent = static_cast<double>(value);
+        }
+
+        // hwmon reports millidegrees and microwatts
+        if (readMetric(device.temp_fd, value)) {
+            info.temperature_c = static_cast<int>(value / 1000);
+        }
+        if (readMetric(device.power_fd, value)) {
+            info.power_watts = static_cast<int>(value / 1000000);
+            info.power_milliwatts = static_cast<int>(value / 1000);
+            info.power_sampled_at = std::chrono::steady_clock::now();
+        } else if (readMetric(device.energy_fd, value)) {
+            auto now = std::chrono::steady_clock::now();
+            if (device.last_energy_at != std::chrono::steady_clock::time_point{} && value >= device.last_energy_uj) {
+                double seconds = std::chrono::duration<double>(now - device.last_energy_at).count();
+                if (seconds > 0) {
+                    device.derived_power_mw = static_cast<int>((value - device.last_energy_uj) / 1e3 / seconds);
+                }
+            }
+            device.last_energy_uj = value;
+            device.last_energy_at = now;
+            info.power_watts = device.derived_power_mw / 1000;
+            if (device.derived_power_mw > 0) {
+                info.power_milliwatts = device.derived_power_mw;
+                info.power_sampled_at = now;
+            }
+        }
+
+        infos.push_back(info);
+    }
+#else
+    (void)infos;
+    (void)first_index;
+#endif
+}